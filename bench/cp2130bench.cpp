@@ -0,0 +1,527 @@
+/* CP2130 benchmark - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Measures the throughput and the per-call latency of the SPI and control paths of the CP2130 class
+// By default, the simulated CP2130 is used, so that no device is required, but a real device can be used instead with "--device"
+// When simulating, a 25-series SPI NOR flash is also attached to channel 1, so that the throughput of CP2130Flash is measured too (this is skipped with a real device, since it would erase and program whatever is attached)
+// Results are printed one per line, either as JSON objects (default) or as CSV, so that different runs can be compared by other tools
+//
+// Build example (from the root of the repository):
+//     g++ -std=c++11 -O2 -I. bench/cp2130bench.cpp cp2130.cpp cp2130bufferpool.cpp cp2130deviceindex.cpp cp2130errorlog.cpp cp2130filestream.cpp cp2130flash.cpp cp2130simulator.cpp cp2130snapshot.cpp cp2130supervisor.cpp libusb-extra.c -lusb-1.0 -lpthread -o cp2130bench
+//
+// Usage:
+//     cp2130bench [--device VID PID [SERIAL]] [--latency US] [--bandwidth BPS] [--time MS] [--max-size BYTES] [--csv]
+
+// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "cp2130.h"
+#include "cp2130filestream.h"
+#include "cp2130flash.h"
+#include "cp2130simulator.h"
+#include "cp2130snapshot.h"
+
+// Definitions
+const unsigned int LATENCY_DEFAULT = 1000;        // Default latency of the simulated device, in microseconds (one USB full-speed frame)
+const unsigned long BANDWIDTH_DEFAULT = 1216000;  // Default bandwidth of the simulated device, in bytes per second (19 bulk packets per USB full-speed frame)
+const unsigned int TIME_DEFAULT = 500;            // Default time spent measuring each case, in milliseconds
+const size_t MAX_SIZE_DEFAULT = 1048576;          // Default largest payload size, in bytes
+const size_t MIN_ITERATIONS = 5;                  // Minimum number of calls measured for each case
+const size_t MAX_ITERATIONS = 100000;             // Maximum number of calls measured for each case
+const uint8_t FLASH_CHANNEL = 1;                  // Channel of the simulated flash
+const size_t FLASH_SIZE = 1048576;                // Capacity of the simulated flash, in bytes
+const size_t FLASH_PAGE = 256;                    // Page size of the simulated flash, in bytes
+const size_t FLASH_SECTOR = 4096;                 // Sector size of the simulated flash, in bytes
+const unsigned int FLASH_PROGRAM_TIME = 700;      // Page program time of the simulated flash, in microseconds
+const unsigned int FLASH_ERASE_TIME = 45000;      // Sector erase time of the simulated flash, in microseconds
+
+struct Options {
+    bool device;              // True if a real device is used
+    uint16_t vid, pid;        // VID and PID of the real device
+    std::string serial;       // Serial number of the real device
+    unsigned int latency;     // Latency of the simulated device, in microseconds
+    unsigned long bandwidth;  // Bandwidth of the simulated device, in bytes per second
+    unsigned int time;        // Time spent measuring each case, in milliseconds
+    size_t maxSize;           // Largest payload size, in bytes
+    bool csv;                 // True if the output is in CSV format
+};
+
+// Simulated 25-series SPI NOR flash, which answers the instructions used by CP2130Flash, taking typical times to program and erase
+// Other channels are looped back, as the simulated CP2130 does when no slave is set
+class FlashSlave : public CP2130Simulator::Slave
+{
+private:
+    std::vector<uint8_t> memory_, sfdp_, page_;
+    uint8_t opcode_;
+    size_t position_;   // Position of the next byte within the current transaction
+    uint32_t address_;
+    bool wel_;          // Write enable latch
+    std::chrono::steady_clock::time_point busyUntil_;
+
+public:
+    FlashSlave() :
+        memory_(FLASH_SIZE, 0xff),
+        sfdp_(0x50, 0xff),
+        page_(FLASH_PAGE),
+        opcode_(0x00),
+        position_(0),
+        address_(0),
+        wel_(false)
+    {
+        const uint8_t header[16] = {
+            'S', 'F', 'D', 'P', 0x06, 0x01, 0x00, 0xff,  // Signature, revision 1.6, one parameter header
+            0x00, 0x06, 0x01, 0x10, 0x10, 0x00, 0x00, 0xff  // Basic flash parameter table, 16 DWORDs long, at address 0x10
+        };
+        const uint32_t table[16] = {
+            0x000020e5,                                 // 4KiB erase via 0x20, and 3-byte addresses only
+            static_cast<uint32_t>(8 * FLASH_SIZE - 1),  // Density in bits, minus one
+            0, 0, 0, 0, 0,
+            0x0000200c,                                 // Erase type 1 is 4KiB via 0x20
+            0, 0,
+            0x00000080,                                 // 256-byte pages
+            0, 0, 0, 0, 0
+        };
+        std::copy(header, header + sizeof(header), sfdp_.begin());
+        for (size_t i = 0; i < 16; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                sfdp_[sizeof(header) + 4 * i + j] = static_cast<uint8_t>(table[i] >> 8 * j);
+            }
+        }
+    }
+
+    void begin(uint8_t channel)
+    {
+        if (channel == FLASH_CHANNEL) {
+            position_ = 0;
+            address_ = 0;
+            std::fill(page_.begin(), page_.end(), 0xff);
+        }
+    }
+
+    void end(uint8_t channel)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (channel == FLASH_CHANNEL && position_ > 0 && now >= busyUntil_) {  // Instructions other than Read Status Register are ignored while busy
+            if (opcode_ == CP2130Flash::WREN) {
+                wel_ = true;
+            } else if (opcode_ == CP2130Flash::PP && wel_ && position_ > 4) {
+                uint32_t base = address_ & ~static_cast<uint32_t>(FLASH_PAGE - 1);
+                for (size_t i = 0; i < FLASH_PAGE; ++i) {
+                    memory_[(base + i) % FLASH_SIZE] &= page_[i];
+                }
+                busyUntil_ = now + std::chrono::microseconds(FLASH_PROGRAM_TIME);
+                wel_ = false;
+            } else if (opcode_ == CP2130Flash::SE && wel_ && position_ >= 4) {
+                std::fill_n(memory_.begin() + (address_ & ~static_cast<uint32_t>(FLASH_SECTOR - 1)) % FLASH_SIZE, FLASH_SECTOR, 0xff);
+                busyUntil_ = now + std::chrono::microseconds(FLASH_ERASE_TIME);
+                wel_ = false;
+            }
+        }
+    }
+
+    void transfer(uint8_t channel, const uint8_t *mosi, uint8_t *miso, size_t length)
+    {
+        if (channel != FLASH_CHANNEL) {
+            std::memcpy(miso, mosi, length);
+        } else {
+            bool busy = std::chrono::steady_clock::now() < busyUntil_;
+            for (size_t i = 0; i < length; ++i, ++position_) {
+                uint8_t out = 0xff;
+                if (position_ == 0) {
+                    opcode_ = mosi[i];
+                } else if (opcode_ == CP2130Flash::RDSR) {
+                    out = static_cast<uint8_t>((busy ? CP2130Flash::SRWIP : 0x00) | (wel_ ? CP2130Flash::SRWEL : 0x00));
+                } else if (opcode_ == CP2130Flash::RDID && position_ <= 3) {
+                    const uint8_t id[3] = {0xef, 0x40, 0x14};
+                    out = id[position_ - 1];
+                } else if (position_ <= 3) {  // Address
+                    address_ = address_ << 8 | mosi[i];
+                } else if (opcode_ == CP2130Flash::PP) {
+                    page_[(address_ + position_ - 4) % FLASH_PAGE] = mosi[i];
+                } else if (position_ >= 5 && opcode_ == CP2130Flash::FASTREAD && !busy) {
+                    out = memory_[(address_ + position_ - 5) % FLASH_SIZE];
+                } else if (position_ >= 5 && opcode_ == CP2130Flash::RDSFDP) {
+                    out = sfdp_[(address_ + position_ - 5) % sfdp_.size()];
+                }
+                miso[i] = out;
+            }
+        }
+    }
+};
+
+struct Result {
+    std::string op;         // Measured function
+    std::string variant;    // Overload or argument variant
+    size_t size;            // Payload size, in bytes
+    size_t iterations;      // Number of calls measured
+    size_t errors;          // Number of calls that failed
+    double bytesPerSecond;  // Throughput
+    double p50, p99, p999;  // Latency percentiles, in microseconds
+};
+
+// Returns the given percentile of a sorted set of samples
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Calls the given function repeatedly, for the given time, and gathers the results
+static Result measure(const std::string &op, const std::string &variant, size_t size, unsigned int time, const std::function<bool()> &call)
+{
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> samples;
+    size_t errors = 0;
+    Clock::time_point start = Clock::now(), deadline = start + std::chrono::milliseconds(time);
+    while (samples.size() < MAX_ITERATIONS && (samples.size() < MIN_ITERATIONS || Clock::now() < deadline)) {
+        Clock::time_point before = Clock::now();
+        if (!call()) {
+            ++errors;
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - before).count());
+    }
+    double total = 0.0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        total += samples[i];
+    }
+    std::sort(samples.begin(), samples.end());
+    Result result;
+    result.op = op;
+    result.variant = variant;
+    result.size = size;
+    result.iterations = samples.size();
+    result.errors = errors;
+    result.bytesPerSecond = total > 0.0 ? static_cast<double>(size) * static_cast<double>(samples.size()) * 1e6 / total : 0.0;
+    result.p50 = percentile(samples, 0.5);
+    result.p99 = percentile(samples, 0.99);
+    result.p999 = percentile(samples, 0.999);
+    return result;
+}
+
+// Prints a result, either as a JSON object or as a CSV record
+static void print(const Result &result, bool csv)
+{
+    if (csv) {
+        std::printf("%s,%s,%zu,%zu,%zu,%.0f,%.1f,%.1f,%.1f\n", result.op.c_str(), result.variant.c_str(), result.size, result.iterations, result.errors, result.bytesPerSecond, result.p50, result.p99, result.p999);
+    } else {
+        std::printf("{\"op\":\"%s\",\"variant\":\"%s\",\"size\":%zu,\"iterations\":%zu,\"errors\":%zu,\"bytes_per_s\":%.0f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f}\n", result.op.c_str(), result.variant.c_str(), result.size, result.iterations, result.errors, result.bytesPerSecond, result.p50, result.p99, result.p999);
+    }
+    std::fflush(stdout);
+}
+
+// Parses the command line arguments, returning false if they are invalid
+static bool parse(int argc, char **argv, Options &options)
+{
+    bool valid = true;
+    for (int i = 1; valid && i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--device" && i + 2 < argc) {
+            options.device = true;
+            options.vid = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 16));
+            options.pid = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 16));
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.serial = argv[++i];
+            }
+        } else if (arg == "--latency" && i + 1 < argc) {
+            options.latency = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--bandwidth" && i + 1 < argc) {
+            options.bandwidth = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--time" && i + 1 < argc) {
+            options.time = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-size" && i + 1 < argc) {
+            options.maxSize = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else {
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+int main(int argc, char **argv)
+{
+    Options options = {false, 0x10c4, 0x87a0, std::string(), LATENCY_DEFAULT, BANDWIDTH_DEFAULT, TIME_DEFAULT, MAX_SIZE_DEFAULT, false};
+    if (!parse(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--device VID PID [SERIAL]] [--latency US] [--bandwidth BPS] [--time MS] [--max-size BYTES] [--csv]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    CP2130Simulator simulator;
+    FlashSlave flashSlave;  // Loops MOSI back to MISO on every channel but the one of the flash
+    simulator.setSlave(&flashSlave);
+    simulator.setLatency(options.latency);
+    simulator.setBandwidth(options.bandwidth);
+    CP2130 device;
+    int status = options.device ? device.open(options.vid, options.pid, options.serial) : device.open(simulator);
+    if (status != CP2130::SUCCESS) {
+        std::fprintf(stderr, "Could not open the device (error %d).\n", status);
+        return EXIT_FAILURE;
+    }
+    int errcnt = 0;
+    std::string errstr;
+    uint8_t endpointInAddr = device.getEndpointInAddr(errcnt, errstr);
+    uint8_t endpointOutAddr = device.getEndpointOutAddr(errcnt, errstr);
+    device.selectCS(0, errcnt, errstr);
+    if (errcnt > 0) {
+        std::fprintf(stderr, "%s", errstr.c_str());
+        return EXIT_FAILURE;
+    }
+    if (options.csv) {
+        std::printf("op,variant,size,iterations,errors,bytes_per_s,p50_us,p99_us,p999_us\n");
+    }
+    for (size_t size = 1; size <= options.maxSize; size *= 4) {  // Payload sizes from 1B to 1MiB, in steps of four
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>(i);
+        }
+        print(measure("spiRead", "explicit", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiRead(static_cast<uint32_t>(size), endpointInAddr, endpointOutAddr, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("spiRead", "auto", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiRead(static_cast<uint32_t>(size), errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("spiWrite", "explicit", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiWrite(data, endpointOutAddr, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("spiWrite", "auto", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiWrite(data, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("spiWriteRead", "explicit", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiWriteRead(data, endpointInAddr, endpointOutAddr, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("spiWriteRead", "auto", size, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiWriteRead(data, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+    }
+    for (size_t chunk = CP2130::WRITEREAD_CHUNK_DEFAULT; chunk <= CP2130::WRITEREAD_CHUNK_MAX; chunk = 2 * chunk + CP2130::CMD_HEADER_SIZE) {  // Chunk sizes that fill 1, 2, 4 and so on packets
+        std::vector<uint8_t> data(std::min<size_t>(options.maxSize, 0x10000));
+        device.setWriteReadChunk(chunk);
+        print(measure("spiWriteRead", "chunk" + std::to_string(chunk), data.size(), options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.spiWriteRead(data, endpointInAddr, endpointOutAddr, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+    }
+    device.setWriteReadChunk(CP2130::WRITEREAD_CHUNK_DEFAULT);
+    {
+        CP2130FileStream stream(device);
+        std::FILE *file = std::tmpfile();
+        int fd = file == nullptr ? -1 : fileno(file);
+        for (size_t size = CP2130FileStream::TRANSFER_SIZE; fd >= 0 && size <= options.maxSize; size *= 4) {  // Streamed transfers, which are only worthwhile for larger payloads
+            std::vector<uint8_t> data(size);
+            print(measure("spiRead", "file", size, options.time, [&]() {
+                int errcnt = 0;
+                std::string errstr;
+                lseek(fd, 0, SEEK_SET);
+                stream.readToFile(fd, static_cast<uint32_t>(size), errcnt, errstr);
+                return errcnt == 0;
+            }), options.csv);
+            print(measure("spiWrite", "file", size, options.time, [&]() {  // The file holds "size" bytes, as written by the case above
+                int errcnt = 0;
+                std::string errstr;
+                lseek(fd, 0, SEEK_SET);
+                stream.writeFromFile(fd, static_cast<uint32_t>(size), errcnt, errstr);
+                return errcnt == 0;
+            }), options.csv);
+            print(measure("spiWrite", "memory", size, options.time, [&]() {
+                int errcnt = 0;
+                std::string errstr;
+                stream.writeFromMemory(data.data(), static_cast<uint32_t>(size), errcnt, errstr);
+                return errcnt == 0;
+            }), options.csv);
+        }
+        if (file != nullptr) {
+            std::fclose(file);
+        }
+    }
+    print(measure("getGPIOs", "", CP2130::GET_GPIO_VALUES_WLEN, options.time, [&]() {
+        int errcnt = 0;
+        std::string errstr;
+        device.getGPIOs(errcnt, errstr);
+        return errcnt == 0;
+    }), options.csv);
+    print(measure("setGPIOs", "", CP2130::SET_GPIO_VALUES_WLEN, options.time, [&]() {
+        int errcnt = 0;
+        std::string errstr;
+        device.setGPIOs(CP2130::BMGPIOS, CP2130::BMGPIO1, errcnt, errstr);
+        return errcnt == 0;
+    }), options.csv);
+    print(measure("getSPIMode", "", CP2130::GET_SPI_WORD_WLEN, options.time, [&]() {
+        int errcnt = 0;
+        std::string errstr;
+        device.getSPIMode(0, errcnt, errstr);
+        return errcnt == 0;
+    }), options.csv);
+    print(measure("getTransferPriority", "", CP2130::GET_USB_CONFIG_WLEN, options.time, [&]() {
+        int errcnt = 0;
+        std::string errstr;
+        device.getTransferPriority(errcnt, errstr);
+        return errcnt == 0;
+    }), options.csv);
+    print(measure("captureState", "sequential", 0, options.time, [&]() {  // The same state as captured by CP2130Snapshot, obtained using the blocking getters
+        int errcnt = 0;
+        std::string errstr;
+        device.getUSBConfig(errcnt, errstr);
+        device.getPinConfig(errcnt, errstr);
+        device.getPROMConfig(errcnt, errstr);
+        device.getManufacturerDesc(errcnt, errstr);
+        device.getProductDesc(errcnt, errstr);
+        device.getSerialDesc(errcnt, errstr);
+        device.getLockWord(errcnt, errstr);
+        for (uint8_t channel = 0; channel < 11; ++channel) {
+            device.getSPIMode(channel, errcnt, errstr);
+            device.getSPIDelays(channel, errcnt, errstr);
+        }
+        device.getCS(0, errcnt, errstr);
+        device.getClockDivider(errcnt, errstr);
+        device.getFIFOThreshold(errcnt, errstr);
+        device.getEventCounter(errcnt, errstr);
+        return errcnt == 0;
+    }), options.csv);
+    {
+        CP2130Snapshot snapshot(device);
+        print(measure("captureState", "snapshot", 0, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            snapshot.capture(errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+    }
+    for (int shadow = 0; shadow < 2; ++shadow) {  // Setters are measured with and without the shadow, which skips redundant requests
+        device.setShadowEnabled(shadow != 0);
+        const char *variant = shadow != 0 ? "shadow" : "direct";
+        CP2130::SPIMode mode = {CP2130::CSMODEPP, CP2130::CFRQ12M, CP2130::CPOL0, CP2130::CPHA0};
+        print(measure("configureSPIMode", variant, CP2130::SET_SPI_WORD_WLEN, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.configureSPIMode(0, mode, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("selectCS", variant, CP2130::SET_GPIO_CHIP_SELECT_WLEN, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            device.selectCS(0, errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+    }
+    if (!options.device) {
+        CP2130Flash flash(device, FLASH_CHANNEL);
+        CP2130::SPIMode mode = {CP2130::CSMODEPP, CP2130::CFRQ12M, CP2130::CPOL0, CP2130::CPHA0};
+        device.configureSPIMode(FLASH_CHANNEL, mode, errcnt, errstr);
+        flash.probe(errcnt, errstr);
+        if (errcnt > 0) {
+            std::fprintf(stderr, "%s", errstr.c_str());
+            return EXIT_FAILURE;
+        }
+        std::vector<uint8_t> buffer(FLASH_SIZE), page(FLASH_PAGE, 0x5a);
+        print(measure("flashReadJEDECID", "", 3, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            flash.readJEDECID(errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("flashReadStatus", "", 1, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            flash.readStatus(errcnt, errstr);
+            return errcnt == 0;
+        }), options.csv);
+        for (size_t size = FLASH_SECTOR; size <= std::min(options.maxSize, FLASH_SIZE); size *= 16) {
+            print(measure("flashRead", "fastread", size, options.time, [&]() {
+                int errcnt = 0;
+                std::string errstr;
+                flash.read(0x000000, buffer.data(), size, errcnt, errstr);
+                return errcnt == 0;
+            }), options.csv);
+        }
+        print(measure("flashRead", "writeread", FLASH_SECTOR, options.time, [&]() {  // Baseline, where each WriteRead command carries its own Fast Read instruction
+            int errcnt = 0;
+            std::string errstr;
+            uint8_t dataOut[56] = {CP2130Flash::FASTREAD}, dataIn[56];
+            for (size_t offset = 0; offset < FLASH_SECTOR && errcnt == 0; offset += 51) {
+                size_t chunk = std::min<size_t>(51, FLASH_SECTOR - offset);
+                dataOut[1] = static_cast<uint8_t>(offset >> 16);
+                dataOut[2] = static_cast<uint8_t>(offset >> 8);
+                dataOut[3] = static_cast<uint8_t>(offset);
+                device.spiWriteRead(dataOut, dataIn, 5 + chunk, errcnt, errstr);
+                std::memcpy(buffer.data() + offset, dataIn + 5, chunk);
+            }
+            return errcnt == 0;
+        }), options.csv);
+        uint32_t address = 0;
+        print(measure("flashProgram", "batched", FLASH_PAGE, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            flash.program(address, page, errcnt, errstr);
+            address = static_cast<uint32_t>((address + FLASH_PAGE) % FLASH_SIZE);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("flashProgram", "sequential", FLASH_PAGE, options.time, [&]() {  // Baseline, where each instruction and each status poll costs a round trip
+            int errcnt = 0;
+            std::string errstr;
+            device.selectCS(FLASH_CHANNEL, errcnt, errstr);
+            device.spiWrite(std::vector<uint8_t>{CP2130Flash::WREN}, errcnt, errstr);
+            std::vector<uint8_t> instruction = {CP2130Flash::PP, static_cast<uint8_t>(address >> 16), static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address)};
+            instruction.insert(instruction.end(), page.begin(), page.end());
+            device.spiWrite(instruction, errcnt, errstr);
+            std::vector<uint8_t> rdsr = {CP2130Flash::RDSR, 0x00}, status;
+            do {
+                status = device.spiWriteRead(rdsr, errcnt, errstr);
+            } while (errcnt == 0 && status.size() == 2 && (CP2130Flash::SRWIP & status[1]) != 0x00);
+            address = static_cast<uint32_t>((address + FLASH_PAGE) % FLASH_SIZE);
+            return errcnt == 0;
+        }), options.csv);
+        print(measure("flashEraseSector", "", FLASH_SECTOR, options.time, [&]() {
+            int errcnt = 0;
+            std::string errstr;
+            flash.eraseSector(address, errcnt, errstr);
+            address = static_cast<uint32_t>((address + FLASH_SECTOR) % FLASH_SIZE);
+            return errcnt == 0;
+        }), options.csv);
+    }
+    device.close();
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,5 @@
-/* CP2130 class - Version 1.2.6
-   Copyright (c) 2021-2024 Samuel Lourenço
+/* CP2130 class - Version 1.3.0
+   Copyright (c) 2021-2026 Samuel Lourenço
 
    This library is free software: you can redistribute it and/or modify it
    under the terms of the GNU Lesser General Public License as published by
@@ -19,50 +19,516 @@
 
 
 // Includes
+#include <algorithm>
+#include <chrono>
 #include <cstring>
-#include <iomanip>
-#include <sstream>
+#include <thread>
 #include "cp2130.h"
+#include "cp2130deviceindex.h"
+#include "cp2130supervisor.h"
+#include "cp2130transport.h"
 extern "C" {
 #include "libusb-extra.h"
 }
 
-// Definitions
-const unsigned int TR_TIMEOUT = 500;  // Transfer timeout in milliseconds
-
-// Specific to getDescGeneric() and writeDescGeneric() (added in version 1.1.0)
+// Specific to getDescGeneric() and writeDescGeneric() (added in version 1.1.0), and also to decodeDesc() (since version 1.3.0)
 const uint16_t DESC_TBLSIZE = 0x0040;          // Descriptor table size, including preamble [64]
 const size_t DESC_MAXIDX = DESC_TBLSIZE - 2;   // Maximum usable index [62]
 const size_t DESC_IDXINCR = DESC_TBLSIZE - 1;  // Index increment or step between table preambles [63]
 
+// Specific to runPipeline() and the functions that use it (added in version 1.3.0)
+const size_t PIPELINE_DEPTH_MAX = CP2130::QDEPTH_MAX + 1;            // Maximum number of transfers in flight, including the read command issued by spiRead()
+
+// Specific to bulkPacketSize(), calibrateWriteReadChunk() and deriveWriteReadChunk() (added in version 1.3.0)
+const size_t BULK_PACKET_SIZE = 64;   // Maximum packet size of the bulk endpoints of the CP2130, which is assumed for devices opened via a transport
+const size_t CALIBRATION_CHUNKS = 8;  // Number of WriteRead commands issued for each chunk size tried, so that the pipeline of spiWriteRead() is kept full
+
+// Specific to requestStats() and the instrumentation counters (added in version 1.3.0)
+const uint8_t REQUEST_CODES[] = {  // Request codes of the CP2130, each having its own counters, in ascending order
+    CP2130::RESET_DEVICE, CP2130::GET_READONLY_VERSION,
+    CP2130::GET_GPIO_VALUES, CP2130::SET_GPIO_VALUES, CP2130::GET_GPIO_MODE_AND_LEVEL, CP2130::SET_GPIO_MODE_AND_LEVEL, CP2130::GET_GPIO_CHIP_SELECT, CP2130::SET_GPIO_CHIP_SELECT,
+    CP2130::GET_SPI_WORD, CP2130::SET_SPI_WORD, CP2130::GET_SPI_DELAY, CP2130::SET_SPI_DELAY, CP2130::GET_FULL_THRESHOLD, CP2130::SET_FULL_THRESHOLD, CP2130::GET_RTR_STATE, CP2130::SET_RTR_STOP,
+    CP2130::GET_EVENT_COUNTER, CP2130::SET_EVENT_COUNTER, CP2130::GET_CLOCK_DIVIDER, CP2130::SET_CLOCK_DIVIDER,
+    CP2130::GET_USB_CONFIG, CP2130::SET_USB_CONFIG, CP2130::GET_MANUFACTURING_STRING_1, CP2130::SET_MANUFACTURING_STRING_1, CP2130::GET_MANUFACTURING_STRING_2, CP2130::SET_MANUFACTURING_STRING_2,
+    CP2130::GET_PRODUCT_STRING_1, CP2130::SET_PRODUCT_STRING_1, CP2130::GET_PRODUCT_STRING_2, CP2130::SET_PRODUCT_STRING_2, CP2130::GET_SERIAL_STRING, CP2130::SET_SERIAL_STRING,
+    CP2130::GET_PIN_CONFIG, CP2130::SET_PIN_CONFIG, CP2130::GET_LOCK_BYTE, CP2130::SET_LOCK_BYTE, CP2130::GET_PROM_CONFIG, CP2130::SET_PROM_CONFIG
+};
+
+// Specific to resume() (added in version 1.3.0)
+const unsigned int RESUME_RETRY_INTERVAL = 50;  // Interval in milliseconds between attempts to reopen a supervised device
+
+// Specific to setGPIOs() and the shadow (added in version 1.3.0)
+const uint16_t GPIO_BITMAPS[11] = {  // Bitmap of each GPIO pin, indexed by pin number
+    CP2130::BMGPIO0, CP2130::BMGPIO1, CP2130::BMGPIO2, CP2130::BMGPIO3, CP2130::BMGPIO4, CP2130::BMGPIO5,
+    CP2130::BMGPIO6, CP2130::BMGPIO7, CP2130::BMGPIO8, CP2130::BMGPIO9, CP2130::BMGPIO10
+};
+
+// Private structure that links each libusb transfer to its pipeline (added in version 1.3.0)
+struct Pipeline;
+struct PipelineSlot {
+    Pipeline *pipeline;
+    size_t index;
+    size_t segment;  // Index of the segment carried by the transfer
+    int *transferred;
+    bool inflight;
+    std::chrono::steady_clock::time_point submitted, finished;  // Used by the instrumentation
+};
+
+// Private structure used to track an ongoing pipeline (added in version 1.3.0)
+// Fixed-size arrays are used, so that running a pipeline does not allocate memory
+struct Pipeline {
+    PipelineSlot slots[PIPELINE_DEPTH_MAX];
+    size_t freeSlots[PIPELINE_DEPTH_MAX];  // Indexes of the transfers that are not in flight
+    size_t nfree;                          // Number of transfers that are not in flight
+    size_t doneSlots[PIPELINE_DEPTH_MAX];  // Indexes of the transfers that completed since the last time the instrumentation was updated
+    size_t ndone;                          // Number of such transfers
+    size_t inflight;                       // Number of transfers in flight
+    int completed;                         // Set by pipelineCallback() whenever a transfer completes
+    int result;                            // Result of the first failed transfer, as a libusb error code
+    uint8_t failedEndpointAddr;            // Endpoint of the first failed transfer
+    bool failed;                           // True if any transfer has failed
+};
+
+// Private function that returns the index of the instrumentation counters of a given endpoint (added in version 1.3.0)
+static size_t endpointIndex(uint8_t endpointAddr)
+{
+    return (0x80 & endpointAddr) != 0x00 ? 1 : 0;  // Counters are kept per direction
+}
+
+// Private function that returns the index of the instrumentation counters of a given control request (added in version 1.3.0)
+static size_t requestIndex(uint8_t bRequest)
+{
+    const uint8_t *end = REQUEST_CODES + sizeof(REQUEST_CODES);
+    const uint8_t *code = std::lower_bound(REQUEST_CODES, end, bRequest);
+    return code != end && *code == bRequest ? static_cast<size_t>(code - REQUEST_CODES) : sizeof(REQUEST_CODES);  // Any other request code maps to the last slot
+}
+
+// Private function that returns true if a given control request writes to the OTP ROM, in which case it must never be issued twice (added in version 1.3.0)
+// These are the set requests from Set_USB_Config to Set_PROM_Config, which all have odd request codes
+static bool writesOTP(uint8_t bmRequestType, uint8_t bRequest)
+{
+    return bmRequestType == CP2130::SET && bRequest >= CP2130::SET_USB_CONFIG && bRequest <= CP2130::SET_PROM_CONFIG && (0x01 & bRequest) != 0x00;
+}
+
+// Private function that takes a snapshot of a set of instrumentation counters (added in version 1.3.0)
+// This is a template only so that the private type of the counters does not have to be named here
+template <typename C>
+static CP2130::TransferStats snapshot(const C &counters)
+{
+    CP2130::TransferStats stats;
+    stats.calls = counters.calls.load(std::memory_order_relaxed);
+    stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+    stats.shortTransfers = counters.shortTransfers.load(std::memory_order_relaxed);
+    stats.timeouts = counters.timeouts.load(std::memory_order_relaxed);
+    stats.disconnects = counters.disconnects.load(std::memory_order_relaxed);
+    stats.errors = counters.errors.load(std::memory_order_relaxed);
+    stats.totalLatency = counters.totalLatency.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < CP2130::STATS_BUCKETS; ++i) {
+        stats.histogram[i] = counters.histogram[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+// Private callback that is called by libusb whenever a pipelined transfer completes (added in version 1.3.0)
+static void LIBUSB_CALL pipelineCallback(libusb_transfer *transfer)
+{
+    PipelineSlot *slot = static_cast<PipelineSlot *>(transfer->user_data);
+    Pipeline *pipeline = slot->pipeline;
+    *slot->transferred = transfer->actual_length;
+    if (!pipeline->failed && (transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != transfer->length)) {  // Only the first failure is recorded, since the ones that follow are usually caused by it
+        pipeline->failed = true;
+        pipeline->result = CP2130::transferResult(transfer->status);
+        pipeline->failedEndpointAddr = transfer->endpoint;
+    }
+    slot->inflight = false;
+    slot->finished = std::chrono::steady_clock::now();
+    pipeline->doneSlots[pipeline->ndone++] = slot->index;
+    pipeline->freeSlots[pipeline->nfree++] = slot->index;
+    --pipeline->inflight;
+    pipeline->completed = 1;
+}
+
+// Private function that returns the maximum packet size of the bulk endpoints, or the smaller of the two if they differ (added in version 1.3.0)
+// The size is obtained from the endpoint descriptors, except for devices opened via a transport, which are assumed to have 64-byte endpoints, as the CP2130 has
+size_t CP2130::bulkPacketSize(int &errcnt, std::string &errstr)
+{
+    size_t packetSize = BULK_PACKET_SIZE;
+    if (!isOpen()) {
+        ++errcnt;
+        errstr += "In bulkPacketSize(): device is not open.\n";  // Program logic error
+    } else if (transport_ == nullptr) {
+        libusb_device *device = libusb_get_device(handle_);
+        int packetSizeIn = libusb_get_max_packet_size(device, getEndpointInAddr(errcnt, errstr));
+        int packetSizeOut = libusb_get_max_packet_size(device, getEndpointOutAddr(errcnt, errstr));
+        if (packetSizeIn <= 0 || packetSizeOut <= 0) {
+            ++errcnt;
+            errstr += "In bulkPacketSize(): failed to obtain the maximum packet size of the bulk endpoints.\n";
+        } else {
+            packetSize = static_cast<size_t>(std::min(packetSizeIn, packetSizeOut));
+        }
+    }
+    return packetSize;
+}
+
+// Private procedure used to report a failed bulk transfer (added as a refactor in version 1.3.0)
+// The failure is always logged, but the message is only formatted into "errstr" if that is enabled (see setErrstrEnabled())
+void CP2130::bulkTransferFailed(uint8_t endpointAddr, int result, int &errcnt, std::string &errstr)
+{
+    ++errcnt;
+    CP2130ErrorLog::Record record = {
+        endpointAddr < 0x80 ? CP2130ErrorLog::BULK_OUT : CP2130ErrorLog::BULK_IN,
+        result,
+        endpointAddr,
+        0x00, 0x00,  // Not applicable to bulk transfers
+        std::chrono::system_clock::now()
+    };
+    errorLog_.log(record);
+    if (errstrEnabled_) {
+        errstr += CP2130ErrorLog::format(record);
+    }
+    if (result == LIBUSB_ERROR_NO_DEVICE || result == LIBUSB_ERROR_IO) {  // Note that libusb_bulk_transfer() may return "LIBUSB_ERROR_IO" [-1] on device disconnect
+        markDisconnected();  // Refactored in version 1.3.0
+    }
+}
+
+// Private function used to claim the interface of a device whose handle was just obtained, returning "SUCCESS" or "ERROR_BUSY" (added as a refactor in version 1.3.0)
+// In case of failure, the handle is closed
+int CP2130::claimInterface()
+{
+    int retval;
+    if (libusb_kernel_driver_active(handle_, 0) == 1) {  // If a kernel driver is active on the interface
+        libusb_detach_kernel_driver(handle_, 0);  // Detach the kernel driver
+        kernelWasAttached_ = true;  // Flag that the kernel driver was attached
+    } else {
+        kernelWasAttached_ = false;  // The kernel driver was not attached
+    }
+    if (libusb_claim_interface(handle_, 0) != 0) {  // Claim the interface. In case of failure
+        if (kernelWasAttached_) {  // If a kernel driver was attached to the interface before
+            libusb_attach_kernel_driver(handle_, 0);  // Reattach the kernel driver
+        }
+        libusb_close(handle_);  // Close the device
+        handle_ = nullptr;  // Required to mark the device as closed
+        retval = ERROR_BUSY;
+    } else {
+        disconnected_ = false;  // Note that this flag is never assumed to be true for a device that was never opened - See constructor for details!
+        int errcnt = 0;
+        std::string errstr;
+        refreshEndpoints(errcnt, errstr);  // Resolve the transfer priority once, so that the shorthand SPI functions do not have to
+        resetBufferPool(handle_);  // From now on, the command buffer is allocated in device memory, if supported (added in version 1.3.0)
+        retval = SUCCESS;
+    }
+    return retval;
+}
+
+// Private procedure used to report a failed control transfer (added as a refactor in version 1.3.0)
+// The failure is always logged, but the message is only formatted into "errstr" if that is enabled (see setErrstrEnabled())
+void CP2130::controlTransferFailed(uint8_t bmRequestType, uint8_t bRequest, int result, int &errcnt, std::string &errstr)
+{
+    ++errcnt;
+    CP2130ErrorLog::Record record = {
+        CP2130ErrorLog::CONTROL,
+        result,
+        0x00,  // Not applicable to control transfers
+        bmRequestType,
+        bRequest,
+        std::chrono::system_clock::now()
+    };
+    errorLog_.log(record);
+    if (errstrEnabled_) {
+        errstr += CP2130ErrorLog::format(record);
+    }
+    if (result == LIBUSB_ERROR_NO_DEVICE || result == LIBUSB_ERROR_IO || result == LIBUSB_ERROR_PIPE) {  // Note that libusb_control_transfer() may return "LIBUSB_ERROR_IO" [-1] or "LIBUSB_ERROR_PIPE" [-9] on device disconnect
+        markDisconnected();  // Refactored in version 1.3.0
+    }
+}
+
 // Private generic procedure used to get any descriptor (added as a refactor in version 1.1.0)
 std::u16string CP2130::getDescGeneric(uint8_t command, int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[DESC_TBLSIZE];
     controlTransfer(GET, command, 0x0000, 0x0000, controlBufferIn, DESC_TBLSIZE, errcnt, errstr);
-    std::u16string descriptor;
-    size_t length = controlBufferIn[0];
-    size_t end = length > DESC_MAXIDX ? DESC_MAXIDX : length;
-    for (size_t i = 2; i < end; i += 2) {  // Process first 30 characters (bytes 2-61 of the array)
-        if (controlBufferIn[i] != 0 || controlBufferIn[i + 1] != 0) {  // Filter out null characters
-            descriptor += static_cast<char16_t>(controlBufferIn[i + 1] << 8 | controlBufferIn[i]);  // UTF-16LE conversion as per the USB 2.0 specification
+    unsigned char nextControlBufferIn[DESC_TBLSIZE];
+    bool split = (command == GET_MANUFACTURING_STRING_1 || command == GET_PRODUCT_STRING_1) && controlBufferIn[0] > DESC_MAXIDX;  // True if the descriptor continues in the table that follows
+    if (split) {
+        controlTransfer(GET, command + 2, 0x0000, 0x0000, nextControlBufferIn, DESC_TBLSIZE, errcnt, errstr);
+    }
+    return decodeDesc(controlBufferIn, split ? nextControlBufferIn : nullptr);  // Decoding is shared with CP2130Snapshot since version 1.3.0
+}
+
+// Private procedure used to mark the device as disconnected (added as a refactor in version 1.3.0)
+// The shadow is set aside first, so that the state of the device can be restored if the device is supervised (see setSupervisor())
+void CP2130::markDisconnected()
+{
+    if (!disconnected_) {
+        restore_ = shadow_;
+        disconnected_ = true;  // This reports that the device has been disconnected
+    }
+    invalidateShadow();  // The state of a reconnected device is unknown
+}
+
+// Private procedure used to update the instrumentation counters after a transfer (added in version 1.3.0)
+// Relaxed atomic operations are used, so that the counters can be read from any thread without locks, at a negligible cost
+void CP2130::recordTransfer(Counters &counters, int length, int transferred, int result, std::chrono::steady_clock::duration latency)
+{
+    uint64_t microseconds = static_cast<uint64_t>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+    size_t bucket = 0;
+    while (bucket < STATS_BUCKETS - 1 && microseconds >> bucket != 0) {  // Bucket N holds latencies under 2^N microseconds
+        ++bucket;
+    }
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(static_cast<uint64_t>(std::max(0, transferred)), std::memory_order_relaxed);
+    counters.totalLatency.fetch_add(microseconds, std::memory_order_relaxed);
+    counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    if (result == LIBUSB_ERROR_TIMEOUT) {
+        counters.timeouts.fetch_add(1, std::memory_order_relaxed);
+    } else if (result == LIBUSB_ERROR_NO_DEVICE) {
+        counters.disconnects.fetch_add(1, std::memory_order_relaxed);
+    } else if (result < 0) {
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (transferred < length) {
+        counters.shortTransfers.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Private procedure used to resolve the transfer priority and cache both endpoint addresses accordingly (added in version 1.3.0)
+void CP2130::refreshEndpoints(int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    bool priowrite = getTransferPriority(errcnt, errstr) == PRIOWRITE;
+    endpointInAddr_ = priowrite ? 0x82 : 0x81;
+    endpointOutAddr_ = priowrite ? 0x01 : 0x02;
+    endpointsCached_ = errcnt == preverrcnt;  // The addresses are only cached if the transfer priority was successfully obtained
+}
+
+// Private function that returns the command buffer, after replacing it with a larger one from the buffer pool if it is smaller than the given size (added in version 1.3.0)
+// Since the buffer is kept between calls, this only allocates when a larger buffer is needed than ever before, and the replaced buffer is left in the pool for other uses
+// The buffer is given back when the device is closed, including when a supervised device is reopened, so a supervised device must be resumed before this is called
+unsigned char *CP2130::reserveCommandBuffer(size_t size)
+{
+    if (size > commandBufferSize_) {
+        bufferPool_.release(commandBuffer_);
+        commandBuffer_ = bufferPool_.acquire(size, true);  // Only the command buffer is placed in device memory, since it is given back before the handle is closed (see resetBufferPool())
+        commandBufferSize_ = size;
+    }
+    return commandBuffer_;
+}
+
+// Private procedure used to give the command buffer back to the buffer pool, and then to point the pool to the given device handle, or to the heap if the handle is null (added in version 1.3.0)
+// This must be done before the current handle is closed, since buffers in device memory are freed using it
+void CP2130::resetBufferPool(libusb_device_handle *handle)
+{
+    bufferPool_.release(commandBuffer_);
+    commandBuffer_ = nullptr;
+    commandBufferSize_ = 0;
+    bufferPool_.setHandle(handle);
+}
+
+// Private procedure used to restore the state kept in the given shadow, after the device is reopened (added in version 1.3.0)
+// The requests are issued via the shadow, so that the latter is filled again as they succeed
+void CP2130::restoreState(Shadow &state, int &errcnt, std::string &errstr)
+{
+    for (uint8_t i = 0; i < 11; ++i) {
+        if (state.gpioValid[i]) {
+            shadowedTransfer(SET_GPIO_MODE_AND_LEVEL, state.gpio[i], SET_GPIO_MODE_AND_LEVEL_WLEN, shadow_.gpio[i], shadow_.gpioValid[i], errcnt, errstr);
+        }
+        if (state.spiWordValid[i]) {
+            shadowedTransfer(SET_SPI_WORD, state.spiWord[i], SET_SPI_WORD_WLEN, shadow_.spiWord[i], shadow_.spiWordValid[i], errcnt, errstr);
+        }
+        if (state.spiDelayValid[i]) {
+            shadowedTransfer(SET_SPI_DELAY, state.spiDelay[i], SET_SPI_DELAY_WLEN, shadow_.spiDelay[i], shadow_.spiDelayValid[i], errcnt, errstr);
         }
     }
-    if ((command == GET_MANUFACTURING_STRING_1 || command == GET_PRODUCT_STRING_1) && length > DESC_MAXIDX) {
-        char16_t midchar = controlBufferIn[DESC_MAXIDX];  // Char in the middle (parted between two tables)
-        controlTransfer(GET, command + 2, 0x0000, 0x0000, controlBufferIn, DESC_TBLSIZE, errcnt, errstr);
-        midchar = static_cast<char16_t>(controlBufferIn[0] << 8 | midchar);  // Reconstruct the char in the middle
-        if (midchar != 0x0000) {  // Filter out the reconstructed char if the same is null
-            descriptor += midchar;
+    if (state.dividerValid) {
+        shadowedTransfer(SET_CLOCK_DIVIDER, state.divider, SET_CLOCK_DIVIDER_WLEN, shadow_.divider, shadow_.dividerValid, errcnt, errstr);
+    }
+    if (state.csValid) {
+        int preverrcnt = errcnt;
+        for (uint8_t i = 0; i < 11; ++i) {  // Each chip select is enabled or disabled, so that the resulting bitmap is the same
+            unsigned char controlBufferOut[SET_GPIO_CHIP_SELECT_WLEN] = {
+                i,                                             // Selected channel
+                static_cast<uint8_t>(0x0001 & state.cs >> i)  // Chip select control value (0x00 to disable, or 0x01 to enable)
+            };
+            controlTransfer(SET, SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, SET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
         }
-        end = length - DESC_IDXINCR;
-        for (size_t i = 1; i < end; i += 2) {  // Process remaining characters, up to 31 (bytes 1-62 of the array)
-            if (controlBufferIn[i] != 0 || controlBufferIn[i + 1] != 0) {  // Again, filter out null characters
-                descriptor += static_cast<char16_t>(controlBufferIn[i + 1] << 8 | controlBufferIn[i]);  // UTF-16LE conversion as per the USB 2.0 specification
+        shadow_.cs = state.cs;
+        shadow_.csValid = shadowEnabled_ && errcnt == preverrcnt;
+    }
+}
+
+// Private procedure used to wait for a supervised device to come back, and then to reopen it and restore its state (added in version 1.3.0)
+// Devices opened via a transport are never reopened, since only libusb devices can be found again
+void CP2130::resume(int &errcnt, std::string &errstr)
+{
+    if (transport_ != nullptr) {
+        ++errcnt;
+        errstr += "Could not reconnect to the device, since automatic reconnection is not supported by devices opened via a transport.\n";
+    } else {
+        resuming_ = true;  // Transfers issued while resuming must not try to resume again
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(supervisor_->timeout());
+        bool reopened = false;
+        while (!reopened && supervisor_->waitForDevice(deadline)) {
+            if (isOpen()) {
+                close();  // Release the stale handle
+            }
+            reopened = open(supervisor_->index(), supervisor_->serial()) == SUCCESS;
+            if (!reopened) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(RESUME_RETRY_INTERVAL));  // The device may still be listed for a while after being disconnected, or may not be ready yet
             }
         }
+        if (reopened) {
+            Shadow state = restore_;
+            restoreState(state, errcnt, errstr);
+        } else {
+            ++errcnt;
+            errstr += "Could not reconnect to the device.\n";
+        }
+        resuming_ = false;
+    }
+}
+
+// Private procedure used to run a sequence of bulk transfers asynchronously, keeping up to "depth" transfers in flight (added in version 1.3.0)
+// Transfers are submitted in the given order, which libusb preserves for each endpoint, and the procedure stops submitting at the first failure
+// A segment is only submitted while it lies within "depth" segments of the oldest one in flight, so that transfers on one endpoint cannot run ahead of a stalled transfer on the other
+// Since the timeout is measured from the last completed transfer, the duration of the whole sequence is not limited by "TR_TIMEOUT"
+void CP2130::runPipeline(BulkSegment *segments, size_t count, size_t depth, int &errcnt, std::string &errstr)
+{
+    if (disconnected_ && supervisor_ != nullptr && !resuming_) {  // If the device is supervised, the pipeline is paused until the device is back (added in version 1.3.0)
+        resume(errcnt, errstr);
+    }
+    if (!isOpen()) {
+        ++errcnt;
+        errstr += "In runPipeline(): device is not open.\n";  // Program logic error
+    } else if (count > 0) {
+        lockEvents();  // The callbacks change the state of the pipeline, so they must not be called by a background thread while it runs (added in version 1.3.0)
+        depth = std::max<size_t>(1, std::min(std::min(depth, count), PIPELINE_DEPTH_MAX));
+        while (transfers_.size() < depth) {  // Transfers are allocated once and reused by subsequent calls
+            libusb_transfer *transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr) {  // If allocation fails, the pipeline is simply shallower
+                break;
+            }
+            transfers_.push_back(transfer);
+        }
+        depth = std::min(depth, transfers_.size());
+        Pipeline pipeline;
+        pipeline.nfree = 0;
+        pipeline.ndone = 0;
+        pipeline.inflight = 0;
+        pipeline.completed = 0;
+        pipeline.result = 0;
+        pipeline.failedEndpointAddr = segments[0].endpointAddr;
+        pipeline.failed = false;
+        for (size_t i = depth; i > 0; --i) {
+            pipeline.slots[i - 1].pipeline = &pipeline;
+            pipeline.slots[i - 1].index = i - 1;
+            pipeline.slots[i - 1].inflight = false;
+            pipeline.freeSlots[pipeline.nfree++] = i - 1;
+        }
+        if (depth == 0) {
+            ++errcnt;
+            errstr += "In runPipeline(): could not allocate transfers.\n";
+        } else {
+            size_t next = 0;
+            bool cancelled = false, reported = false;
+            std::chrono::steady_clock::time_point lastProgress = std::chrono::steady_clock::now();
+            while (pipeline.inflight > 0 || (next < count && !pipeline.failed)) {
+                size_t oldest = next;  // Oldest segment in flight
+                for (size_t i = 0; i < depth; ++i) {
+                    if (pipeline.slots[i].inflight && pipeline.slots[i].segment < oldest) {
+                        oldest = pipeline.slots[i].segment;
+                    }
+                }
+                while (!pipeline.failed && next < count && next < oldest + depth && pipeline.nfree > 0) {  // Keep the pipeline full
+                    size_t index = pipeline.freeSlots[--pipeline.nfree];
+                    PipelineSlot &slot = pipeline.slots[index];
+                    slot.segment = next;
+                    segments[next].transferred = 0;
+                    slot.transferred = &segments[next].transferred;
+                    libusb_fill_bulk_transfer(transfers_[index], handle_, segments[next].endpointAddr, segments[next].buffer, segments[next].length, pipelineCallback, &slot, 0);  // No timeout is set here, since the timeout is handled below
+                    int preverrcnt = errcnt;
+                    slot.submitted = std::chrono::steady_clock::now();
+                    submitTransfer(transfers_[index], errcnt, errstr);
+                    if (errcnt != preverrcnt) {  // The failure is already reported by submitTransfer()
+                        pipeline.freeSlots[pipeline.nfree++] = index;
+                        pipeline.failed = true;
+                        reported = true;
+                    } else {
+                        slot.inflight = true;
+                        ++pipeline.inflight;
+                        ++next;
+                    }
+                }
+                if (pipeline.inflight == 0) {
+                    break;
+                }
+                std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastProgress);
+                long long remaining = static_cast<long long>(TR_TIMEOUT) - elapsed.count();
+                if ((remaining <= 0 || pipeline.failed) && !cancelled) {  // On timeout or failure, every transfer still in flight is cancelled
+                    if (!pipeline.failed) {
+                        pipeline.failed = true;
+                        pipeline.result = LIBUSB_ERROR_TIMEOUT;
+                        size_t stalled = depth;
+                        for (size_t i = 0; i < depth; ++i) {  // The transfer that timed out is the oldest one in flight, since the others are queued behind it
+                            if (pipeline.slots[i].inflight && (stalled == depth || pipeline.slots[i].segment < pipeline.slots[stalled].segment)) {
+                                stalled = i;
+                            }
+                        }
+                        pipeline.failedEndpointAddr = transfers_[stalled]->endpoint;
+                    }
+                    for (size_t i = 0; i < depth; ++i) {
+                        if (pipeline.slots[i].inflight) {
+                            cancelTransfer(transfers_[i]);
+                        }
+                    }
+                    cancelled = true;
+                }
+                pipeline.completed = 0;
+                handleEvents(cancelled || remaining <= 0 ? 100 : static_cast<unsigned int>(remaining), &pipeline.completed, errcnt, errstr);  // Cancelled transfers are always completed by libusb, so the timeout is only a polling interval in that case
+                if (pipeline.completed != 0) {
+                    lastProgress = std::chrono::steady_clock::now();
+                }
+                for (size_t i = 0; i < pipeline.ndone; ++i) {  // Completed transfers are accounted for before their slots are reused
+                    const libusb_transfer *transfer = transfers_[pipeline.doneSlots[i]];
+                    const PipelineSlot &slot = pipeline.slots[pipeline.doneSlots[i]];
+                    int result = transfer->status == LIBUSB_TRANSFER_CANCELLED && pipeline.result == LIBUSB_ERROR_TIMEOUT ? LIBUSB_ERROR_TIMEOUT : transferResult(transfer->status);  // Transfers cancelled because the pipeline stalled count as timeouts
+                    recordTransfer(endpointCounters_[endpointIndex(transfer->endpoint)], transfer->length, transfer->actual_length, result, slot.finished - slot.submitted);
+                }
+                pipeline.ndone = 0;
+            }
+            if (pipeline.failed && !reported) {
+                bulkTransferFailed(pipeline.failedEndpointAddr, pipeline.result, errcnt, errstr);
+            }
+        }
+        unlockEvents();
+    }
+}
+
+// Private procedure used to set the chip select of a given channel, which is skipped if the resulting chip select bitmap is known to be the same (added in version 1.3.0)
+void CP2130::setCSShadowed(uint8_t channel, uint8_t control, uint16_t cs, int &errcnt, std::string &errstr)
+{
+    if (!shadowEnabled_ || !shadow_.csValid || shadow_.cs != cs) {
+        unsigned char controlBufferOut[SET_GPIO_CHIP_SELECT_WLEN] = {
+            channel,  // Selected channel
+            control   // Chip select control value
+        };
+        int preverrcnt = errcnt;
+        controlTransfer(SET, SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, SET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
+        shadow_.csValid = shadowEnabled_ && errcnt == preverrcnt && (shadow_.csValid || control == 0x02);  // Note that the resulting bitmap is only known beforehand when using selectCS(), or if the previous bitmap was known
+        shadow_.cs = cs;
+    }
+}
+
+// Private procedure used to issue a configuration request, which is skipped if its payload matches the one in the given shadow (added in version 1.3.0)
+void CP2130::shadowedTransfer(uint8_t bRequest, unsigned char *data, uint16_t wLength, unsigned char *shadow, bool &valid, int &errcnt, std::string &errstr)
+{
+    if (!shadowEnabled_ || !valid || std::memcmp(shadow, data, wLength) != 0) {
+        int preverrcnt = errcnt;
+        controlTransfer(SET, bRequest, 0x0000, 0x0000, data, wLength, errcnt, errstr);
+        valid = shadowEnabled_ && errcnt == preverrcnt;  // After a failure, the state of the device is unknown
+        std::memcpy(shadow, data, wLength);
     }
-    return descriptor;
 }
 
 // Private generic procedure used to write any descriptor (added as a refactor in version 1.1.0)
@@ -199,14 +665,41 @@ bool CP2130::USBConfig::operator !=(const CP2130::USBConfig &other) const
 CP2130::CP2130() :
     context_(nullptr),
     handle_(nullptr),
+    transport_(nullptr),
+    supervisor_(nullptr),
     disconnected_(false),
-    kernelWasAttached_(false)
-{
+    kernelWasAttached_(false),
+    ownsContext_(false),
+    endpointsCached_(false),
+    shadowEnabled_(false),
+    errstrEnabled_(true),
+    resuming_(false),
+    endpointInAddr_(0x81),
+    endpointOutAddr_(0x02),
+    queueDepth_(QDEPTH_DEFAULT),
+    writeReadChunk_(WRITEREAD_CHUNK_DEFAULT),
+    commandBuffer_(nullptr),
+    commandBufferSize_(0),
+    restore_(),
+    eventWaiters_(0)
+{
+    invalidateShadow();
+    resetStats();
 }
 
 CP2130::~CP2130()
 {
     close();  // The destructor is used to close the device, and this is essential so the device can be freed when the parent object is destroyed
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+        libusb_free_transfer(transfers_[i]);  // Free the transfers reused by runPipeline()
+    }
+}
+
+// Returns the libusb context used by the device, or a null pointer if the device is not open or was opened via a transport (added in version 1.3.0)
+// This is mostly useful to integrate asynchronous transfers with an event loop (see CP2130Async)
+libusb_context *CP2130::context() const
+{
+    return transport_ == nullptr && isOpen() ? context_ : nullptr;
 }
 
 // Diagnostic function used to verify if the device has been disconnected
@@ -215,55 +708,230 @@ bool CP2130::disconnected() const
     return disconnected_;  // Returns true if the device has been disconnected, or false otherwise
 }
 
+// Returns a snapshot of the instrumentation counters of the given bulk endpoint (added in version 1.3.0)
+// Transfers issued via bulkTransfer() are accounted for, and so are the ones issued asynchronously by spiRead(), spiWrite() and spiWriteRead(), but not the ones submitted via submitTransfer(), whose completion is only seen by their own callbacks
+// Since the CP2130 has one bulk endpoint per direction, counters are kept per direction, and any endpoint address having the same direction returns the same snapshot
+CP2130::TransferStats CP2130::endpointStats(uint8_t endpointAddr) const
+{
+    return snapshot(endpointCounters_[endpointIndex(endpointAddr)]);
+}
+
+// Returns the log of the most recent transfer failures (added in version 1.3.0)
+const CP2130ErrorLog &CP2130::errorLog() const
+{
+    return errorLog_;
+}
+
+// Returns true if failed transfers are reported via "errstr" (added in version 1.3.0)
+bool CP2130::errstrEnabled() const
+{
+    return errstrEnabled_;
+}
+
 // Checks if the device is open
 bool CP2130::isOpen() const
 {
-    return handle_ != nullptr;  // Returns true if the device is open, or false otherwise
+    return handle_ != nullptr || transport_ != nullptr;  // Returns true if the device is open, either via libusb or via a transport, or false otherwise
+}
+
+// Returns the number of bulk IN transfers that spiRead() keeps in flight (added in version 1.3.0)
+// Note that spiWriteRead() keeps as many WriteRead commands in flight, up to four
+size_t CP2130::queueDepth() const
+{
+    return queueDepth_;
+}
+
+// Returns the number of transfers that spiRead() keeps in flight, which are the read command and up to "queueDepth_" bulk IN transfers (added in version 1.3.0)
+size_t CP2130::readDepth() const
+{
+    return queueDepth_ + 1;
+}
+
+// Returns a snapshot of the instrumentation counters of the given control request (added in version 1.3.0)
+// As with endpointStats(), requests issued via controlTransfer() are accounted for, but not the ones submitted via submitTransfer() (e.g., by CP2130Snapshot or CP2130Sampler)
+// Every request code of the CP2130 has its own counters, while any other request code returns the counters shared by all such codes
+CP2130::TransferStats CP2130::requestStats(uint8_t bRequest) const
+{
+    return snapshot(requestCounters_[requestIndex(bRequest)]);
+}
+
+// Returns true if the shadow is enabled (added in version 1.3.0)
+bool CP2130::shadowEnabled() const
+{
+    return shadowEnabled_;
+}
+
+// Returns the supervisor used to reconnect to the device automatically, or a null pointer if there is none (added in version 1.3.0)
+CP2130Supervisor *CP2130::supervisor() const
+{
+    return supervisor_;
+}
+
+// Returns the maximum payload of each WriteRead command issued by spiWriteRead() (added in version 1.3.0)
+size_t CP2130::writeReadChunk() const
+{
+    return writeReadChunk_;
+}
+
+// Returns the number of transfers that spiWriteRead() keeps in flight, and also how far ahead of the oldest one in flight a transfer can be submitted (added in version 1.3.0)
+// The command for the next chunk is queued while the data of the previous one is still arriving, but the responses of no more than "queueDepth_" commands (up to "WRITEREAD_DEPTH_MAX") are ever awaited at once
+size_t CP2130::writeReadDepth() const
+{
+    return 2 * (queueDepth_ < WRITEREAD_DEPTH_MAX ? queueDepth_ : WRITEREAD_DEPTH_MAX) - 1;
+}
+
+// Returns the pool of transfer buffers of the device, from which the command buffers of the SPI functions are obtained (added in version 1.3.0)
+// Other classes may obtain their transfer buffers from it too, and those are allocated on the heap, so that they remain valid after the device is closed
+CP2130BufferPool &CP2130::bufferPool()
+{
+    return bufferPool_;
 }
 
 // Safe bulk transfer
 void CP2130::bulkTransfer(uint8_t endpointAddr, unsigned char *data, int length, int *transferred, int &errcnt, std::string &errstr)
 {
+    if (disconnected_ && supervisor_ != nullptr && !resuming_) {  // If the device is supervised, the transfer is paused until the device is back (added in version 1.3.0)
+        resume(errcnt, errstr);
+    }
     if (!isOpen()) {
         ++errcnt;
         errstr += "In bulkTransfer(): device is not open.\n";  // Program logic error
     } else {
-        int result = libusb_bulk_transfer(handle_, endpointAddr, data, length, transferred, TR_TIMEOUT);
+        int count = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int result = transport_ == nullptr ? libusb_bulk_transfer(handle_, endpointAddr, data, length, &count, TR_TIMEOUT) : transport_->bulkTransfer(endpointAddr, data, length, &count, TR_TIMEOUT);
+        recordTransfer(endpointCounters_[endpointIndex(endpointAddr)], length, count, result, std::chrono::steady_clock::now() - start);  // Added in version 1.3.0
+        if (transferred != nullptr) {
+            *transferred = count;
+        }
         if (result != 0 || (transferred != nullptr && *transferred != length)) {  // The number of transferred bytes is also verified, as long as a valid (non-null) pointer is passed via "transferred"
-            ++errcnt;
-            std::ostringstream stream;
-            if (endpointAddr < 0x80) {
-                stream << "Failed bulk OUT transfer to endpoint "
-                       << (0x0f & endpointAddr)
-                       << " (address 0x"
-                       << std::hex << std::setfill ('0') << std::setw(2) << static_cast<int>(endpointAddr)
-                       << ")." << std::endl;
-            } else {
-                stream << "Failed bulk IN transfer from endpoint "
-                       << (0x0f & endpointAddr)
-                       << " (address 0x"
-                       << std::hex << std::setfill ('0') << std::setw(2) << static_cast<int>(endpointAddr)
-                       << ")." << std::endl;
-            }
-            errstr += stream.str();
-            if (result == LIBUSB_ERROR_NO_DEVICE || result == LIBUSB_ERROR_IO) {  // Note that libusb_bulk_transfer() may return "LIBUSB_ERROR_IO" [-1] on device disconnect
-                disconnected_ = true;  // This reports that the device has been disconnected
+            bulkTransferFailed(endpointAddr, result, errcnt, errstr);  // Refactored in version 1.3.0
+        }
+    }
+}
+
+// Finds the largest WriteRead chunk size that works with the current channel, applies it and returns it (added in version 1.3.0)
+// Sizes that fill 1, 2, 4 and so on bulk packets are tried in ascending order, up to "WRITEREAD_CHUNK_MAX", each with a burst of WriteRead commands kept in flight as spiWriteRead() does, and the search stops at the first size that fails
+// A size fails if any command fails or reads back fewer bytes than written and, if "loopback" is true, also if the bytes read back differ from the ones written, which requires MISO to be looped back to MOSI
+// Note that test patterns are clocked onto the SPI bus with the chip select of the current channel asserted, so no slave that could be affected by them should be selected
+// Also note that a size that fails may leave responses pending, so those are read and discarded until the bulk IN endpoint times out, and if that fails, the failure is reported, in which case the device should be reset before use (the chunk size is kept)
+// If even the smallest size fails, the chunk size is left unchanged and the failure is reported
+size_t CP2130::calibrateWriteReadChunk(bool loopback, int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    size_t packetSize = bulkPacketSize(errcnt, errstr);
+    uint8_t endpointInAddr = getEndpointInAddr(errcnt, errstr);
+    uint8_t endpointOutAddr = getEndpointOutAddr(errcnt, errstr);
+    size_t prevChunk = writeReadChunk_, bestChunk = 0;
+    size_t npackets = 1;
+    while (npackets * packetSize < CMD_HEADER_SIZE + WRITEREAD_CHUNK_MIN) {
+        npackets *= 2;
+    }
+    std::vector<uint8_t> dataOut, dataIn;
+    for (; errcnt == preverrcnt && npackets * packetSize - CMD_HEADER_SIZE <= WRITEREAD_CHUNK_MAX; npackets *= 2) {
+        writeReadChunk_ = npackets * packetSize - CMD_HEADER_SIZE;
+        size_t length = CALIBRATION_CHUNKS * writeReadChunk_;
+        dataOut.resize(length);
+        dataIn.assign(length, 0x00);
+        for (size_t i = 0; i < length; ++i) {
+            dataOut[i] = static_cast<uint8_t>(i + i / 251);  // Pattern that does not repeat with the size of a chunk or a packet
+        }
+        int trialerrcnt = 0;
+        std::string trialerrstr;
+        size_t bytesRead = spiWriteRead(dataOut.data(), dataIn.data(), length, endpointInAddr, endpointOutAddr, trialerrcnt, trialerrstr);
+        if (trialerrcnt != 0 || bytesRead != length || (loopback && dataIn != dataOut)) {
+            if (bestChunk == 0 || disconnected_) {  // Failures past the smallest size are expected, unless the device is gone
+                errcnt += trialerrcnt;
+                errstr += trialerrstr;
+            } else {  // Responses left pending by the failed size are drained, so that they are not taken for the responses of later commands
+                int length = static_cast<int>(dataIn.size() / packetSize * packetSize), result, transferred;  // A multiple of the packet size, so that no packet can overflow the buffer
+                do {
+                    transferred = 0;
+                    result = transport_ == nullptr ? libusb_bulk_transfer(handle_, endpointInAddr, dataIn.data(), length, &transferred, TR_TIMEOUT) : transport_->bulkTransfer(endpointInAddr, dataIn.data(), length, &transferred, TR_TIMEOUT);
+                } while (transferred > 0 && (result == 0 || result == LIBUSB_ERROR_TIMEOUT));
+                if (result != 0 && result != LIBUSB_ERROR_TIMEOUT) {  // The device should then be reset before use
+                    bulkTransferFailed(endpointInAddr, result, errcnt, errstr);
+                }
             }
+            break;
+        }
+        bestChunk = writeReadChunk_;
+    }
+    if (bestChunk == 0) {
+        writeReadChunk_ = prevChunk;
+        if (errcnt == preverrcnt) {
+            ++errcnt;
+            errstr += "In calibrateWriteReadChunk(): no chunk size works.\n";
+        }
+    } else {
+        writeReadChunk_ = bestChunk;
+    }
+    return writeReadChunk_;
+}
+
+// Cancels an asynchronous transfer that was submitted using submitTransfer() (added in version 1.3.0)
+// As with libusb_cancel_transfer(), the callback of the transfer is still called, with its status set to "LIBUSB_TRANSFER_CANCELLED"
+void CP2130::cancelTransfer(libusb_transfer *transfer)
+{
+    if (transport_ == nullptr) {
+        libusb_cancel_transfer(transfer);  // Transfers that are no longer in flight are ignored by libusb
+    } else {
+        transport_->cancelTransfer(transfer);
+    }
+}
+
+// Verifies the outcome of an asynchronous transfer, reporting it in the same manner as bulkTransfer() or controlTransfer() would (added in version 1.3.0)
+// This function is meant to be used after the transfer completes, and cancelled transfers are not treated as errors
+void CP2130::checkTransfer(const libusb_transfer *transfer, int &errcnt, std::string &errstr)
+{
+    if (transfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+        uint16_t wLength = static_cast<uint16_t>(transfer->buffer[7] << 8 | transfer->buffer[6]);  // Data stage length, as found in the setup packet (little-endian conversion)
+        if (transfer->status != LIBUSB_TRANSFER_CANCELLED && (transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != wLength)) {
+            controlTransferFailed(transfer->buffer[0], transfer->buffer[1], transferResult(transfer->status), errcnt, errstr);
         }
+    } else if (transfer->status != LIBUSB_TRANSFER_CANCELLED && transfer->status != LIBUSB_TRANSFER_COMPLETED) {  // Short bulk transfers are not errors here, since they are expected in some situations
+        bulkTransferFailed(transfer->endpoint, transferResult(transfer->status), errcnt, errstr);
     }
 }
 
+// Verifies the outcome of an asynchronous transfer as checkTransfer() does, but also reports a short bulk transfer, as bulkTransfer() does when "transferred" is given (added in version 1.3.0)
+// As with any other failure, a short transfer is logged (see errorLog())
+void CP2130::checkFullTransfer(const libusb_transfer *transfer, int &errcnt, std::string &errstr)
+{
+    if (transfer->type != LIBUSB_TRANSFER_TYPE_CONTROL && transfer->status == LIBUSB_TRANSFER_COMPLETED && transfer->actual_length != transfer->length) {
+        bulkTransferFailed(transfer->endpoint, 0, errcnt, errstr);  // A result of zero means that fewer bytes than expected were transferred
+    } else {
+        checkTransfer(transfer, errcnt, errstr);
+    }
+}
+
+// Clears the log of transfer failures (added in version 1.3.0)
+void CP2130::clearErrorLog()
+{
+    errorLog_.clear();
+}
+
 // Closes the device safely, if open
 void CP2130::close()
 {
-    if (isOpen()) {  // This condition avoids a segmentation fault if the calling algorithm tries, for some reason, to close the same device twice (e.g., if the device is already closed when the destructor is called)
+    if (transport_ != nullptr) {  // The transport is merely detached, since it belongs to the calling algorithm (added in version 1.3.0)
+        resetBufferPool(nullptr);
+        transport_ = nullptr;
+        endpointsCached_ = false;
+        invalidateShadow();
+    } else if (isOpen()) {  // This condition avoids a segmentation fault if the calling algorithm tries, for some reason, to close the same device twice (e.g., if the device is already closed when the destructor is called)
+        resetBufferPool(nullptr);  // Buffers in device memory must be freed before the handle is closed (added in version 1.3.0)
         libusb_release_interface(handle_, 0);  // Release the interface
         if (kernelWasAttached_) {  // If a kernel driver was attached to the interface before
             libusb_attach_kernel_driver(handle_, 0);  // Reattach the kernel driver
         }
         libusb_close(handle_);  // Close the device
-        libusb_exit(context_);  // Deinitialize libusb
+        if (ownsContext_) {  // A shared context is left to the calling algorithm (added in version 1.3.0)
+            libusb_exit(context_);  // Deinitialize libusb
+        }
         handle_ = nullptr;  // Required to mark the device as closed
+        endpointsCached_ = false;  // The next device to be opened may have a different transfer priority
+        invalidateShadow();  // Likewise, the next device may be in a different state
     }
 }
 
@@ -280,7 +948,7 @@ void CP2130::configureGPIO(uint8_t pin, uint8_t mode, bool value,  int &errcnt,
             mode,  // Pin mode (see the values applicable to PinConfig/getPinConfig()/writePinConfig())
             value  // Output value (when applicable)
         };
-        controlTransfer(SET, SET_GPIO_MODE_AND_LEVEL, 0x0000, 0x0000, controlBufferOut, SET_GPIO_MODE_AND_LEVEL_WLEN, errcnt, errstr);
+        shadowedTransfer(SET_GPIO_MODE_AND_LEVEL, controlBufferOut, SET_GPIO_MODE_AND_LEVEL_WLEN, shadow_.gpio[pin], shadow_.gpioValid[pin], errcnt, errstr);  // Skipped if the pin is known to have the same configuration (added in version 1.3.0)
     }
 }
 
@@ -298,7 +966,7 @@ void CP2130::configureSPIDelays(uint8_t channel, const SPIDelays &delays, int &e
             static_cast<uint8_t>(delays.pstastdly >> 8), static_cast<uint8_t>(delays.pstastdly),                         // Post-assert delay
             static_cast<uint8_t>(delays.prdastdly >> 8), static_cast<uint8_t>(delays.prdastdly)                          // Pre-deassert delay
         };
-        controlTransfer(SET, SET_SPI_DELAY, 0x0000, 0x0000, controlBufferOut, SET_SPI_DELAY_WLEN, errcnt, errstr);
+        shadowedTransfer(SET_SPI_DELAY, controlBufferOut, SET_SPI_DELAY_WLEN, shadow_.spiDelay[channel], shadow_.spiDelayValid[channel], errcnt, errstr);  // Skipped if the channel is known to have the same delays (added in version 1.3.0)
     }
 }
 
@@ -313,32 +981,63 @@ void CP2130::configureSPIMode(uint8_t channel, const SPIMode &mode, int &errcnt,
             channel,                                                                                       // Selected channel
             static_cast<uint8_t>(mode.cpha << 5 | mode.cpol << 4 | mode.csmode << 3 | (0x07 & mode.cfrq))  // Control word (specified chip select mode, clock frequency, polarity and phase)
         };
-        controlTransfer(SET, SET_SPI_WORD, 0x0000, 0x0000, controlBufferOut, SET_SPI_WORD_WLEN, errcnt, errstr);
+        shadowedTransfer(SET_SPI_WORD, controlBufferOut, SET_SPI_WORD_WLEN, shadow_.spiWord[channel], shadow_.spiWordValid[channel], errcnt, errstr);  // Skipped if the channel is known to have the same mode (added in version 1.3.0)
     }
 }
 
 // Safe control transfer
 void CP2130::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength, int &errcnt, std::string &errstr)
 {
+    if (disconnected_ && supervisor_ != nullptr && !resuming_) {  // If the device is supervised, the transfer is paused until the device is back (added in version 1.3.0)
+        resume(errcnt, errstr);
+    }
     if (!isOpen()) {
         ++errcnt;
         errstr += "In controlTransfer(): device is not open.\n";  // Program logic error
     } else {
-        int result = libusb_control_transfer(handle_, bmRequestType, bRequest, wValue, wIndex, data, wLength, TR_TIMEOUT);
-        if (result != wLength) {
-            ++errcnt;
-            std::ostringstream stream;
-            stream << "Failed control transfer (0x"
-                   << std::hex << std::setfill ('0') << std::setw(2) << static_cast<int>(bmRequestType)
-                   << ", 0x"
-                   << std::setw(2) << static_cast<int>(bRequest)
-                   << ")." << std::endl;
-            errstr += stream.str();
-            if (result == LIBUSB_ERROR_NO_DEVICE || result == LIBUSB_ERROR_IO || result == LIBUSB_ERROR_PIPE) {  // Note that libusb_control_transfer() may return "LIBUSB_ERROR_IO" [-1] or "LIBUSB_ERROR_PIPE" [-9] on device disconnect
-                disconnected_ = true;  // This reports that the device has been disconnected
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int result = transport_ == nullptr ? libusb_control_transfer(handle_, bmRequestType, bRequest, wValue, wIndex, data, wLength, TR_TIMEOUT) : transport_->controlTransfer(bmRequestType, bRequest, wValue, wIndex, data, wLength, TR_TIMEOUT);
+        recordTransfer(requestCounters_[requestIndex(bRequest)], wLength, result < 0 ? 0 : result, result < 0 ? result : 0, std::chrono::steady_clock::now() - start);  // Added in version 1.3.0
+        bool gone = result == LIBUSB_ERROR_NO_DEVICE;
+        if ((result == LIBUSB_ERROR_IO || result == LIBUSB_ERROR_PIPE) && supervisor_ != nullptr && !resuming_) {  // Such errors are also returned by a device that is still present (e.g., a stall), so the index tells whether the device is gone (added in version 1.3.0)
+            int refreshErrcnt = 0;
+            std::string refreshErrstr;
+            supervisor_->index().refresh(refreshErrcnt, refreshErrstr);
+            gone = supervisor_->index().path(supervisor_->serial()).empty();
+        }
+        if (gone && supervisor_ != nullptr && !resuming_ && !writesOTP(bmRequestType, bRequest)) {  // If the device is supervised and goes away, the request is issued again once the device is back, unless it writes to the OTP ROM, since it may have taken effect already (added in version 1.3.0)
+            markDisconnected();
+            resume(errcnt, errstr);
+            if (!disconnected_) {
+                start = std::chrono::steady_clock::now();
+                result = transport_ == nullptr ? libusb_control_transfer(handle_, bmRequestType, bRequest, wValue, wIndex, data, wLength, TR_TIMEOUT) : transport_->controlTransfer(bmRequestType, bRequest, wValue, wIndex, data, wLength, TR_TIMEOUT);
+                recordTransfer(requestCounters_[requestIndex(bRequest)], wLength, result < 0 ? 0 : result, result < 0 ? result : 0, std::chrono::steady_clock::now() - start);
             }
         }
+        if (result != wLength) {
+            controlTransferFailed(bmRequestType, bRequest, result, errcnt, errstr);  // Refactored in version 1.3.0
+        }
+    }
+}
+
+// Returns the WriteRead chunk size that suits the device as currently configured, without applying it (added in version 1.3.0)
+// Each command, including its header, is made to fill a whole number of bulk packets, and that number is the smallest one that lets the response to a command reach the full FIFO threshold (see setFIFOThreshold())
+// The resulting size can be applied using setWriteReadChunk(), and calibrateWriteReadChunk() can be used instead, to find out if larger chunks work
+size_t CP2130::deriveWriteReadChunk(int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    size_t packetSize = bulkPacketSize(errcnt, errstr);
+    size_t threshold = getFIFOThreshold(errcnt, errstr);
+    size_t chunk = WRITEREAD_CHUNK_DEFAULT;
+    if (errcnt == preverrcnt) {
+        size_t minChunk = threshold > WRITEREAD_CHUNK_MIN ? threshold : WRITEREAD_CHUNK_MIN;
+        size_t npackets = 1;
+        while (npackets * packetSize < CMD_HEADER_SIZE + minChunk) {
+            ++npackets;
+        }
+        chunk = npackets * packetSize - CMD_HEADER_SIZE;
     }
+    return chunk;
 }
 
 // Disables the chip select of the target channel
@@ -348,11 +1047,7 @@ void CP2130::disableCS(uint8_t channel, int &errcnt, std::string &errstr)
         ++errcnt;
         errstr += "In disableCS(): SPI channel value must be between 0 and 10.\n";  // Program logic error
     } else {
-        unsigned char controlBufferOut[SET_GPIO_CHIP_SELECT_WLEN] = {
-            channel,  // Selected channel
-            0x00      // Corresponding chip select disabled
-        };
-        controlTransfer(SET, SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, SET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
+        setCSShadowed(channel, 0x00, static_cast<uint16_t>(shadow_.cs & ~(0x0001 << channel)), errcnt, errstr);  // Skipped if the chip select bitmap is known to remain the same (added in version 1.3.0)
     }
 }
 
@@ -370,7 +1065,7 @@ void CP2130::disableSPIDelays(uint8_t channel, int &errcnt, std::string &errstr)
             0x00, 0x00,  // post-assert and
             0x00, 0x00   // pre-deassert delays all set to 0us
         };
-        controlTransfer(SET, SET_SPI_DELAY, 0x0000, 0x0000, controlBufferOut, SET_SPI_DELAY_WLEN, errcnt, errstr);
+        shadowedTransfer(SET_SPI_DELAY, controlBufferOut, SET_SPI_DELAY_WLEN, shadow_.spiDelay[channel], shadow_.spiDelayValid[channel], errcnt, errstr);  // Skipped if the channel is known to have the same delays (added in version 1.3.0)
     }
 }
 
@@ -381,11 +1076,7 @@ void CP2130::enableCS(uint8_t channel, int &errcnt, std::string &errstr)
         ++errcnt;
         errstr += "In enableCS(): SPI channel value must be between 0 and 10.\n";  // Program logic error
     } else {
-        unsigned char controlBufferOut[SET_GPIO_CHIP_SELECT_WLEN] = {
-            channel,  // Selected channel
-            0x01      // Corresponding chip select enabled
-        };
-        controlTransfer(SET, SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, SET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
+        setCSShadowed(channel, 0x01, static_cast<uint16_t>(shadow_.cs | 0x0001 << channel), errcnt, errstr);  // Skipped if the chip select bitmap is known to remain the same (added in version 1.3.0)
     }
 }
 
@@ -393,7 +1084,12 @@ void CP2130::enableCS(uint8_t channel, int &errcnt, std::string &errstr)
 uint8_t CP2130::getClockDivider(int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[GET_CLOCK_DIVIDER_WLEN];
+    int preverrcnt = errcnt;
     controlTransfer(GET, GET_CLOCK_DIVIDER, 0x0000, 0x0000, controlBufferIn, GET_CLOCK_DIVIDER_WLEN, errcnt, errstr);
+    if (shadowEnabled_ && errcnt == preverrcnt) {  // Fill the shadow (added in version 1.3.0)
+        shadow_.divider[0] = controlBufferIn[0];
+        shadow_.dividerValid = true;
+    }
     return controlBufferIn[0];
 }
 
@@ -407,22 +1103,35 @@ bool CP2130::getCS(uint8_t channel, int &errcnt, std::string &errstr)
         cs = false;
     } else {
         unsigned char controlBufferIn[GET_GPIO_CHIP_SELECT_WLEN];
+        int preverrcnt = errcnt;
         controlTransfer(GET, GET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferIn, GET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
+        if (shadowEnabled_ && errcnt == preverrcnt) {  // Fill the shadow (added in version 1.3.0)
+            shadow_.cs = static_cast<uint16_t>(0x07ff & (controlBufferIn[0] << 8 | controlBufferIn[1]));  // Chip select enable bitmap corresponds to bytes 0 and 1 (big-endian conversion)
+            shadow_.csValid = true;
+        }
         cs = (0x0001 << channel & (controlBufferIn[0] << 8 | controlBufferIn[1])) != 0x0000;
     }
     return cs;
 }
 
 // Returns the address of the endpoint assuming the IN direction
+// Since version 1.3.0, the address is cached, and the transfer priority is only obtained again after a reset or a change to the USB configuration
 uint8_t CP2130::getEndpointInAddr(int &errcnt, std::string &errstr)
 {
-    return getTransferPriority(errcnt, errstr) == PRIOWRITE ? 0x82 : 0x81;
+    if (!endpointsCached_) {
+        refreshEndpoints(errcnt, errstr);
+    }
+    return endpointInAddr_;
 }
 
 // Returns the address of the endpoint assuming the OUT direction
+// Since version 1.3.0, the address is cached, as above
 uint8_t CP2130::getEndpointOutAddr(int &errcnt, std::string &errstr)
 {
-    return getTransferPriority(errcnt, errstr) == PRIOWRITE ? 0x01 : 0x02;
+    if (!endpointsCached_) {
+        refreshEndpoints(errcnt, errstr);
+    }
+    return endpointOutAddr_;
 }
 
 // Gets the event counter, including mode and value
@@ -430,11 +1139,7 @@ CP2130::EventCounter CP2130::getEventCounter(int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[GET_EVENT_COUNTER_WLEN];
     controlTransfer(GET, GET_EVENT_COUNTER, 0x0000, 0x0000, controlBufferIn, GET_EVENT_COUNTER_WLEN, errcnt, errstr);
-    CP2130::EventCounter evtcntr;
-    evtcntr.overflow = (0x80 & controlBufferIn[0]) != 0x00;                               // Event counter overflow bit corresponds to bit 7 of byte 0
-    evtcntr.mode = static_cast<uint8_t>(0x07 & controlBufferIn[0]);                       // GPIO.4/EVTCNTR pin mode corresponds to bits 2:0 of byte 0
-    evtcntr.value = static_cast<uint16_t>(controlBufferIn[1] << 8 | controlBufferIn[2]);  // Event count value corresponds to bytes 1 and 2 (big-endian conversion)
-    return evtcntr;
+    return decodeEventCounter(controlBufferIn);  // Refactored in version 1.3.0
 }
 
 // Gets the full FIFO threshold
@@ -516,7 +1221,7 @@ uint16_t CP2130::getGPIOs(int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[GET_GPIO_VALUES_WLEN];
     controlTransfer(GET, GET_GPIO_VALUES, 0x0000, 0x0000, controlBufferIn, GET_GPIO_VALUES_WLEN, errcnt, errstr);
-    return static_cast<uint16_t>(BMGPIOS & (controlBufferIn[0] << 8 | controlBufferIn[1]));  // Returns the value of every GPIO pin in bitmap format (big-endian conversion)
+    return decodeGPIOs(controlBufferIn);  // Refactored in version 1.3.0
 }
 
 // Returns the lock word from the CP2130 OTP ROM
@@ -538,24 +1243,7 @@ CP2130::PinConfig CP2130::getPinConfig(int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[GET_PIN_CONFIG_WLEN];
     controlTransfer(GET, GET_PIN_CONFIG, 0x0000, 0x0000, controlBufferIn, GET_PIN_CONFIG_WLEN, errcnt, errstr);
-    PinConfig config;
-    config.gpio0 = controlBufferIn[0];                                                         // GPIO.0 pin config corresponds to byte 0
-    config.gpio1 = controlBufferIn[1];                                                         // GPIO.1 pin config corresponds to byte 1
-    config.gpio2 = controlBufferIn[2];                                                         // GPIO.2 pin config corresponds to byte 2
-    config.gpio3 = controlBufferIn[3];                                                         // GPIO.3 pin config corresponds to byte 3
-    config.gpio4 = controlBufferIn[4];                                                         // GPIO.4 pin config corresponds to byte 4
-    config.gpio5 = controlBufferIn[5];                                                         // GPIO.5 pin config corresponds to byte 5
-    config.gpio6 = controlBufferIn[6];                                                         // GPIO.6 pin config corresponds to byte 6
-    config.gpio7 = controlBufferIn[7];                                                         // GPIO.7 pin config corresponds to byte 7
-    config.gpio8 = controlBufferIn[8];                                                         // GPIO.8 pin config corresponds to byte 8
-    config.gpio9 = controlBufferIn[9];                                                         // GPIO.9 pin config corresponds to byte 9
-    config.gpio10 = controlBufferIn[10];                                                       // GPIO.10 pin config corresponds to byte 10
-    config.sspndlvl = static_cast<uint16_t>(controlBufferIn[11] << 8 | controlBufferIn[12]);   // Suspend pin level bitmap corresponds to bytes 11 and 12 (big-endian conversion)
-    config.sspndmode = static_cast<uint16_t>(controlBufferIn[13] << 8 | controlBufferIn[14]);  // Suspend pin mode bitmap corresponds to bytes 13 and 14 (big-endian conversion)
-    config.wkupmask = static_cast<uint16_t>(controlBufferIn[15] << 8 | controlBufferIn[16]);   // Wakeup pin mask bitmap corresponds to bytes 15 and 16 (big-endian conversion)
-    config.wkupmatch = static_cast<uint16_t>(controlBufferIn[17] << 8 | controlBufferIn[18]);  // Wakeup pin match bitmap corresponds to bytes 17 and 18 (big-endian conversion)
-    config.divider = controlBufferIn[19];                                                      // Clock divider corresponds to byte 19
-    return config;
+    return decodePinConfig(controlBufferIn);  // Refactored in version 1.3.0
 }
 
 // Gets the product descriptor from the CP2130 OTP ROM
@@ -605,14 +1293,14 @@ CP2130::SPIDelays CP2130::getSPIDelays(uint8_t channel, int &errcnt, std::string
         delays = {false, false, false, false, 0x0000, 0x0000, 0x0000};
     } else {
         unsigned char controlBufferIn[GET_SPI_DELAY_WLEN];
+        int preverrcnt = errcnt;
         controlTransfer(GET, GET_SPI_DELAY, 0x0000, channel, controlBufferIn, GET_SPI_DELAY_WLEN, errcnt, errstr);  // The value of "channel" is now passed to "wIndex" in controlTransfer(), as it should (fixed in version 1.2.5)
-        delays.cstglen = (0x08 & controlBufferIn[1]) != 0x00;                                    // CS toggle enable corresponds to bit 3 of byte 1
-        delays.prdasten = (0x04 & controlBufferIn[1]) != 0x00;                                   // Pre-deassert delay enable corresponds to bit 2 of byte 1
-        delays.pstasten = (0x02 & controlBufferIn[1]) != 0x00;                                   // Post-assert delay enable to bit 1 of byte 1
-        delays.itbyten = (0x01 &controlBufferIn[1]) != 0x00;                                     // Inter-byte delay enable corresponds to bit 0 of byte 1
-        delays.itbytdly = static_cast<uint16_t>(controlBufferIn[2] << 8 | controlBufferIn[3]);   // Inter-byte delay corresponds to bytes 2 and 3 (big-endian conversion)
-        delays.pstastdly = static_cast<uint16_t>(controlBufferIn[4] << 8 | controlBufferIn[5]);  // Post-assert delay corresponds to bytes 4 and 5 (big-endian conversion)
-        delays.prdastdly = static_cast<uint16_t>(controlBufferIn[6] << 8 | controlBufferIn[7]);  // Pre-deassert delay corresponds to bytes 6 and 7 (big-endian conversion)
+        if (shadowEnabled_ && errcnt == preverrcnt) {  // Fill the shadow, which has the same layout as the Set_SPI_Delay payload (added in version 1.3.0)
+            shadow_.spiDelay[channel][0] = channel;
+            std::memcpy(&shadow_.spiDelay[channel][1], &controlBufferIn[1], SET_SPI_DELAY_WLEN - 1);
+            shadow_.spiDelayValid[channel] = true;
+        }
+        delays = decodeSPIDelays(&controlBufferIn[1]);  // Byte 0 is the channel (refactored in version 1.3.0)
     }
     return delays;
 }
@@ -627,11 +1315,16 @@ CP2130::SPIMode CP2130::getSPIMode(uint8_t channel, int &errcnt, std::string &er
         mode = {false, 0x00, false, false};
     } else {
         unsigned char controlBufferIn[GET_SPI_WORD_WLEN];
+        int preverrcnt = errcnt;
         controlTransfer(GET, GET_SPI_WORD, 0x0000, 0x0000, controlBufferIn, GET_SPI_WORD_WLEN, errcnt, errstr);
-        mode.csmode = (0x08 & controlBufferIn[channel]) != 0x00;            // Chip select mode corresponds to bit 3
-        mode.cfrq = static_cast<uint8_t>(0x07 & controlBufferIn[channel]);  // Clock frequency is set in the bits 2:0
-        mode.cpha = (0x20 & controlBufferIn[channel]) != 0x00;              // Clock phase corresponds to bit 5
-        mode.cpol = (0x10 & controlBufferIn[channel]) != 0x00;              // Clock polarity corresponds to bit 4
+        if (shadowEnabled_ && errcnt == preverrcnt) {  // Fill the shadow for every channel, since all of them are obtained at once (added in version 1.3.0)
+            for (uint8_t i = 0; i < GET_SPI_WORD_WLEN; ++i) {
+                shadow_.spiWord[i][0] = i;
+                shadow_.spiWord[i][1] = controlBufferIn[i];
+                shadow_.spiWordValid[i] = true;
+            }
+        }
+        mode = decodeSPIMode(controlBufferIn[channel]);  // Refactored in version 1.3.0
     }
     return mode;
 }
@@ -647,15 +1340,7 @@ CP2130::USBConfig CP2130::getUSBConfig(int &errcnt, std::string &errstr)
 {
     unsigned char controlBufferIn[GET_USB_CONFIG_WLEN];
     controlTransfer(GET, GET_USB_CONFIG, 0x0000, 0x0000, controlBufferIn, GET_USB_CONFIG_WLEN, errcnt, errstr);
-    USBConfig config;
-    config.vid = static_cast<uint16_t>(controlBufferIn[1] << 8 | controlBufferIn[0]);  // VID corresponds to bytes 0 and 1 (little-endian conversion)
-    config.pid = static_cast<uint16_t>(controlBufferIn[3] << 8 | controlBufferIn[2]);  // PID corresponds to bytes 2 and 3 (little-endian conversion)
-    config.majrel = controlBufferIn[6];                                                // Major release version corresponds to byte 6
-    config.minrel = controlBufferIn[7];                                                // Minor release version corresponds to byte 7
-    config.maxpow = controlBufferIn[4];                                                // Maximum power consumption corresponds to byte 4
-    config.powmode = controlBufferIn[5];                                               // Power mode corresponds to byte 5
-    config.trfprio = controlBufferIn[8];                                               // Transfer priority corresponds to byte 8
-    return config;
+    return decodeUSBConfig(controlBufferIn);  // Refactored in version 1.3.0
 }
 
 // Returns true is the OTP ROM of the CP2130 was never written
@@ -670,6 +1355,52 @@ bool CP2130::isOTPLocked(int &errcnt, std::string &errstr)
     return (LWALL & getLockWord(errcnt, errstr)) == 0x0000;  // Note that the reserved bits are ignored
 }
 
+// Handles pending events on behalf of a background thread, such as the one of CP2130Sampler (added in version 1.3.0)
+// Unlike handleEvents(), this first waits for any other thread that holds or waits for the event lock (see lockEvents()) to release it, so that background threads never keep an operation of the device from running
+void CP2130::handleBackgroundEvents(unsigned int timeout, int *completed, int &errcnt, std::string &errstr)
+{
+    {
+        std::unique_lock<std::mutex> lock(eventWaitersMutex_);
+        eventsReleased_.wait(lock, [this] { return eventWaiters_ == 0; });
+    }
+    handleEvents(timeout, completed, errcnt, errstr);
+}
+
+// Handles pending events for asynchronous transfers, for up to the given number of milliseconds (added in version 1.3.0)
+// If "completed" is not a null pointer, this function returns as soon as its value becomes non-zero, as with libusb_handle_events_timeout_completed()
+// The event lock is held meanwhile (see lockEvents()), so that callbacks are never called by two threads at once
+void CP2130::handleEvents(unsigned int timeout, int *completed, int &errcnt, std::string &errstr)
+{
+    if (!isOpen()) {
+        ++errcnt;
+        errstr += "In handleEvents(): device is not open.\n";  // Program logic error
+    } else {
+        timeval tv;
+        tv.tv_sec = static_cast<time_t>(timeout / 1000);
+        tv.tv_usec = static_cast<suseconds_t>(timeout % 1000 * 1000);
+        lockEvents();
+        int result = transport_ == nullptr ? libusb_handle_events_timeout_completed(context_, &tv, completed) : transport_->handleEvents(&tv, completed);
+        unlockEvents();
+        if (result != 0 && result != LIBUSB_ERROR_INTERRUPTED && result != LIBUSB_ERROR_TIMEOUT) {
+            ++errcnt;
+            errstr += "Failed to handle events.\n";
+        }
+    }
+}
+
+// Invalidates the shadow, so that every subsequent configuration request is issued (added in version 1.3.0)
+// This is done automatically on reset(), close() and disconnect, but it is also required if the device is configured by other means
+void CP2130::invalidateShadow()
+{
+    for (size_t i = 0; i < 11; ++i) {
+        shadow_.spiWordValid[i] = false;
+        shadow_.spiDelayValid[i] = false;
+        shadow_.gpioValid[i] = false;
+    }
+    shadow_.dividerValid = false;
+    shadow_.csValid = false;
+}
+
 // Returns true if a ReadWithRTR command is currently active
 bool CP2130::isRTRActive(int &errcnt, std::string &errstr)
 {
@@ -678,6 +1409,19 @@ bool CP2130::isRTRActive(int &errcnt, std::string &errstr)
     return controlBufferIn[0] == 0x01;
 }
 
+// Takes the event lock of the device, which keeps other threads from handling its events until unlockEvents() is called (added in version 1.3.0)
+// Operations whose callbacks change state that the calling thread also reads (e.g., spiRead() or CP2130Waveform::run()) hold this lock while they run, so that their callbacks are only ever called from within their own calls to handleEvents()
+// Background threads, which use handleBackgroundEvents(), stop handling events meanwhile, and their transfers are completed by the thread that holds the lock instead
+// The lock is recursive, and every call must be matched by a call to unlockEvents() from the same thread
+void CP2130::lockEvents()
+{
+    {
+        std::lock_guard<std::mutex> lock(eventWaitersMutex_);
+        ++eventWaiters_;
+    }
+    eventMutex_.lock();
+}
+
 // Locks the OTP ROM of the CP2130, preventing further changes
 void CP2130::lockOTP(int &errcnt, std::string &errstr)
 {
@@ -689,11 +1433,33 @@ void CP2130::lockOTP(int &errcnt, std::string &errstr)
 int CP2130::open(uint16_t vid, uint16_t pid, const std::string &serial)
 {
     int retval;
+    libusb_context *context;
     if (isOpen()) {  // Just in case the calling algorithm tries to open a device that was already sucessfully open, or tries to open different devices concurrently, all while using (or referencing to) the same object
         retval = SUCCESS;
-    } else if (libusb_init(&context_) != 0) {  // Initialize libusb. In case of failure
+    } else if (libusb_init(&context) != 0) {  // Initialize libusb. In case of failure
         retval = ERROR_INIT;
     } else {  // If libusb is initialized
+        retval = open(context, vid, pid, serial);  // Since version 1.3.0, the device is opened by the following variant of open()
+        if (retval == SUCCESS) {
+            ownsContext_ = true;  // The context is deinitialized when the device is closed
+        } else {
+            libusb_exit(context);  // Deinitialize libusb
+        }
+    }
+    return retval;
+}
+
+// Opens the device having the given VID, PID and, optionally, the given serial number, using the given libusb context (added in version 1.3.0)
+// The context is shared, and therefore it is not deinitialized when the device is closed (that is up to the calling algorithm, after closing every device that uses it)
+// Note that this variant never returns "ERROR_INIT"
+int CP2130::open(libusb_context *context, uint16_t vid, uint16_t pid, const std::string &serial)
+{
+    int retval;
+    if (isOpen()) {  // As with the other variants of open(), opening an already open object is harmless
+        retval = SUCCESS;
+    } else {
+        context_ = context;
+        ownsContext_ = false;
         if (serial.empty()) {  // Note that serial, by omission, is an empty string
             handle_ = libusb_open_device_with_vid_pid(context_, vid, pid);  // If no serial number is specified, this will open the first device found with matching VID and PID
         } else {
@@ -703,36 +1469,96 @@ int CP2130::open(uint16_t vid, uint16_t pid, const std::string &serial)
             delete[] serialcstr;
         }
         if (handle_ == nullptr) {  // If the previous operation fails to get a device handle
-            libusb_exit(context_);  // Deinitialize libusb
             retval = ERROR_NOT_FOUND;
         } else {  // If the device is successfully opened and a handle obtained
-            if (libusb_kernel_driver_active(handle_, 0) == 1) {  // If a kernel driver is active on the interface
-                libusb_detach_kernel_driver(handle_, 0);  // Detach the kernel driver
-                kernelWasAttached_ = true;  // Flag that the kernel driver was attached
-            } else {
-                kernelWasAttached_ = false;  // The kernel driver was not attached
-            }
-            if (libusb_claim_interface(handle_, 0) != 0) {  // Claim the interface. In case of failure
-                if (kernelWasAttached_) {  // If a kernel driver was attached to the interface before
-                    libusb_attach_kernel_driver(handle_, 0);  // Reattach the kernel driver
-                }
-                libusb_close(handle_);  // Close the device
-                libusb_exit(context_);  // Deinitialize libusb
-                handle_ = nullptr;  // Required to mark the device as closed
-                retval = ERROR_BUSY;
+            retval = claimInterface();
+        }
+    }
+    return retval;
+}
+
+// Opens the device having the given serial number, as found in the given index, using the libusb context of the index (added in version 1.3.0)
+// Only that device is opened, and if it is not indexed, the index is refreshed once, so that devices connected after the last refresh can be found
+// As with the previous variant, the context is not deinitialized when the device is closed, and this variant never returns "ERROR_INIT"
+int CP2130::open(CP2130DeviceIndex &index, const std::string &serial)
+{
+    int retval;
+    if (isOpen()) {  // As with the other variants of open(), opening an already open object is harmless
+        retval = SUCCESS;
+    } else {
+        libusb_device *device = index.device(serial);
+        if (device == nullptr) {
+            int errcnt = 0;
+            std::string errstr;
+            index.refresh(errcnt, errstr);
+            device = index.device(serial);
+        }
+        if (device == nullptr) {  // If the device is not indexed, even after a refresh
+            retval = ERROR_NOT_FOUND;
+        } else {
+            context_ = index.context();
+            ownsContext_ = false;
+            if (libusb_open(device, &handle_) != 0) {  // Open the device. In case of failure
+                handle_ = nullptr;
+                retval = ERROR_NOT_FOUND;
             } else {
-                disconnected_ = false;  // Note that this flag is never assumed to be true for a device that was never opened - See constructor for details!
-                retval = SUCCESS;
+                retval = claimInterface();
             }
+            libusb_unref_device(device);  // The device is referenced by its handle from now on, if open
         }
     }
     return retval;
 }
 
+// Opens a device using the given transport instead of libusb, such as a simulated CP2130 (added in version 1.3.0)
+// The transport must outlive the object, or at least remain valid until close() is called
+int CP2130::open(CP2130Transport &transport)
+{
+    int retval;
+    if (isOpen()) {  // As with the other variant of open(), opening an already open object is harmless
+        retval = SUCCESS;
+    } else {
+        transport_ = &transport;
+        disconnected_ = false;
+        int errcnt = 0;
+        std::string errstr;
+        refreshEndpoints(errcnt, errstr);
+        retval = SUCCESS;
+    }
+    return retval;
+}
+
 // Issues a reset to the CP2130
 void CP2130::reset(int &errcnt, std::string &errstr)
 {
     controlTransfer(SET, RESET_DEVICE, 0x0000, 0x0000, nullptr, RESET_DEVICE_WLEN, errcnt, errstr);
+    endpointsCached_ = false;  // The transfer priority written to the OTP ROM may only take effect after a reset (added in version 1.3.0)
+    invalidateShadow();  // All settings return to their defaults after a reset (added in version 1.3.0)
+}
+
+// Resets every instrumentation counter (added in version 1.3.0)
+// Note that transfers that complete concurrently may or may not be accounted for
+void CP2130::resetStats()
+{
+    static_assert(sizeof(Counters::histogram) / sizeof(Counters::histogram[0]) == STATS_BUCKETS, "Histogram size mismatch");
+    static_assert(sizeof(requestCounters_) / sizeof(Counters) == sizeof(REQUEST_CODES) + 1, "Request counters size mismatch");
+    Counters *counters[] = {requestCounters_, endpointCounters_};
+    size_t sizes[] = {sizeof(requestCounters_) / sizeof(Counters), sizeof(endpointCounters_) / sizeof(Counters)};
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < sizes[i]; ++j) {
+            Counters &c = counters[i][j];
+            c.calls.store(0, std::memory_order_relaxed);
+            c.bytes.store(0, std::memory_order_relaxed);
+            c.shortTransfers.store(0, std::memory_order_relaxed);
+            c.timeouts.store(0, std::memory_order_relaxed);
+            c.disconnects.store(0, std::memory_order_relaxed);
+            c.errors.store(0, std::memory_order_relaxed);
+            c.totalLatency.store(0, std::memory_order_relaxed);
+            for (size_t k = 0; k < STATS_BUCKETS; ++k) {
+                c.histogram[k].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
 }
 
 // Enables the chip select of the target channel, disabling any others
@@ -742,11 +1568,7 @@ void CP2130::selectCS(uint8_t channel, int &errcnt, std::string &errstr)
         ++errcnt;
         errstr += "In selectCS(): SPI channel value must be between 0 and 10.\n";  // Program logic error
     } else {
-        unsigned char controlBufferOut[SET_GPIO_CHIP_SELECT_WLEN] = {
-            channel,  // Selected channel
-            0x02      // Only the corresponding chip select is enabled, all the others are disabled
-        };
-        controlTransfer(SET, SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, SET_GPIO_CHIP_SELECT_WLEN, errcnt, errstr);
+        setCSShadowed(channel, 0x02, static_cast<uint16_t>(0x0001 << channel), errcnt, errstr);  // Skipped if the chip select bitmap is known to remain the same (added in version 1.3.0)
     }
 }
 
@@ -756,7 +1578,14 @@ void CP2130::setClockDivider(uint8_t value, int &errcnt, std::string &errstr)
     unsigned char controlBufferOut[SET_CLOCK_DIVIDER_WLEN] = {
         value  // Intended clock divider value (GPIO.5 clock frequency = 24 MHz / divider)
     };
-    controlTransfer(SET, SET_CLOCK_DIVIDER, 0x0000, 0x0000, controlBufferOut, SET_CLOCK_DIVIDER_WLEN, errcnt, errstr);
+    shadowedTransfer(SET_CLOCK_DIVIDER, controlBufferOut, SET_CLOCK_DIVIDER_WLEN, shadow_.divider, shadow_.dividerValid, errcnt, errstr);  // Skipped if the clock divider is known to have the same value (added in version 1.3.0)
+}
+
+// Enables or disables the reporting of failed transfers via "errstr", which is enabled by default (added in version 1.3.0)
+// Disabling it avoids formatting messages on the transfer hot path, while "errcnt" is still incremented and every failure is still logged (see errorLog())
+void CP2130::setErrstrEnabled(bool enabled)
+{
+    errstrEnabled_ = enabled;
 }
 
 // Sets the event counter
@@ -851,129 +1680,227 @@ void CP2130::setGPIOs(uint16_t bmValues, uint16_t bmMask, int &errcnt, std::stri
         static_cast<uint8_t>((BMGPIOS & bmValues) >> 8), static_cast<uint8_t>(BMGPIOS & bmValues),  // GPIO values bitmap
         static_cast<uint8_t>((BMGPIOS & bmMask) >> 8), static_cast<uint8_t>(BMGPIOS & bmMask)       // Mask bitmap
     };
+    int preverrcnt = errcnt;
     controlTransfer(SET, SET_GPIO_VALUES, 0x0000, 0x0000, controlBufferOut, SET_GPIO_VALUES_WLEN, errcnt, errstr);
+    if (shadowEnabled_) {  // Keep the output levels in the shadow up to date (added in version 1.3.0)
+        for (size_t i = 0; i < 11; ++i) {
+            if ((GPIO_BITMAPS[i] & bmMask) != 0x0000) {
+                shadow_.gpio[i][2] = (GPIO_BITMAPS[i] & bmValues) != 0x0000;
+                shadow_.gpioValid[i] = shadow_.gpioValid[i] && errcnt == preverrcnt;
+            }
+        }
+    }
+}
+
+// Sets the number of bulk IN transfers that spiRead() keeps in flight, and also the number of WriteRead commands kept in flight by spiWriteRead() (values are clamped between 1 and "QDEPTH_MAX")
+// A depth of 1 restores the strict command/response sequence of previous versions in spiWriteRead(), so that no WriteRead command is ever issued after one that fails
+void CP2130::setQueueDepth(size_t depth)
+{
+    queueDepth_ = depth < 1 ? 1 : (depth > QDEPTH_MAX ? QDEPTH_MAX : depth);
+}
+
+// Enables or disables the shadow (added in version 1.3.0)
+// When enabled, the last known SPI mode and delays of each channel, chip select bitmap, GPIO configuration and clock divider are kept, and requests that would not change them are skipped
+// The shadow is filled by the corresponding getters and setters, and it starts empty whenever enabled
+void CP2130::setShadowEnabled(bool enabled)
+{
+    shadowEnabled_ = enabled;
+    invalidateShadow();
+}
+
+// Sets the supervisor used to reconnect to the device automatically, or disables automatic reconnection if a null pointer is passed (added in version 1.3.0)
+// While supervised, transfers issued after the device is disconnected are paused until it comes back (up to the timeout of the supervisor), and the device is then reopened and its last known SPI modes, delays, GPIO configuration, chip selects and clock divider are restored
+// Restoring relies on the shadow, which is enabled here if it is not already, and note that a bulk transfer that is interrupted by the disconnection still fails, since part of it may have reached the SPI bus, and so does a request that writes to the OTP ROM
+// The supervisor must outlive the device, and automatic reconnection is not supported by devices opened via a transport, for which every attempt to resume is reported as a failure
+void CP2130::setSupervisor(CP2130Supervisor *supervisor)
+{
+    supervisor_ = supervisor;
+    if (supervisor_ != nullptr && !shadowEnabled_) {
+        setShadowEnabled(true);
+    }
+}
+
+// Sets the maximum payload of each WriteRead command issued by spiWriteRead() (added in version 1.3.0)
+// Values are clamped between "WRITEREAD_CHUNK_MIN" and "WRITEREAD_CHUNK_MAX", and larger chunks mean fewer commands and round trips for the same amount of data, as long as the device keeps up with them
+// See deriveWriteReadChunk() and calibrateWriteReadChunk() for ways of choosing the value
+void CP2130::setWriteReadChunk(size_t chunk)
+{
+    writeReadChunk_ = chunk < WRITEREAD_CHUNK_MIN ? WRITEREAD_CHUNK_MIN : (chunk > WRITEREAD_CHUNK_MAX ? WRITEREAD_CHUNK_MAX : chunk);
+}
+
+// Requests and reads the given number of bytes from the SPI bus into the given buffer, returning the number of bytes actually read (added in version 1.3.0)
+// The buffer must have room for "bytesToRead" bytes, and no intermediate copy is made
+size_t CP2130::spiRead(uint8_t *data, uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
+{
+    unsigned char readCommandBuffer[CMD_HEADER_SIZE];
+    fillCommandHeader(readCommandBuffer, READ, bytesToRead);
+    size_t nchunks = (static_cast<size_t>(bytesToRead) + READ_CHUNK - 1) / READ_CHUNK;
+    segments_.resize(nchunks + 1);  // Segments are kept between calls, so this only allocates when a larger read is requested
+    segments_[0] = {endpointOutAddr, readCommandBuffer, static_cast<int>(sizeof(readCommandBuffer)), 0};
+    for (size_t i = 0; i < nchunks; ++i) {
+        size_t offset = i * READ_CHUNK;
+        segments_[i + 1] = {endpointInAddr, data + offset, static_cast<int>(bytesToRead - offset < READ_CHUNK ? bytesToRead - offset : READ_CHUNK), 0};
+    }
+    runPipeline(segments_.data(), segments_.size(), readDepth(), errcnt, errstr);
+    size_t bytesRead = 0;
+    for (size_t i = 1; i <= nchunks; ++i) {  // Only the data received before the first short or failed transfer is counted
+        bytesRead += static_cast<size_t>(segments_[i].transferred);
+        if (segments_[i].transferred != segments_[i].length) {
+            break;
+        }
+    }
+    return bytesRead;
+}
+
+// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced and, since version 1.3.0, cached)
+size_t CP2130::spiRead(uint8_t *data, uint32_t bytesToRead, int &errcnt, std::string &errstr)
+{
+    return spiRead(data, bytesToRead, getEndpointInAddr(errcnt, errstr), getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
 }
 
 // Requests and reads the given number of bytes from the SPI bus, and then returns a vector
 // This is the prefered method of reading from the bus, if both endpoint addresses are known
 std::vector<uint8_t> CP2130::spiRead(uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
 {
-    unsigned char readCommandBuffer[8] = {
-        0x00, 0x00,    // Reserved
-        CP2130::READ,  // Read command
-        0x00,          // Reserved
-        static_cast<uint8_t>(bytesToRead),
-        static_cast<uint8_t>(bytesToRead >> 8),
-        static_cast<uint8_t>(bytesToRead >> 16),
-        static_cast<uint8_t>(bytesToRead >> 24)
-    };
+    std::vector<uint8_t> retdata(static_cast<size_t>(bytesToRead));  // Since version 1.3.0, data is read directly into the returned vector
+    retdata.resize(spiRead(retdata.data(), bytesToRead, endpointInAddr, endpointOutAddr, errcnt, errstr));
+    return retdata;
+}
+
+// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced and, since version 1.3.0, cached)
+std::vector<uint8_t> CP2130::spiRead(uint32_t bytesToRead, int &errcnt, std::string &errstr)
+{
+    return spiRead(bytesToRead, getEndpointInAddr(errcnt, errstr), getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
+}
+
+// Writes to the SPI bus, using the payload found in the given buffer, after the reserved header space (added in version 1.3.0)
+// The buffer must have room for "CMD_HEADER_SIZE" bytes followed by "bytesToWrite" bytes of payload, and the header is filled in place, so that the payload is never copied
+void CP2130::spiWrite(uint8_t *buffer, uint32_t bytesToWrite, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
+{
+    fillCommandHeader(buffer, WRITE, bytesToWrite);
+    int bufSize = static_cast<int>(bytesToWrite + CMD_HEADER_SIZE);
 #if LIBUSB_API_VERSION >= 0x01000105
-    bulkTransfer(endpointOutAddr, readCommandBuffer, static_cast<int>(sizeof(readCommandBuffer)), nullptr, errcnt, errstr);
+    bulkTransfer(endpointOutAddr, buffer, bufSize, nullptr, errcnt, errstr);
 #else
     int bytesWritten;
-    bulkTransfer(endpointOutAddr, readCommandBuffer, static_cast<int>(sizeof(readCommandBuffer)), &bytesWritten, errcnt, errstr);
+    bulkTransfer(endpointOutAddr, buffer, bufSize, &bytesWritten, errcnt, errstr);
 #endif
-    unsigned char *readInputBuffer = new unsigned char[bytesToRead];  // Allocated dynamically since version 1.1.0
-    int bytesRead = 0;  // Important!
-    bulkTransfer(endpointInAddr, readInputBuffer, static_cast<int>(bytesToRead), &bytesRead, errcnt, errstr);
-    std::vector<uint8_t> retdata(static_cast<size_t>(bytesRead));
-    for (int i = 0; i < bytesRead; ++i) {
-        retdata[i] = readInputBuffer[i];
-    }
-    delete[] readInputBuffer;
-    return retdata;
 }
 
-// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced, at the cost of decreased speed)
-std::vector<uint8_t> CP2130::spiRead(uint32_t bytesToRead, int &errcnt, std::string &errstr)
+// This function is a shorthand version of the previous one (the endpoint OUT address is automatically deduced and, since version 1.3.0, cached)
+void CP2130::spiWrite(uint8_t *buffer, uint32_t bytesToWrite, int &errcnt, std::string &errstr)
 {
-    return spiRead(bytesToRead, getEndpointInAddr(errcnt, errstr), getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
+    spiWrite(buffer, bytesToWrite, getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
 }
 
 // Writes to the SPI bus, using the given vector
 // This is the prefered method of writing to the bus, if the endpoint OUT address is known
 void CP2130::spiWrite(const std::vector<uint8_t> &data, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
 {
-    uint32_t bytesToWrite = static_cast<uint32_t>(data.size());
-    int bufSize = bytesToWrite + 8;
-    unsigned char *writeCommandBuffer = new unsigned char[bufSize] {  // Allocated dynamically since version 1.1.0
-        0x00, 0x00,     // Reserved
-        CP2130::WRITE,  // Write command
-        0x00,           // Reserved
-        static_cast<uint8_t>(bytesToWrite),
-        static_cast<uint8_t>(bytesToWrite >> 8),
-        static_cast<uint8_t>(bytesToWrite >> 16),
-        static_cast<uint8_t>(bytesToWrite >> 24)
-    };
-    for (size_t i = 0; i < bytesToWrite; ++i) {
-        writeCommandBuffer[i + 8] = data[i];
+    if (disconnected_ && supervisor_ != nullptr && !resuming_) {  // If the device is supervised, it is resumed before the command buffer is obtained, since reopening the device gives that buffer back to the pool (added in version 1.3.0)
+        resume(errcnt, errstr);
     }
-#if LIBUSB_API_VERSION >= 0x01000105
-    bulkTransfer(endpointOutAddr, writeCommandBuffer, bufSize, nullptr, errcnt, errstr);
-#else
-    int bytesWritten;
-    bulkTransfer(endpointOutAddr, writeCommandBuffer, bufSize, &bytesWritten, errcnt, errstr);
-#endif
-    delete[] writeCommandBuffer;
+    uint32_t bytesToWrite = static_cast<uint32_t>(data.size());
+    unsigned char *commandBuffer = reserveCommandBuffer(bytesToWrite + CMD_HEADER_SIZE);  // Since version 1.3.0, the command buffer is kept between calls, so this only allocates when a larger write is requested
+    std::copy(data.begin(), data.end(), commandBuffer + CMD_HEADER_SIZE);
+    spiWrite(commandBuffer, bytesToWrite, endpointOutAddr, errcnt, errstr);
 }
 
-// This function is a shorthand version of the previous one (the endpoint OUT address is automatically deduced at the cost of decreased speed)
+// This function is a shorthand version of the previous one (the endpoint OUT address is automatically deduced and, since version 1.3.0, cached)
 void CP2130::spiWrite(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr)
 {
     spiWrite(data, getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
 }
 
+// Writes the given number of bytes to the SPI bus while reading back into the given buffer, returning the number of bytes actually read (added in version 1.3.0)
+// Both buffers must have room for "bytesToWriteRead" bytes, and no memory is allocated once the internal buffers have grown to the required size
+// Note that, if a chunk fails, the WriteRead commands of up to three chunks that follow (one less than the number kept in flight, see setQueueDepth()) may have already reached the device, in which case their data is still clocked out on the SPI bus, although the data read back is discarded
+size_t CP2130::spiWriteRead(const uint8_t *dataOut, uint8_t *dataIn, size_t bytesToWriteRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
+{
+    if (disconnected_ && supervisor_ != nullptr && !resuming_) {  // If the device is supervised, it is resumed before the command buffer is obtained, since reopening the device gives that buffer back to the pool (added in version 1.3.0)
+        resume(errcnt, errstr);
+    }
+    size_t chunkSize = writeReadChunk_;  // The chunk size is configurable since version 1.3.0 (see setWriteReadChunk())
+    size_t frameSize = chunkSize + CMD_HEADER_SIZE;
+    size_t nchunks = (bytesToWriteRead + chunkSize - 1) / chunkSize;
+    unsigned char *commandBuffer = reserveCommandBuffer(nchunks * frameSize);  // All command buffers are allocated at once, and kept between calls
+    segments_.resize(2 * nchunks);
+    for (size_t i = 0; i < nchunks; ++i) {
+        size_t bytesProcessed = i * chunkSize;
+        uint32_t payload = static_cast<uint32_t>(std::min(chunkSize, bytesToWriteRead - bytesProcessed));
+        unsigned char *writeReadCommandBuffer = commandBuffer + i * frameSize;
+        fillCommandHeader(writeReadCommandBuffer, WRITEREAD, payload);
+        std::memcpy(writeReadCommandBuffer + CMD_HEADER_SIZE, dataOut + bytesProcessed, payload);
+        segments_[2 * i] = {endpointOutAddr, writeReadCommandBuffer, static_cast<int>(payload + CMD_HEADER_SIZE), 0};
+        segments_[2 * i + 1] = {endpointInAddr, dataIn + bytesProcessed, static_cast<int>(payload), 0};
+    }
+    runPipeline(segments_.data(), segments_.size(), writeReadDepth(), errcnt, errstr);
+    size_t bytesRead = 0;
+    for (size_t i = 0; i < nchunks; ++i) {  // As before, the data of any chunks that follow an error is discarded
+        bytesRead += static_cast<size_t>(segments_[2 * i + 1].transferred);
+        if (segments_[2 * i].transferred != segments_[2 * i].length || segments_[2 * i + 1].transferred != segments_[2 * i + 1].length) {
+            break;
+        }
+    }
+    return bytesRead;
+}
+
+// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced and, since version 1.3.0, cached)
+size_t CP2130::spiWriteRead(const uint8_t *dataOut, uint8_t *dataIn, size_t bytesToWriteRead, int &errcnt, std::string &errstr)
+{
+    return spiWriteRead(dataOut, dataIn, bytesToWriteRead, getEndpointInAddr(errcnt, errstr), getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
+}
+
 // Writes to the SPI bus while reading back, returning a vector of the same size as the one given
 // This is the prefered method of writing and reading, if both endpoint addresses are known
 std::vector<uint8_t> CP2130::spiWriteRead(const std::vector<uint8_t> &data, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
 {
-    size_t bytesToWriteRead = data.size();
-    size_t bytesProcessed = 0;  // Loop control variable implemented in version 1.2.3, to replace "bytesLeft"
-    std::vector<uint8_t> retdata;
-    int preverrcnt = errcnt;
-    while (bytesProcessed < bytesToWriteRead && preverrcnt == errcnt) {  // The extra condition breaks the loop in case of error (added in version 1.2.4)
-        size_t bytesRemaining = bytesToWriteRead - bytesProcessed;  // Equivalent to the variable "bytesLeft" found in version 1.2.2, except that it is no longer used for control
-        uint32_t payload = static_cast<uint32_t>(bytesRemaining > 56 ? 56 : bytesRemaining);
-        int bufSize = payload + 8;
-        unsigned char *writeReadCommandBuffer = new unsigned char[bufSize] {
-            0x00, 0x00,         // Reserved
-            CP2130::WRITEREAD,  // WriteRead command
-            0x00,               // Reserved
-            static_cast<uint8_t>(payload),
-            static_cast<uint8_t>(payload >> 8),
-            static_cast<uint8_t>(payload >> 16),
-            static_cast<uint8_t>(payload >> 24)
-        };
-        for (size_t i = 0; i < payload; ++i) {
-            writeReadCommandBuffer[i + 8] = data[bytesProcessed + i];
-        }
-#if LIBUSB_API_VERSION >= 0x01000105
-        bulkTransfer(endpointOutAddr, writeReadCommandBuffer, bufSize, nullptr, errcnt, errstr);
-#else
-        int bytesWritten;
-        bulkTransfer(endpointOutAddr, writeReadCommandBuffer, bufSize, &bytesWritten, errcnt, errstr);
-#endif
-        delete[] writeReadCommandBuffer;
-        unsigned char *writeReadInputBuffer = new unsigned char[payload];
-        int bytesRead = 0;  // Important!
-        bulkTransfer(endpointInAddr, writeReadInputBuffer, payload, &bytesRead, errcnt, errstr);
-        size_t prevretdataSize = retdata.size();
-        retdata.resize(static_cast<size_t>(prevretdataSize + bytesRead));  // Optimization implemented in version 1.2.2, and fixed in version 1.2.3
-        for (int i = 0; i < bytesRead; ++i) {
-            retdata[prevretdataSize + i] = writeReadInputBuffer[i];  // Note that std::vector::push_back() is no longer used since version 1.2.2, because it is more efficient to resize the vector only once per iteration (see above), so that the values may be simply assigned (fixed in version 1.2.3)
-        }
-        delete[] writeReadInputBuffer;
-        bytesProcessed += payload;  // Note that, since version 1.2.3, the loop control variable is added to (it is generaly a bad idea to subtract from a unsigned variable, because it can lead to a overflow that may go unchecked)
-    }
+    std::vector<uint8_t> retdata(data.size());  // Since version 1.3.0, data is read directly into the returned vector
+    retdata.resize(spiWriteRead(data.data(), retdata.data(), data.size(), endpointInAddr, endpointOutAddr, errcnt, errstr));
     return retdata;
 }
 
-// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced, at the cost of decreased speed)
+// This function is a shorthand version of the previous one (both endpoint addresses are automatically deduced and, since version 1.3.0, cached)
 std::vector<uint8_t> CP2130::spiWriteRead(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr)
 {
     return spiWriteRead(data, getEndpointInAddr(errcnt, errstr), getEndpointOutAddr(errcnt, errstr), errcnt, errstr);
 }
 
+// Submits an asynchronous transfer to the device on behalf of a background thread, returning the libusb error code (added in version 1.3.0)
+// Unlike submitTransfer(), failures are neither reported nor logged, and the device is not marked as disconnected, so that the state of the object is left untouched while another thread uses it
+int CP2130::submitBackgroundTransfer(libusb_transfer *transfer)
+{
+    int retval;
+    if (!isOpen()) {
+        retval = LIBUSB_ERROR_NO_DEVICE;
+    } else {
+        transfer->dev_handle = handle_;
+        retval = transport_ == nullptr ? libusb_submit_transfer(transfer) : transport_->submitTransfer(transfer);
+    }
+    return retval;
+}
+
+// Submits an asynchronous transfer to the device (added in version 1.3.0)
+// The transfer can be filled with libusb_fill_bulk_transfer() or libusb_fill_control_transfer() beforehand, and its device handle is set here
+// Once submitted, the transfer completes when handleEvents() is called, and its outcome can be verified using checkTransfer()
+void CP2130::submitTransfer(libusb_transfer *transfer, int &errcnt, std::string &errstr)
+{
+    if (!isOpen()) {
+        ++errcnt;
+        errstr += "In submitTransfer(): device is not open.\n";  // Program logic error
+    } else {
+        transfer->dev_handle = handle_;
+        int result = transport_ == nullptr ? libusb_submit_transfer(transfer) : transport_->submitTransfer(transfer);
+        if (result != 0) {
+            if (transfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+                controlTransferFailed(transfer->buffer[0], transfer->buffer[1], result, errcnt, errstr);
+            } else {
+                bulkTransferFailed(transfer->endpoint, result, errcnt, errstr);
+            }
+        }
+    }
+}
+
 // Aborts the current ReadWithRTR command
 void CP2130::stopRTR(int &errcnt, std::string &errstr)
 {
@@ -983,6 +1910,17 @@ void CP2130::stopRTR(int &errcnt, std::string &errstr)
     controlTransfer(SET, SET_RTR_STOP, 0x0000, 0x0000, controlBufferOut, SET_RTR_STOP_WLEN, errcnt, errstr);
 }
 
+// Releases the event lock of the device, taken by lockEvents() (added in version 1.3.0)
+void CP2130::unlockEvents()
+{
+    eventMutex_.unlock();
+    std::lock_guard<std::mutex> lock(eventWaitersMutex_);
+    --eventWaiters_;
+    if (eventWaiters_ == 0) {
+        eventsReleased_.notify_all();
+    }
+}
+
 // This procedure is used to lock fields in the CP2130 OTP ROM - Use with care!
 void CP2130::writeLockWord(uint16_t word, int &errcnt, std::string &errstr)
 {
@@ -1074,38 +2012,160 @@ void CP2130::writeUSBConfig(const USBConfig &config, uint8_t mask, int &errcnt,
         mask                                                                      // Write mask (can be obtained using the return value of getLockWord(), after being bitwise ANDed with "LWUSBCFG" [0x009f] and the resulting value cast to uint8_t)
     };
     controlTransfer(SET, SET_USB_CONFIG, PROM_WRITE_KEY, 0x0000, controlBufferOut, SET_USB_CONFIG_WLEN, errcnt, errstr);
+    if ((LWTRFPRIO & mask) != 0x00) {  // If the transfer priority was written, the cached endpoint addresses must be refreshed (added in version 1.3.0)
+        endpointsCached_ = false;
+    }
 }
 
-// Helper function to list devices
-std::list<std::string> CP2130::listDevices(uint16_t vid, uint16_t pid, int &errcnt, std::string &errstr)
+// Decodes a descriptor from its table and, in the case of the manufacturer and product descriptors, from the table that follows (added in version 1.3.0)
+// For the serial descriptor, which fits in one table, "nextTable" should be a null pointer
+std::u16string CP2130::decodeDesc(const unsigned char *table, const unsigned char *nextTable)
 {
-    std::list<std::string> devices;
-    libusb_context *context;
-    if (libusb_init(&context) != 0) {  // Initialize libusb. In case of failure
-        ++errcnt;
-        errstr += "Could not initialize libusb.\n";
-    } else {  // If libusb is initialized
-        libusb_device **devs;
-        ssize_t devlist = libusb_get_device_list(context, &devs);  // Get a device list
-        if (devlist < 0) {  // If the previous operation fails to get a device list
-            ++errcnt;
-            errstr += "Failed to retrieve a list of devices.\n";
-        } else {
-            for (ssize_t i = 0; i < devlist; ++i) {  // Run through all listed devices
-                libusb_device_descriptor desc;
-                if (libusb_get_device_descriptor(devs[i], &desc) == 0 && desc.idVendor == vid && desc.idProduct == pid) {  // If the device descriptor is retrieved, and both VID and PID correspond to the respective given values
-                    libusb_device_handle *handle;
-                    if (libusb_open(devs[i], &handle) == 0) {  // Open the listed device. If successfull
-                        unsigned char str_desc[256];
-                        libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, str_desc, static_cast<int>(sizeof(str_desc)));  // Get the serial number string in ASCII format
-                        devices.push_back(reinterpret_cast<char *>(str_desc));  // Add the serial number string to the list
-                        libusb_close(handle);  // Close the device
-                    }
-                }
+    std::u16string descriptor;
+    size_t length = table[0];
+    size_t end = length > DESC_MAXIDX ? DESC_MAXIDX : length;
+    for (size_t i = 2; i < end; i += 2) {  // Process first 30 characters (bytes 2-61 of the table)
+        if (table[i] != 0 || table[i + 1] != 0) {  // Filter out null characters
+            descriptor += static_cast<char16_t>(table[i + 1] << 8 | table[i]);  // UTF-16LE conversion as per the USB 2.0 specification
+        }
+    }
+    if (nextTable != nullptr && length > DESC_MAXIDX) {
+        char16_t midchar = static_cast<char16_t>(nextTable[0] << 8 | table[DESC_MAXIDX]);  // Reconstruct the char in the middle (parted between two tables)
+        if (midchar != 0x0000) {  // Filter out the reconstructed char if the same is null
+            descriptor += midchar;
+        }
+        end = length - DESC_IDXINCR;
+        for (size_t i = 1; i < end; i += 2) {  // Process remaining characters, up to 31 (bytes 1-62 of the next table)
+            if (nextTable[i] != 0 || nextTable[i + 1] != 0) {  // Again, filter out null characters
+                descriptor += static_cast<char16_t>(nextTable[i + 1] << 8 | nextTable[i]);  // UTF-16LE conversion as per the USB 2.0 specification
             }
-            libusb_free_device_list(devs, 1);  // Free device list
         }
-        libusb_exit(context);  // Deinitialize libusb
     }
-    return devices;
+    return descriptor;
+}
+
+// Decodes an event counter, as returned by Get_Event_Counter (added in version 1.3.0)
+CP2130::EventCounter CP2130::decodeEventCounter(const unsigned char *data)
+{
+    EventCounter evtcntr;
+    evtcntr.overflow = (0x80 & data[0]) != 0x00;                    // Event counter overflow bit corresponds to bit 7 of byte 0
+    evtcntr.mode = static_cast<uint8_t>(0x07 & data[0]);            // GPIO.4/EVTCNTR pin mode corresponds to bits 2:0 of byte 0
+    evtcntr.value = static_cast<uint16_t>(data[1] << 8 | data[2]);  // Event count value corresponds to bytes 1 and 2 (big-endian conversion)
+    return evtcntr;
+}
+
+// Decodes the value of every GPIO pin in bitmap format, as returned by Get_GPIO_Values (added in version 1.3.0)
+uint16_t CP2130::decodeGPIOs(const unsigned char *data)
+{
+    return static_cast<uint16_t>(BMGPIOS & (data[0] << 8 | data[1]));  // Big-endian conversion
+}
+
+// Decodes a pin configuration, as returned by Get_Pin_Config (added in version 1.3.0)
+CP2130::PinConfig CP2130::decodePinConfig(const unsigned char *data)
+{
+    PinConfig config;
+    config.gpio0 = data[0];                                              // GPIO.0 pin config corresponds to byte 0
+    config.gpio1 = data[1];                                              // GPIO.1 pin config corresponds to byte 1
+    config.gpio2 = data[2];                                              // GPIO.2 pin config corresponds to byte 2
+    config.gpio3 = data[3];                                              // GPIO.3 pin config corresponds to byte 3
+    config.gpio4 = data[4];                                              // GPIO.4 pin config corresponds to byte 4
+    config.gpio5 = data[5];                                              // GPIO.5 pin config corresponds to byte 5
+    config.gpio6 = data[6];                                              // GPIO.6 pin config corresponds to byte 6
+    config.gpio7 = data[7];                                              // GPIO.7 pin config corresponds to byte 7
+    config.gpio8 = data[8];                                              // GPIO.8 pin config corresponds to byte 8
+    config.gpio9 = data[9];                                              // GPIO.9 pin config corresponds to byte 9
+    config.gpio10 = data[10];                                            // GPIO.10 pin config corresponds to byte 10
+    config.sspndlvl = static_cast<uint16_t>(data[11] << 8 | data[12]);   // Suspend pin level bitmap corresponds to bytes 11 and 12 (big-endian conversion)
+    config.sspndmode = static_cast<uint16_t>(data[13] << 8 | data[14]);  // Suspend pin mode bitmap corresponds to bytes 13 and 14 (big-endian conversion)
+    config.wkupmask = static_cast<uint16_t>(data[15] << 8 | data[16]);   // Wakeup pin mask bitmap corresponds to bytes 15 and 16 (big-endian conversion)
+    config.wkupmatch = static_cast<uint16_t>(data[17] << 8 | data[18]);  // Wakeup pin match bitmap corresponds to bytes 17 and 18 (big-endian conversion)
+    config.divider = data[19];                                           // Clock divider corresponds to byte 19
+    return config;
+}
+
+// Decodes the SPI delays of a channel, as returned by Get_SPI_Delay from byte 1 onwards (added in version 1.3.0)
+CP2130::SPIDelays CP2130::decodeSPIDelays(const unsigned char *data)
+{
+    SPIDelays delays;
+    delays.cstglen = (0x08 & data[0]) != 0x00;                         // CS toggle enable corresponds to bit 3 of the enable mask
+    delays.prdasten = (0x04 & data[0]) != 0x00;                        // Pre-deassert delay enable corresponds to bit 2 of the enable mask
+    delays.pstasten = (0x02 & data[0]) != 0x00;                        // Post-assert delay enable to bit 1 of the enable mask
+    delays.itbyten = (0x01 & data[0]) != 0x00;                         // Inter-byte delay enable corresponds to bit 0 of the enable mask
+    delays.itbytdly = static_cast<uint16_t>(data[1] << 8 | data[2]);   // Inter-byte delay follows the enable mask (big-endian conversion)
+    delays.pstastdly = static_cast<uint16_t>(data[3] << 8 | data[4]);  // Post-assert delay follows the inter-byte delay (big-endian conversion)
+    delays.prdastdly = static_cast<uint16_t>(data[5] << 8 | data[6]);  // Pre-deassert delay follows the post-assert delay (big-endian conversion)
+    return delays;
+}
+
+// Decodes the SPI mode of a channel from its control word, as returned by Get_SPI_Word (added in version 1.3.0)
+CP2130::SPIMode CP2130::decodeSPIMode(uint8_t word)
+{
+    SPIMode mode;
+    mode.csmode = (0x08 & word) != 0x00;            // Chip select mode corresponds to bit 3
+    mode.cfrq = static_cast<uint8_t>(0x07 & word);  // Clock frequency is set in the bits 2:0
+    mode.cpha = (0x20 & word) != 0x00;              // Clock phase corresponds to bit 5
+    mode.cpol = (0x10 & word) != 0x00;              // Clock polarity corresponds to bit 4
+    return mode;
+}
+
+// Decodes a USB configuration, as returned by Get_USB_Config (added in version 1.3.0)
+CP2130::USBConfig CP2130::decodeUSBConfig(const unsigned char *data)
+{
+    USBConfig config;
+    config.vid = static_cast<uint16_t>(data[1] << 8 | data[0]);  // VID corresponds to bytes 0 and 1 (little-endian conversion)
+    config.pid = static_cast<uint16_t>(data[3] << 8 | data[2]);  // PID corresponds to bytes 2 and 3 (little-endian conversion)
+    config.majrel = data[6];                                     // Major release version corresponds to byte 6
+    config.minrel = data[7];                                     // Minor release version corresponds to byte 7
+    config.maxpow = data[4];                                     // Maximum power consumption corresponds to byte 4
+    config.powmode = data[5];                                    // Power mode corresponds to byte 5
+    config.trfprio = data[8];                                    // Transfer priority corresponds to byte 8
+    return config;
+}
+
+// Fills the header of a bulk command, which takes "CMD_HEADER_SIZE" bytes at the start of the given buffer (added in version 1.3.0)
+void CP2130::fillCommandHeader(unsigned char *buffer, uint8_t command, uint32_t length)
+{
+    buffer[0] = 0x00;                               // Reserved
+    buffer[1] = 0x00;                               // Reserved
+    buffer[2] = command;                            // Command
+    buffer[3] = 0x00;                               // Reserved
+    buffer[4] = static_cast<uint8_t>(length);       // Payload length (little-endian)
+    buffer[5] = static_cast<uint8_t>(length >> 8);
+    buffer[6] = static_cast<uint8_t>(length >> 16);
+    buffer[7] = static_cast<uint8_t>(length >> 24);
+}
+
+// Helper function to list devices
+std::list<std::string> CP2130::listDevices(uint16_t vid, uint16_t pid, int &errcnt, std::string &errstr)
+{
+    CP2130DeviceIndex index(vid, pid);  // Since version 1.3.0, devices are listed via a temporary index (use CP2130DeviceIndex directly in order to keep the index, and open devices from it)
+    index.refresh(errcnt, errstr);
+    return index.serials();
+}
+
+// Converts the status of an asynchronous transfer into the error code that the equivalent synchronous transfer would return (added in version 1.3.0)
+// A short transfer is not considered a failure here, so the number of bytes actually transferred must be verified separately
+int CP2130::transferResult(libusb_transfer_status status)
+{
+    int result;
+    switch (status) {
+        case LIBUSB_TRANSFER_COMPLETED:
+            result = 0;
+            break;
+        case LIBUSB_TRANSFER_TIMED_OUT:
+            result = LIBUSB_ERROR_TIMEOUT;
+            break;
+        case LIBUSB_TRANSFER_STALL:
+            result = LIBUSB_ERROR_PIPE;
+            break;
+        case LIBUSB_TRANSFER_NO_DEVICE:
+            result = LIBUSB_ERROR_NO_DEVICE;
+            break;
+        case LIBUSB_TRANSFER_OVERFLOW:
+            result = LIBUSB_ERROR_OVERFLOW;
+            break;
+        default:
+            result = LIBUSB_ERROR_IO;  // Same as libusb_bulk_transfer() for "LIBUSB_TRANSFER_ERROR" and "LIBUSB_TRANSFER_CANCELLED"
+    }
+    return result;
 }
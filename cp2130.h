@@ -1,5 +1,5 @@
-/* CP2130 class - Version 1.2.6
-   Copyright (c) 2021-2024 Samuel Lourenço
+/* CP2130 class - Version 1.3.0
+   Copyright (c) 2021-2026 Samuel Lourenço
 
    This library is free software: you can redistribute it and/or modify it
    under the terms of the GNU Lesser General Public License as published by
@@ -22,20 +22,84 @@
 #define CP2130_H
 
 // Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <list>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <libusb-1.0/libusb.h>
+#include "cp2130bufferpool.h"
+#include "cp2130errorlog.h"
+
+class CP2130DeviceIndex;
+class CP2130Supervisor;
+class CP2130Transport;
 
 class CP2130
 {
 private:
     libusb_context *context_;
     libusb_device_handle *handle_;
-    bool disconnected_, kernelWasAttached_;
+    CP2130Transport *transport_;
+    CP2130Supervisor *supervisor_;
+    bool disconnected_, kernelWasAttached_, ownsContext_, endpointsCached_, shadowEnabled_, errstrEnabled_, resuming_;
+    uint8_t endpointInAddr_, endpointOutAddr_;
+    size_t queueDepth_, writeReadChunk_;
+    std::vector<libusb_transfer *> transfers_;
+    unsigned char *commandBuffer_;  // Command buffer kept between calls, which is obtained from "bufferPool_"
+    size_t commandBufferSize_;
+
+    struct BulkSegment {
+        uint8_t endpointAddr;   // Endpoint address
+        unsigned char *buffer;  // Data buffer
+        int length;             // Number of bytes to transfer
+        int transferred;        // Number of bytes actually transferred
+    };
+
+    std::vector<BulkSegment> segments_;
+
+    struct Shadow {
+        unsigned char spiWord[11][2];   // Last Set_SPI_Word payload for each channel
+        unsigned char spiDelay[11][8];  // Last Set_SPI_Delay payload for each channel
+        unsigned char gpio[11][3];      // Last Set_GPIO_Mode_And_Level payload for each pin
+        unsigned char divider[1];       // Last Set_Clock_Divider payload
+        uint16_t cs;                    // Chip select enable bitmap (bit N corresponds to channel N)
+        bool spiWordValid[11], spiDelayValid[11], gpioValid[11], dividerValid, csValid;
+    } shadow_, restore_;  // The latter keeps the shadow as it was when the device was disconnected
 
+    struct Counters {
+        std::atomic<uint64_t> calls, bytes, shortTransfers, timeouts, disconnects, errors, totalLatency;
+        std::atomic<uint64_t> histogram[24];  // Must have "STATS_BUCKETS" elements (checked in resetStats())
+    };
+
+    Counters requestCounters_[39];  // Control transfers, one per request code of the CP2130, plus one shared by any other request code
+    Counters endpointCounters_[2];   // Bulk transfers, indexed by direction (OUT, then IN), since the CP2130 has one bulk endpoint per direction
+    CP2130ErrorLog errorLog_;
+    CP2130BufferPool bufferPool_;
+    std::recursive_mutex eventMutex_;         // Held while handling events, and by the operations that read the state changed by their own callbacks (see lockEvents())
+    std::mutex eventWaitersMutex_;
+    std::condition_variable eventsReleased_;  // Signaled once no thread holds or waits for "eventMutex_"
+    size_t eventWaiters_;                     // Number of threads that hold or wait for "eventMutex_"
+
+    size_t bulkPacketSize(int &errcnt, std::string &errstr);
+    void bulkTransferFailed(uint8_t endpointAddr, int result, int &errcnt, std::string &errstr);
+    int claimInterface();
+    void controlTransferFailed(uint8_t bmRequestType, uint8_t bRequest, int result, int &errcnt, std::string &errstr);
     std::u16string getDescGeneric(uint8_t command, int &errcnt, std::string &errstr);
+    void markDisconnected();
+    void recordTransfer(Counters &counters, int length, int transferred, int result, std::chrono::steady_clock::duration latency);
+    void refreshEndpoints(int &errcnt, std::string &errstr);
+    unsigned char *reserveCommandBuffer(size_t size);
+    void resetBufferPool(libusb_device_handle *handle);
+    void restoreState(Shadow &state, int &errcnt, std::string &errstr);
+    void resume(int &errcnt, std::string &errstr);
+    void runPipeline(BulkSegment *segments, size_t count, size_t depth, int &errcnt, std::string &errstr);
+    void setCSShadowed(uint8_t channel, uint8_t control, uint16_t cs, int &errcnt, std::string &errstr);
+    void shadowedTransfer(uint8_t bRequest, unsigned char *data, uint16_t wLength, unsigned char *shadow, bool &valid, int &errcnt, std::string &errstr);
     void writeDescGeneric(const std::u16string &descriptor, uint8_t command, int &errcnt, std::string &errstr);
 
 public:
@@ -47,6 +111,24 @@ public:
     static const int ERROR_NOT_FOUND = 2;  // Returned by open() if the device was not found
     static const int ERROR_BUSY = 3;       // Returned by open() if the device is already in use
 
+    // Pipelining specific definitions
+    static const size_t QDEPTH_DEFAULT = 4;  // Default number of bulk IN transfers kept in flight by spiRead(), or WriteRead commands by spiWriteRead()
+    static const size_t QDEPTH_MAX = 64;     // Maximum number of bulk IN transfers kept in flight by spiRead() (spiWriteRead() uses up to four)
+    static const size_t READ_CHUNK = 4096;        // Size of each bulk IN transfer issued by spiRead(), which must be a multiple of 64 so that only the last packet can be short
+    static const size_t WRITEREAD_DEPTH_MAX = 4;  // Maximum number of WriteRead commands whose responses are awaited at once by spiWriteRead(), which keeps them within what the device can buffer
+
+    // WriteRead chunk sizing specific definitions
+    static const size_t WRITEREAD_CHUNK_DEFAULT = 56;  // Default payload of each WriteRead command issued by spiWriteRead(), so that the command and its payload fit in a single 64-byte packet
+    static const size_t WRITEREAD_CHUNK_MIN = 8;       // Minimum payload of each WriteRead command
+    static const size_t WRITEREAD_CHUNK_MAX = 4088;    // Maximum payload of each WriteRead command, so that the command and its payload fit in 64 packets of 64 bytes
+
+    // Timing specific definitions
+    static const unsigned int TR_TIMEOUT = 500;      // Transfer timeout in milliseconds
+    static const unsigned int EVENT_INTERVAL = 100;  // Interval in milliseconds between the checks made while waiting for asynchronous transfers
+
+    // Instrumentation specific definitions
+    static const size_t STATS_BUCKETS = 24;  // Number of buckets in each latency histogram (bucket 0 counts transfers under 1us, and bucket N those from 2^(N-1)us to under 2^Nus, with the last one also counting anything slower)
+
     // Descriptor specific definitions
     static const size_t DESCMXL_MANUFACTURER = 62;  // Maximum length of manufacturer descriptor
     static const size_t DESCMXL_PRODUCT = 62;       // Maximum length of product descriptor
@@ -87,6 +169,7 @@ public:
     static const size_t PROMSZE_LOCK_BYTE = 2;                      // 'Lock Byte' field size
 
     // The following values are applicable to bulkTransfer()
+    static const size_t CMD_HEADER_SIZE = 8;  // Size of the command header that precedes the payload (also the headroom required by spiWrite(uint8_t *, ...))
     static const uint8_t READ = 0x00;         // Read command
     static const uint8_t WRITE = 0x01;        // Write command
     static const uint8_t WRITEREAD = 0x02;    // WriteRead command
@@ -313,6 +396,17 @@ public:
         bool operator !=(const SPIMode &other) const;
     };
 
+    struct TransferStats {
+        uint64_t calls;                     // Number of transfers
+        uint64_t bytes;                     // Number of bytes actually transferred
+        uint64_t shortTransfers;            // Number of transfers that moved fewer bytes than requested, without failing otherwise
+        uint64_t timeouts;                  // Number of transfers that timed out
+        uint64_t disconnects;               // Number of transfers that failed because the device was disconnected
+        uint64_t errors;                    // Number of transfers that failed for any other reason
+        uint64_t totalLatency;              // Sum of the latencies of all transfers, in microseconds
+        uint64_t histogram[STATS_BUCKETS];  // Latency histogram (see "STATS_BUCKETS" for details)
+    };
+
     struct USBConfig {
         uint16_t vid;     // Vendor ID (little-endian)
         uint16_t pid;     // Product ID (little-endian)
@@ -329,15 +423,36 @@ public:
     CP2130();
     ~CP2130();
 
+    CP2130(const CP2130 &) = delete;
+    CP2130 &operator =(const CP2130 &) = delete;
+
+    libusb_context *context() const;
     bool disconnected() const;
+    TransferStats endpointStats(uint8_t endpointAddr) const;
+    const CP2130ErrorLog &errorLog() const;
+    bool errstrEnabled() const;
     bool isOpen() const;
-
+    size_t queueDepth() const;
+    size_t readDepth() const;
+    TransferStats requestStats(uint8_t bRequest) const;
+    bool shadowEnabled() const;
+    CP2130Supervisor *supervisor() const;
+    size_t writeReadChunk() const;
+    size_t writeReadDepth() const;
+
+    CP2130BufferPool &bufferPool();
     void bulkTransfer(uint8_t endpointAddr, unsigned char *data, int length, int *transferred, int &errcnt, std::string &errstr);
+    size_t calibrateWriteReadChunk(bool loopback, int &errcnt, std::string &errstr);
+    void cancelTransfer(libusb_transfer *transfer);
+    void checkFullTransfer(const libusb_transfer *transfer, int &errcnt, std::string &errstr);
+    void checkTransfer(const libusb_transfer *transfer, int &errcnt, std::string &errstr);
+    void clearErrorLog();
     void close();
     void configureGPIO(uint8_t pin, uint8_t mode, bool value, int &errcnt, std::string &errstr);
     void configureSPIDelays(uint8_t channel, const SPIDelays &delays, int &errcnt, std::string &errstr);
     void configureSPIMode(uint8_t channel, const SPIMode &mode, int &errcnt, std::string &errstr);
     void controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength, int &errcnt, std::string &errstr);
+    size_t deriveWriteReadChunk(int &errcnt, std::string &errstr);
     void disableCS(uint8_t channel, int &errcnt, std::string &errstr);
     void disableSPIDelays(uint8_t channel, int &errcnt, std::string &errstr);
     void enableCS(uint8_t channel, int &errcnt, std::string &errstr);
@@ -370,14 +485,23 @@ public:
     SPIMode getSPIMode(uint8_t channel, int &errcnt, std::string &errstr);
     uint8_t getTransferPriority(int &errcnt, std::string &errstr);
     USBConfig getUSBConfig(int &errcnt, std::string &errstr);
+    void handleBackgroundEvents(unsigned int timeout, int *completed, int &errcnt, std::string &errstr);
+    void handleEvents(unsigned int timeout, int *completed, int &errcnt, std::string &errstr);
+    void invalidateShadow();
     bool isOTPBlank(int &errcnt, std::string &errstr);
     bool isOTPLocked(int &errcnt, std::string &errstr);
     bool isRTRActive(int &errcnt, std::string &errstr);
+    void lockEvents();
     void lockOTP(int &errcnt, std::string &errstr);
     int open(uint16_t vid, uint16_t pid, const std::string &serial = std::string());
+    int open(libusb_context *context, uint16_t vid, uint16_t pid, const std::string &serial = std::string());
+    int open(CP2130DeviceIndex &index, const std::string &serial = std::string());
+    int open(CP2130Transport &transport);
     void reset(int &errcnt, std::string &errstr);
+    void resetStats();
     void selectCS(uint8_t channel, int &errcnt, std::string &errstr);
     void setClockDivider(uint8_t value, int &errcnt, std::string &errstr);
+    void setErrstrEnabled(bool enabled);
     void setEventCounter(const EventCounter &evcntr, int &errcnt, std::string &errstr);
     void setFIFOThreshold(uint8_t threshold, int &errcnt, std::string &errstr);
     void setGPIO0(bool value, int &errcnt, std::string &errstr);
@@ -392,13 +516,26 @@ public:
     void setGPIO9(bool value, int &errcnt, std::string &errstr);
     void setGPIO10(bool value, int &errcnt, std::string &errstr);
     void setGPIOs(uint16_t bmValues, uint16_t bmMask, int &errcnt, std::string &errstr);
+    void setQueueDepth(size_t depth);
+    void setShadowEnabled(bool enabled);
+    void setSupervisor(CP2130Supervisor *supervisor);
+    void setWriteReadChunk(size_t chunk);
+    size_t spiRead(uint8_t *data, uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
+    size_t spiRead(uint8_t *data, uint32_t bytesToRead, int &errcnt, std::string &errstr);
     std::vector<uint8_t> spiRead(uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
     std::vector<uint8_t> spiRead(uint32_t bytesToRead, int &errcnt, std::string &errstr);
+    void spiWrite(uint8_t *buffer, uint32_t bytesToWrite, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
+    void spiWrite(uint8_t *buffer, uint32_t bytesToWrite, int &errcnt, std::string &errstr);
     void spiWrite(const std::vector<uint8_t> &data, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
     void spiWrite(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr);
+    size_t spiWriteRead(const uint8_t *dataOut, uint8_t *dataIn, size_t bytesToWriteRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
+    size_t spiWriteRead(const uint8_t *dataOut, uint8_t *dataIn, size_t bytesToWriteRead, int &errcnt, std::string &errstr);
     std::vector<uint8_t> spiWriteRead(const std::vector<uint8_t> &data, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
     std::vector<uint8_t> spiWriteRead(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr);
     void stopRTR(int &errcnt, std::string &errstr);
+    int submitBackgroundTransfer(libusb_transfer *transfer);
+    void submitTransfer(libusb_transfer *transfer, int &errcnt, std::string &errstr);
+    void unlockEvents();
     void writeLockWord(uint16_t word, int &errcnt, std::string &errstr);
     void writeManufacturerDesc(const std::u16string &manufacturer, int &errcnt, std::string &errstr);
     void writePinConfig(const PinConfig &config, int &errcnt, std::string &errstr);
@@ -407,7 +544,16 @@ public:
     void writeSerialDesc(const std::u16string &serial, int &errcnt, std::string &errstr);
     void writeUSBConfig(const USBConfig &config, uint8_t mask, int &errcnt, std::string &errstr);
 
+    static std::u16string decodeDesc(const unsigned char *table, const unsigned char *nextTable);
+    static EventCounter decodeEventCounter(const unsigned char *data);
+    static uint16_t decodeGPIOs(const unsigned char *data);
+    static PinConfig decodePinConfig(const unsigned char *data);
+    static SPIDelays decodeSPIDelays(const unsigned char *data);
+    static SPIMode decodeSPIMode(uint8_t word);
+    static USBConfig decodeUSBConfig(const unsigned char *data);
+    static void fillCommandHeader(unsigned char *buffer, uint8_t command, uint32_t length);
     static std::list<std::string> listDevices(uint16_t vid, uint16_t pid, int &errcnt, std::string &errstr);
+    static int transferResult(libusb_transfer_status status);
 };
 
 #endif  // CP2130_H
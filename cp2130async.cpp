@@ -0,0 +1,557 @@
+/* CP2130Async class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "cp2130async.h"
+
+// Private callback function for the transfers issued by the object, which is called from within handleEvents()
+// Any failure, short transfer or cancellation stops the operation, and the transfers it still has in flight are cancelled
+void LIBUSB_CALL CP2130Async::callback(libusb_transfer *transfer)
+{
+    Slot *slot = static_cast<Slot *>(transfer->user_data);
+    Operation &operation = *slot->operation;
+    CP2130Async *async = operation.async;
+    Segment &segment = operation.segments[slot->segment];
+    segment.transferred = transfer->actual_length;
+    slot->inflight = false;
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != segment.length) {
+        if (!operation.stopped) {  // Only the first failure is reported, since the ones that follow are usually caused by it
+            operation.stopped = true;
+            if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
+                ++operation.errcnt;
+                operation.errstr += "In CP2130Async: the operation was cancelled.\n";
+            } else {
+                async->device_.checkFullTransfer(transfer, operation.errcnt, operation.errstr);  // Short bulk transfers are also reported
+            }
+            for (size_t i = 0; i < operation.slots.size(); ++i) {
+                if (operation.slots[i].inflight) {
+                    async->device_.cancelTransfer(operation.slots[i].transfer);
+                }
+            }
+        }
+    }
+    --operation.inflight;  // Only decremented here, so that the operation cannot be finished by the callbacks of the transfers cancelled above
+    if (operation.inflight == 0 && (operation.stopped || operation.next == operation.segments.size())) {
+        async->finish(operation);
+    } else {
+        async->submitNext(operation);
+    }
+}
+
+// Private procedure that queues the given operation, taking ownership of it, and starts it if no other operation of the same kind is running
+void CP2130Async::enqueue(std::deque<std::unique_ptr<Operation>> &queue, Operation *operation)
+{
+    device_.lockEvents();  // The queues are also changed by the callbacks, which a background thread may be calling
+    queue.push_back(std::unique_ptr<Operation>(operation));
+    if (queue.size() == 1) {
+        start(*operation);
+        if (operation->inflight == 0) {  // The operation could not be submitted at all
+            finish(*operation);
+        }
+    }
+    device_.unlockEvents();
+}
+
+// Private procedure that delivers the outcome of the given operation, which must be at the front of its queue, and then starts the next ones
+// Operations that cannot be submitted (e.g., because they were cancelled) are finished here as well, in order
+void CP2130Async::finish(Operation &operation)
+{
+    std::deque<std::unique_ptr<Operation>> &queue = operation.control ? controlQueue_ : spiQueue_;
+    Operation *current = &operation;
+    while (true) {
+        current->complete(*current);  // The callback of the caller may queue further operations, which are started below
+        for (size_t i = 0; i < current->slots.size(); ++i) {
+            if (current->slots[i].transfer != nullptr) {
+                pool_.push_back(current->slots[i].transfer);
+            }
+        }
+        queue.pop_front();
+        if (queue.empty()) {
+            break;
+        }
+        current = queue.front().get();
+        start(*current);
+        if (current->inflight != 0) {
+            break;
+        }
+    }
+}
+
+// Private function that creates a control request, whose data stage is copied if the request is Host-to-Device
+CP2130Async::Operation *CP2130Async::newControl(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const unsigned char *data, uint16_t wLength)
+{
+    Operation *operation = new Operation();
+    operation->async = this;
+    operation->control = true;
+    operation->buffer.resize(LIBUSB_CONTROL_SETUP_SIZE + wLength);
+    libusb_fill_control_setup(operation->buffer.data(), bmRequestType, bRequest, wValue, wIndex, wLength);
+    if ((0x80 & bmRequestType) == 0x00 && wLength > 0) {
+        std::memcpy(operation->buffer.data() + LIBUSB_CONTROL_SETUP_SIZE, data, wLength);
+    }
+    operation->segments.push_back({0x00, operation->buffer.data(), static_cast<int>(wLength), 0});
+    operation->slots.resize(1);
+    return operation;
+}
+
+// Private function that creates an SPI operation, whose segments are filled by the caller, and which keeps up to the given number of transfers in flight
+CP2130Async::Operation *CP2130Async::newSPI(size_t depth)
+{
+    Operation *operation = new Operation();
+    operation->async = this;
+    operation->control = false;
+    operation->slots.resize(std::max<size_t>(1, depth));
+    return operation;
+}
+
+// Private procedure that takes the transfers required by the given operation from the pool, and submits its first segments
+void CP2130Async::start(Operation &operation)
+{
+    operation.slots.resize(std::min(operation.slots.size(), operation.segments.size()));
+    for (size_t i = 0; i < operation.slots.size(); ++i) {
+        libusb_transfer *transfer;
+        if (pool_.empty()) {
+            transfer = libusb_alloc_transfer(0);
+        } else {
+            transfer = pool_.back();
+            pool_.pop_back();
+        }
+        if (transfer == nullptr) {  // If allocation fails, the operation simply keeps fewer transfers in flight
+            operation.slots.resize(i);
+            break;
+        }
+        operation.slots[i].transfer = transfer;
+    }
+    if (operation.slots.empty() && !operation.segments.empty() && !operation.stopped) {
+        operation.stopped = true;
+        ++operation.errcnt;
+        operation.errstr += "In CP2130Async: could not allocate transfers.\n";
+    }
+    submitNext(operation);
+}
+
+// Private procedure that submits the next segments of the given operation, as long as it has free slots
+// Each transfer is given one timeout period for itself, plus one for every transfer of the operation that is in flight ahead of it
+void CP2130Async::submitNext(Operation &operation)
+{
+    size_t oldest = operation.next;  // Oldest segment in flight
+    for (size_t i = 0; i < operation.slots.size(); ++i) {
+        if (operation.slots[i].inflight && operation.slots[i].segment < oldest) {
+            oldest = operation.slots[i].segment;
+        }
+    }
+    for (size_t i = 0; i < operation.slots.size() && !operation.stopped && operation.next < operation.segments.size() && operation.next < oldest + operation.slots.size(); ++i) {  // As in CP2130::runPipeline(), no segment is submitted more than "depth" segments ahead of the oldest one in flight
+        Slot &slot = operation.slots[i];
+        if (!slot.inflight) {
+            Segment &segment = operation.segments[operation.next];
+            slot.operation = &operation;
+            slot.segment = operation.next;
+            unsigned int timeout = static_cast<unsigned int>(CP2130::TR_TIMEOUT * (operation.inflight + 1));
+            if (operation.control) {
+                libusb_fill_control_transfer(slot.transfer, nullptr, segment.buffer, callback, &slot, timeout);  // The device handle is set by CP2130::submitTransfer()
+            } else {
+                libusb_fill_bulk_transfer(slot.transfer, nullptr, segment.endpointAddr, segment.buffer, segment.length, callback, &slot, timeout);
+            }
+            int preverrcnt = operation.errcnt;
+            device_.submitTransfer(slot.transfer, operation.errcnt, operation.errstr);
+            if (operation.errcnt != preverrcnt) {  // The failure is already reported by submitTransfer()
+                operation.stopped = true;
+            } else {
+                slot.inflight = true;
+                ++operation.inflight;
+                ++operation.next;
+            }
+        }
+    }
+}
+
+// Creates a non-blocking front end for the given device, which must be open and must outlive this object
+CP2130Async::CP2130Async(CP2130 &device) :
+    device_(device)
+{
+}
+
+// Cancels every pending operation, whose callbacks are still called, and waits for the transfers in flight to complete
+CP2130Async::~CP2130Async()
+{
+    device_.lockEvents();
+    cancel();
+    int errcnt = 0;
+    std::string errstr;
+    while ((!controlQueue_.empty() || !spiQueue_.empty()) && errcnt == 0) {
+        device_.handleEvents(100, nullptr, errcnt, errstr);
+    }
+    device_.unlockEvents();
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        libusb_free_transfer(pool_[i]);
+    }
+}
+
+// Returns the time in milliseconds until handleEvents() must be called in order to handle transfer timeouts, or -1 if there is no such deadline
+// An event loop should use this value as the timeout when polling the file descriptors returned by pollfds()
+int CP2130Async::nextTimeout() const
+{
+    int timeout = -1;
+    libusb_context *context = device_.context();
+    timeval tv;
+    if (context != nullptr && libusb_get_next_timeout(context, &tv) == 1) {
+        timeout = static_cast<int>(tv.tv_sec * 1000 + (tv.tv_usec + 999) / 1000);  // Rounded up, so that the deadline is not missed
+    }
+    return timeout;
+}
+
+// Returns the number of operations that were not completed yet, including the ones that are running
+size_t CP2130Async::pending() const
+{
+    device_.lockEvents();
+    size_t npending = controlQueue_.size() + spiQueue_.size();
+    device_.unlockEvents();
+    return npending;
+}
+
+// Returns the file descriptors that libusb needs to be watched, along with the events to watch for
+// When any of them becomes ready, handleEvents() should be called, and note that the list is empty on platforms that do not support this (e.g., Windows), or if the device was opened via a transport
+std::vector<libusb_pollfd> CP2130Async::pollfds() const
+{
+    std::vector<libusb_pollfd> retpollfds;
+    libusb_context *context = device_.context();
+    if (context != nullptr) {
+        const libusb_pollfd **list = libusb_get_pollfds(context);
+        if (list != nullptr) {
+            for (size_t i = 0; list[i] != nullptr; ++i) {
+                retpollfds.push_back(*list[i]);
+            }
+#if LIBUSB_API_VERSION >= 0x01000104
+            libusb_free_pollfds(list);
+#else
+            std::free(list);
+#endif
+        }
+    }
+    return retpollfds;
+}
+
+// Cancels every pending operation, including the ones that are running, which complete with an error once their transfers are cancelled
+void CP2130Async::cancel()
+{
+    device_.lockEvents();
+    std::deque<std::unique_ptr<Operation>> *queues[2] = {&controlQueue_, &spiQueue_};
+    for (size_t i = 0; i < 2; ++i) {
+        std::deque<std::unique_ptr<Operation>> &queue = *queues[i];
+        for (size_t j = 0; j < queue.size(); ++j) {
+            Operation &operation = *queue[j];
+            if (!operation.stopped) {
+                operation.stopped = true;
+                ++operation.errcnt;
+                operation.errstr += "In CP2130Async: the operation was cancelled.\n";
+            }
+        }
+        std::vector<libusb_transfer *> transfers;  // Collected beforehand, in case a transport completes the cancelled transfers right away
+        if (!queue.empty()) {
+            Operation &running = *queue.front();
+            for (size_t j = 0; j < running.slots.size(); ++j) {
+                if (running.slots[j].inflight) {
+                    transfers.push_back(running.slots[j].transfer);
+                }
+            }
+        }
+        for (size_t j = 0; j < transfers.size(); ++j) {
+            device_.cancelTransfer(transfers[j]);
+        }
+    }
+    device_.unlockEvents();
+}
+
+// Configures the given SPI channel (see CP2130::configureSPIMode()), calling the given function once done
+// Since the request bypasses the shadow of the device, the shadow is invalidated
+void CP2130Async::configureSPIMode(uint8_t channel, const CP2130::SPIMode &mode, const Callback<bool> &callback)
+{
+    unsigned char controlBufferOut[CP2130::SET_SPI_WORD_WLEN] = {
+        channel,                                                                                       // Selected channel
+        static_cast<uint8_t>(mode.cpha << 5 | mode.cpol << 4 | mode.csmode << 3 | (0x07 & mode.cfrq))  // Control word (specified chip select mode, clock frequency, polarity and phase)
+    };
+    Operation *operation = newControl(CP2130::SET, CP2130::SET_SPI_WORD, 0x0000, 0x0000, controlBufferOut, CP2130::SET_SPI_WORD_WLEN);
+    if (channel > 10) {  // The error is delivered in order, as with any other outcome
+        operation->segments.clear();
+        ++operation->errcnt;
+        operation->errstr += "In configureSPIMode(): SPI channel value must be between 0 and 10.\n";  // Program logic error
+    }
+    operation->complete = [callback](Operation &op) {
+        Reply<bool> reply = {op.errcnt == 0, op.errcnt, op.errstr};
+        callback(reply);
+    };
+    device_.invalidateShadow();
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<bool>> CP2130Async::configureSPIMode(uint8_t channel, const CP2130::SPIMode &mode)
+{
+    std::future<Reply<bool>> future;
+    configureSPIMode(channel, mode, promiseCallback(future));
+    return future;
+}
+
+// Issues a control request, calling the given function once done
+// For Device-to-Host requests, the size of the given vector sets the length of the data stage, and the data received is returned
+void CP2130Async::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &data, const Callback<std::vector<uint8_t>> &callback)
+{
+    Operation *operation = newControl(bmRequestType, bRequest, wValue, wIndex, data.data(), static_cast<uint16_t>(data.size()));
+    operation->complete = [callback, bmRequestType](Operation &op) {
+        Reply<std::vector<uint8_t>> reply = {std::vector<uint8_t>(), op.errcnt, op.errstr};
+        if ((0x80 & bmRequestType) != 0x00) {
+            std::vector<unsigned char>::const_iterator begin = op.buffer.begin() + LIBUSB_CONTROL_SETUP_SIZE;
+            reply.value.assign(begin, begin + op.segments[0].transferred);
+        }
+        callback(reply);
+    };
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<std::vector<uint8_t>>> CP2130Async::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &data)
+{
+    std::future<Reply<std::vector<uint8_t>>> future;
+    controlTransfer(bmRequestType, bRequest, wValue, wIndex, data, promiseCallback(future));
+    return future;
+}
+
+// Gets the event counter (see CP2130::getEventCounter()), calling the given function once done
+void CP2130Async::getEventCounter(const Callback<CP2130::EventCounter> &callback)
+{
+    Operation *operation = newControl(CP2130::GET, CP2130::GET_EVENT_COUNTER, 0x0000, 0x0000, nullptr, CP2130::GET_EVENT_COUNTER_WLEN);
+    operation->complete = [callback](Operation &op) {
+        Reply<CP2130::EventCounter> reply = {CP2130::decodeEventCounter(op.buffer.data() + LIBUSB_CONTROL_SETUP_SIZE), op.errcnt, op.errstr};
+        callback(reply);
+    };
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<CP2130::EventCounter>> CP2130Async::getEventCounter()
+{
+    std::future<Reply<CP2130::EventCounter>> future;
+    getEventCounter(promiseCallback(future));
+    return future;
+}
+
+// Gets the value of every GPIO pin in bitmap format (see CP2130::getGPIOs()), calling the given function once done
+void CP2130Async::getGPIOs(const Callback<uint16_t> &callback)
+{
+    Operation *operation = newControl(CP2130::GET, CP2130::GET_GPIO_VALUES, 0x0000, 0x0000, nullptr, CP2130::GET_GPIO_VALUES_WLEN);
+    operation->complete = [callback](Operation &op) {
+        Reply<uint16_t> reply = {CP2130::decodeGPIOs(op.buffer.data() + LIBUSB_CONTROL_SETUP_SIZE), op.errcnt, op.errstr};
+        callback(reply);
+    };
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<uint16_t>> CP2130Async::getGPIOs()
+{
+    std::future<Reply<uint16_t>> future;
+    getGPIOs(promiseCallback(future));
+    return future;
+}
+
+// Handles the events that are ready, without blocking, and calls the callbacks of the operations that complete as a result
+// This should be called whenever any of the file descriptors returned by pollfds() becomes ready, or once the time returned by nextTimeout() expires
+void CP2130Async::handleEvents(int &errcnt, std::string &errstr)
+{
+    device_.handleEvents(0, nullptr, errcnt, errstr);
+}
+
+// Enables the chip select of the target channel, disabling any others (see CP2130::selectCS()), calling the given function once done
+// Since the request bypasses the shadow of the device, the shadow is invalidated
+void CP2130Async::selectCS(uint8_t channel, const Callback<bool> &callback)
+{
+    unsigned char controlBufferOut[CP2130::SET_GPIO_CHIP_SELECT_WLEN] = {
+        channel,  // Selected channel
+        0x02      // Chip select control value (enables the channel, disabling all others)
+    };
+    Operation *operation = newControl(CP2130::SET, CP2130::SET_GPIO_CHIP_SELECT, 0x0000, 0x0000, controlBufferOut, CP2130::SET_GPIO_CHIP_SELECT_WLEN);
+    if (channel > 10) {  // The error is delivered in order, as with any other outcome
+        operation->segments.clear();
+        ++operation->errcnt;
+        operation->errstr += "In selectCS(): SPI channel value must be between 0 and 10.\n";  // Program logic error
+    }
+    operation->complete = [callback](Operation &op) {
+        Reply<bool> reply = {op.errcnt == 0, op.errcnt, op.errstr};
+        callback(reply);
+    };
+    device_.invalidateShadow();
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<bool>> CP2130Async::selectCS(uint8_t channel)
+{
+    std::future<Reply<bool>> future;
+    selectCS(channel, promiseCallback(future));
+    return future;
+}
+
+// Sets one or more GPIO pins to the intended values (see CP2130::setGPIOs()), calling the given function once done
+// Since the request bypasses the shadow of the device, the shadow is invalidated
+void CP2130Async::setGPIOs(uint16_t bmValues, uint16_t bmMask, const Callback<bool> &callback)
+{
+    unsigned char controlBufferOut[CP2130::SET_GPIO_VALUES_WLEN] = {
+        static_cast<uint8_t>((CP2130::BMGPIOS & bmValues) >> 8), static_cast<uint8_t>(CP2130::BMGPIOS & bmValues),  // GPIO values bitmap
+        static_cast<uint8_t>((CP2130::BMGPIOS & bmMask) >> 8), static_cast<uint8_t>(CP2130::BMGPIOS & bmMask)       // Mask bitmap
+    };
+    Operation *operation = newControl(CP2130::SET, CP2130::SET_GPIO_VALUES, 0x0000, 0x0000, controlBufferOut, CP2130::SET_GPIO_VALUES_WLEN);
+    operation->complete = [callback](Operation &op) {
+        Reply<bool> reply = {op.errcnt == 0, op.errcnt, op.errstr};
+        callback(reply);
+    };
+    device_.invalidateShadow();
+    enqueue(controlQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<bool>> CP2130Async::setGPIOs(uint16_t bmValues, uint16_t bmMask)
+{
+    std::future<Reply<bool>> future;
+    setGPIOs(bmValues, bmMask, promiseCallback(future));
+    return future;
+}
+
+// Sets the functions that libusb calls whenever a file descriptor is added or removed, so that an event loop can keep its set up to date
+// Passing null pointers removes the notifiers
+void CP2130Async::setPollfdNotifiers(libusb_pollfd_added_cb added, libusb_pollfd_removed_cb removed, void *userData)
+{
+    libusb_context *context = device_.context();
+    if (context != nullptr) {
+        libusb_set_pollfd_notifiers(context, added, removed, userData);
+    }
+}
+
+// Reads the given number of bytes from the SPI bus (see CP2130::spiRead()), calling the given function once done
+// As with CP2130::spiRead(), only the data received before the first short or failed transfer is returned
+void CP2130Async::spiRead(uint32_t bytesToRead, const Callback<std::vector<uint8_t>> &callback)
+{
+    Operation *operation = newSPI(device_.readDepth());  // Same depth as CP2130::spiRead()
+    uint8_t endpointInAddr = device_.getEndpointInAddr(operation->errcnt, operation->errstr);
+    uint8_t endpointOutAddr = device_.getEndpointOutAddr(operation->errcnt, operation->errstr);
+    size_t nchunks = (static_cast<size_t>(bytesToRead) + CP2130::READ_CHUNK - 1) / CP2130::READ_CHUNK;
+    operation->buffer.resize(CP2130::CMD_HEADER_SIZE);
+    CP2130::fillCommandHeader(operation->buffer.data(), CP2130::READ, bytesToRead);
+    operation->data.resize(static_cast<size_t>(bytesToRead));
+    operation->segments.resize(nchunks + 1);
+    operation->segments[0] = {endpointOutAddr, operation->buffer.data(), static_cast<int>(CP2130::CMD_HEADER_SIZE), 0};
+    for (size_t i = 0; i < nchunks; ++i) {
+        size_t offset = i * CP2130::READ_CHUNK;
+        operation->segments[i + 1] = {endpointInAddr, operation->data.data() + offset, static_cast<int>(bytesToRead - offset < CP2130::READ_CHUNK ? bytesToRead - offset : CP2130::READ_CHUNK), 0};
+    }
+    operation->complete = [callback](Operation &op) {
+        size_t bytesRead = 0;
+        for (size_t i = 1; i < op.segments.size(); ++i) {
+            bytesRead += static_cast<size_t>(op.segments[i].transferred);
+            if (op.segments[i].transferred != op.segments[i].length) {
+                break;
+            }
+        }
+        op.data.resize(bytesRead);
+        Reply<std::vector<uint8_t>> reply = {std::move(op.data), op.errcnt, op.errstr};
+        callback(reply);
+    };
+    enqueue(spiQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<std::vector<uint8_t>>> CP2130Async::spiRead(uint32_t bytesToRead)
+{
+    std::future<Reply<std::vector<uint8_t>>> future;
+    spiRead(bytesToRead, promiseCallback(future));
+    return future;
+}
+
+// Writes the given vector to the SPI bus (see CP2130::spiWrite()), calling the given function once done
+void CP2130Async::spiWrite(const std::vector<uint8_t> &data, const Callback<bool> &callback)
+{
+    Operation *operation = newSPI(1);
+    uint8_t endpointOutAddr = device_.getEndpointOutAddr(operation->errcnt, operation->errstr);
+    uint32_t bytesToWrite = static_cast<uint32_t>(data.size());
+    operation->buffer.resize(CP2130::CMD_HEADER_SIZE + bytesToWrite);
+    CP2130::fillCommandHeader(operation->buffer.data(), CP2130::WRITE, bytesToWrite);
+    std::copy(data.begin(), data.end(), operation->buffer.begin() + CP2130::CMD_HEADER_SIZE);
+    operation->segments.push_back({endpointOutAddr, operation->buffer.data(), static_cast<int>(operation->buffer.size()), 0});
+    operation->complete = [callback](Operation &op) {
+        Reply<bool> reply = {op.errcnt == 0, op.errcnt, op.errstr};
+        callback(reply);
+    };
+    enqueue(spiQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<bool>> CP2130Async::spiWrite(const std::vector<uint8_t> &data)
+{
+    std::future<Reply<bool>> future;
+    spiWrite(data, promiseCallback(future));
+    return future;
+}
+
+// Writes the given vector to the SPI bus while reading back (see CP2130::spiWriteRead()), calling the given function once done
+// As with CP2130::spiWriteRead(), the data of any chunks that follow an error is discarded
+void CP2130Async::spiWriteRead(const std::vector<uint8_t> &data, const Callback<std::vector<uint8_t>> &callback)
+{
+    Operation *operation = newSPI(device_.writeReadDepth());  // Same depth as CP2130::spiWriteRead()
+    uint8_t endpointInAddr = device_.getEndpointInAddr(operation->errcnt, operation->errstr);
+    uint8_t endpointOutAddr = device_.getEndpointOutAddr(operation->errcnt, operation->errstr);
+    size_t bytesToWriteRead = data.size();
+    size_t chunkSize = device_.writeReadChunk();  // Same chunk size as CP2130::spiWriteRead()
+    size_t nchunks = (bytesToWriteRead + chunkSize - 1) / chunkSize;
+    operation->buffer.resize(nchunks * CP2130::CMD_HEADER_SIZE + bytesToWriteRead);
+    operation->data.resize(bytesToWriteRead);
+    operation->segments.resize(2 * nchunks);
+    unsigned char *writeReadCommandBuffer = operation->buffer.data();
+    for (size_t i = 0; i < nchunks; ++i) {
+        size_t bytesProcessed = i * chunkSize;
+        uint32_t payload = static_cast<uint32_t>(std::min(chunkSize, bytesToWriteRead - bytesProcessed));
+        CP2130::fillCommandHeader(writeReadCommandBuffer, CP2130::WRITEREAD, payload);
+        std::memcpy(writeReadCommandBuffer + CP2130::CMD_HEADER_SIZE, data.data() + bytesProcessed, payload);
+        operation->segments[2 * i] = {endpointOutAddr, writeReadCommandBuffer, static_cast<int>(payload + CP2130::CMD_HEADER_SIZE), 0};
+        operation->segments[2 * i + 1] = {endpointInAddr, operation->data.data() + bytesProcessed, static_cast<int>(payload), 0};
+        writeReadCommandBuffer += payload + CP2130::CMD_HEADER_SIZE;
+    }
+    operation->complete = [callback](Operation &op) {
+        size_t bytesRead = 0;
+        for (size_t i = 0; i < op.segments.size(); i += 2) {
+            bytesRead += static_cast<size_t>(op.segments[i + 1].transferred);
+            if (op.segments[i].transferred != op.segments[i].length || op.segments[i + 1].transferred != op.segments[i + 1].length) {
+                break;
+            }
+        }
+        op.data.resize(bytesRead);
+        Reply<std::vector<uint8_t>> reply = {std::move(op.data), op.errcnt, op.errstr};
+        callback(reply);
+    };
+    enqueue(spiQueue_, operation);
+}
+
+// This function is the future based version of the previous one
+std::future<CP2130Async::Reply<std::vector<uint8_t>>> CP2130Async::spiWriteRead(const std::vector<uint8_t> &data)
+{
+    std::future<Reply<std::vector<uint8_t>>> future;
+    spiWriteRead(data, promiseCallback(future));
+    return future;
+}
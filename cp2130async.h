@@ -0,0 +1,139 @@
+/* CP2130Async class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130ASYNC_H
+#define CP2130ASYNC_H
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+#include "cp2130operation.h"
+
+// Non-blocking front end to a CP2130, whose operations are built on asynchronous transfers and complete through callbacks or futures
+// Operations only make progress while handleEvents() is called, typically from an event loop that watches the file descriptors returned by pollfds(), and callbacks are called from within handleEvents()
+// Control requests complete in the order they were made, and so do SPI operations, which are never interleaved with each other (e.g., the response of a WriteRead command is always received before the next command is sent)
+// The queues are only changed while holding the event lock of the device (see CP2130::lockEvents()), so that callbacks called by a background thread, such as the one of CP2130Sampler, never race with the caller
+// Otherwise, this class is not thread-safe, and the device must not be used directly while operations are pending
+class CP2130Async
+{
+public:
+    template <typename T>
+    using Reply = CP2130Reply<T>;
+
+    template <typename T>
+    using Callback = std::function<void(const Reply<T> &)>;
+
+private:
+    struct Segment {
+        uint8_t endpointAddr;   // Endpoint address (ignored for control transfers)
+        unsigned char *buffer;  // Data buffer, which includes the setup packet in the case of a control transfer
+        int length;             // Number of bytes to transfer, excluding the setup packet
+        int transferred;        // Number of bytes actually transferred
+    };
+
+    struct Operation;
+
+    struct Slot {
+        Operation *operation;       // Operation to which the transfer belongs
+        size_t segment;             // Index of the segment being transferred
+        libusb_transfer *transfer;  // Transfer, taken from the pool while the operation runs
+        bool inflight;              // True while the transfer is in flight
+    };
+
+    struct Operation {
+        CP2130Async *async;
+        bool control;                                // True for a control request, or false for an SPI operation
+        std::vector<unsigned char> buffer;           // Setup packet and data stage of a control request, or command headers and payloads of an SPI operation
+        std::vector<uint8_t> data;                   // Data received by an SPI operation
+        std::vector<Segment> segments;
+        std::vector<Slot> slots;
+        size_t next;                                 // Index of the next segment to be submitted
+        size_t inflight;                             // Number of transfers in flight
+        bool stopped;                                // True if any transfer has failed, was short or was cancelled, after which no more segments are submitted
+        int errcnt;
+        std::string errstr;
+        std::function<void(Operation &)> complete;  // Delivers the outcome of the operation to the caller
+    };
+
+    CP2130 &device_;
+    std::deque<std::unique_ptr<Operation>> controlQueue_, spiQueue_;  // The operation at the front of each queue is the one running
+    std::vector<libusb_transfer *> pool_;                             // Transfers that are not in use
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    void enqueue(std::deque<std::unique_ptr<Operation>> &queue, Operation *operation);
+    void finish(Operation &operation);
+    Operation *newControl(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const unsigned char *data, uint16_t wLength);
+    Operation *newSPI(size_t depth);
+    void start(Operation &operation);
+    void submitNext(Operation &operation);
+
+    template <typename T>
+    static Callback<T> promiseCallback(std::future<Reply<T>> &future)
+    {
+        std::shared_ptr<std::promise<Reply<T>>> promise = std::make_shared<std::promise<Reply<T>>>();
+        future = promise->get_future();
+        return [promise](const Reply<T> &reply) {
+            promise->set_value(reply);
+        };
+    }
+
+public:
+    explicit CP2130Async(CP2130 &device);
+    ~CP2130Async();
+
+    CP2130Async(const CP2130Async &) = delete;
+    CP2130Async &operator =(const CP2130Async &) = delete;
+
+    int nextTimeout() const;
+    size_t pending() const;
+    std::vector<libusb_pollfd> pollfds() const;
+
+    void cancel();
+    void configureSPIMode(uint8_t channel, const CP2130::SPIMode &mode, const Callback<bool> &callback);
+    std::future<Reply<bool>> configureSPIMode(uint8_t channel, const CP2130::SPIMode &mode);
+    void controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &data, const Callback<std::vector<uint8_t>> &callback);
+    std::future<Reply<std::vector<uint8_t>>> controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &data);
+    void getEventCounter(const Callback<CP2130::EventCounter> &callback);
+    std::future<Reply<CP2130::EventCounter>> getEventCounter();
+    void getGPIOs(const Callback<uint16_t> &callback);
+    std::future<Reply<uint16_t>> getGPIOs();
+    void handleEvents(int &errcnt, std::string &errstr);
+    void selectCS(uint8_t channel, const Callback<bool> &callback);
+    std::future<Reply<bool>> selectCS(uint8_t channel);
+    void setGPIOs(uint16_t bmValues, uint16_t bmMask, const Callback<bool> &callback);
+    std::future<Reply<bool>> setGPIOs(uint16_t bmValues, uint16_t bmMask);
+    void setPollfdNotifiers(libusb_pollfd_added_cb added, libusb_pollfd_removed_cb removed, void *userData);
+    void spiRead(uint32_t bytesToRead, const Callback<std::vector<uint8_t>> &callback);
+    std::future<Reply<std::vector<uint8_t>>> spiRead(uint32_t bytesToRead);
+    void spiWrite(const std::vector<uint8_t> &data, const Callback<bool> &callback);
+    std::future<Reply<bool>> spiWrite(const std::vector<uint8_t> &data);
+    void spiWriteRead(const std::vector<uint8_t> &data, const Callback<std::vector<uint8_t>> &callback);
+    std::future<Reply<std::vector<uint8_t>>> spiWriteRead(const std::vector<uint8_t> &data);
+};
+
+#endif  // CP2130ASYNC_H
@@ -0,0 +1,169 @@
+/* CP2130BufferPool class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include "cp2130bufferpool.h"
+
+// Private procedure that frees the given block, which must no longer be listed
+void CP2130BufferPool::freeBlock(const Block &block)
+{
+    if (block.devHandle == nullptr) {
+        delete[] block.raw;
+    } else {
+#if LIBUSB_API_VERSION >= 0x01000105
+        libusb_dev_mem_free(block.devHandle, block.raw, block.size);
+#endif
+    }
+    stats_.bytesAllocated -= block.size;
+}
+
+CP2130BufferPool::CP2130BufferPool() :
+    handle_(nullptr),
+    devMemFailed_(false),
+    stats_()
+{
+}
+
+// Frees every buffer, including the ones not yet released, which must no longer be used
+CP2130BufferPool::~CP2130BufferPool()
+{
+    for (size_t i = 0; i < free_.size(); ++i) {
+        freeBlock(free_[i]);
+    }
+    for (size_t i = 0; i < used_.size(); ++i) {
+        freeBlock(used_[i]);
+    }
+}
+
+// Returns true if new buffers requested in device memory are allocated there
+// This only becomes false for an open device after an allocation fails, which is how a kernel without support for it is detected
+bool CP2130BufferPool::devMemEnabled() const
+{
+#if LIBUSB_API_VERSION >= 0x01000105
+    std::lock_guard<std::mutex> lock(mutex_);
+    return handle_ != nullptr && !devMemFailed_;
+#else
+    return false;
+#endif
+}
+
+// Returns the allocation statistics of the pool
+CP2130BufferPool::Stats CP2130BufferPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Returns a buffer of at least the given size, aligned to "ALIGNMENT" bytes, which must be given back via release()
+// A released buffer of the same size class is reused if there is one, and the most recently released one is preferred, since it is more likely to be cached
+// If "devMem" is true, the buffer is placed in device memory if supported, and must then be given back before the handle is changed or closed (see setHandle())
+unsigned char *CP2130BufferPool::acquire(size_t size, bool devMem)
+{
+    size_t blockSize = MIN_SIZE;
+    while (blockSize < size) {
+        blockSize *= 2;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.acquisitions;
+    Block block = {nullptr, nullptr, blockSize, nullptr};
+    for (size_t i = free_.size(); i > 0; --i) {
+        if (free_[i - 1].size == blockSize && (devMem || free_[i - 1].devHandle == nullptr)) {  // Buffers in device memory are only reused by the device itself
+            block = free_[i - 1];
+            free_.erase(free_.begin() + static_cast<std::ptrdiff_t>(i - 1));
+            ++stats_.reuses;
+            break;
+        }
+    }
+    if (block.raw == nullptr) {
+#if LIBUSB_API_VERSION >= 0x01000105
+        if (devMem && handle_ != nullptr && !devMemFailed_) {
+            block.raw = libusb_dev_mem_alloc(handle_, blockSize);
+            if (block.raw == nullptr) {  // Either the kernel does not support device memory, or it ran out of it, so the heap is used from now on
+                devMemFailed_ = true;
+            } else {
+                block.data = block.raw;
+                block.devHandle = handle_;
+                ++stats_.devMemAllocations;
+            }
+        }
+#endif
+        if (block.raw == nullptr) {
+            block.raw = new unsigned char[blockSize + ALIGNMENT - 1];
+            block.data = block.raw + (ALIGNMENT - reinterpret_cast<uintptr_t>(block.raw) % ALIGNMENT) % ALIGNMENT;
+            ++stats_.heapAllocations;
+        }
+        stats_.bytesAllocated += blockSize;
+    }
+    used_.push_back(block);
+    stats_.bytesInUse += blockSize;
+    return block.data;
+}
+
+// Gives back a buffer obtained via acquire(), so that it can be reused (null pointers are ignored)
+void CP2130BufferPool::release(unsigned char *buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = used_.size(); i > 0; --i) {
+        if (used_[i - 1].data == buffer) {
+            free_.push_back(used_[i - 1]);
+            stats_.bytesInUse -= used_[i - 1].size;
+            used_.erase(used_.begin() + static_cast<std::ptrdiff_t>(i - 1));
+            break;
+        }
+    }
+}
+
+// Resets the counters, except for the ones that reflect the buffers currently allocated
+void CP2130BufferPool::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.acquisitions = 0;
+    stats_.reuses = 0;
+    stats_.devMemAllocations = 0;
+    stats_.heapAllocations = 0;
+}
+
+// Sets the handle of the device whose memory is used by buffers requested in device memory, or a null pointer to use the heap
+// Released buffers in device memory are freed, since they were allocated for the previous handle, so this must be done while the previous handle is still open, and after every such buffer is given back
+void CP2130BufferPool::setHandle(libusb_device_handle *handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t nkept = 0;
+    for (size_t i = 0; i < free_.size(); ++i) {
+        if (free_[i].devHandle == nullptr) {  // Buffers on the heap are kept for reuse
+            free_[nkept++] = free_[i];
+        } else {
+            freeBlock(free_[i]);
+        }
+    }
+    free_.resize(nkept);
+    handle_ = handle;
+    devMemFailed_ = false;
+}
+
+// Frees every released buffer, giving the memory back
+void CP2130BufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < free_.size(); ++i) {
+        freeBlock(free_[i]);
+    }
+    free_.clear();
+}
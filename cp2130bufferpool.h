@@ -0,0 +1,83 @@
+/* CP2130BufferPool class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130BUFFERPOOL_H
+#define CP2130BUFFERPOOL_H
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+
+// Pool of transfer buffers of a CP2130, which keeps released buffers for reuse, so that bulk transfers do not allocate memory once the pool is warm
+// While a device is open, buffers requested in device memory are allocated with libusb_dev_mem_alloc(), so that usbfs can transfer them without copying them to or from kernel memory
+// If the kernel or the libusb version does not support that, or if the device was opened via a transport, those buffers are allocated on the heap instead
+// Only the device itself requests buffers in device memory, since it can give them back before its handle is closed, whereas any other buffer is allocated on the heap, so that it can outlive the handle
+class CP2130BufferPool
+{
+public:
+    struct Stats {
+        uint64_t acquisitions;       // Number of buffers handed out
+        uint64_t reuses;             // Number of acquisitions served by a released buffer
+        uint64_t devMemAllocations;  // Number of buffers allocated with libusb_dev_mem_alloc()
+        uint64_t heapAllocations;    // Number of buffers allocated on the heap
+        uint64_t bytesAllocated;     // Number of bytes currently allocated, whether in use or not
+        uint64_t bytesInUse;         // Number of bytes currently handed out
+    };
+
+    static const size_t ALIGNMENT = 64;  // Alignment of heap buffers, which matches the cache line size of most processors (buffers in device memory are page-aligned)
+    static const size_t MIN_SIZE = 64;   // Smallest buffer size, which is the size of a bulk packet (sizes are rounded up to powers of two from here)
+
+private:
+    struct Block {
+        unsigned char *data;              // Aligned buffer
+        unsigned char *raw;               // Memory returned by the allocator (same as "data" for device memory)
+        size_t size;                      // Size of the buffer
+        libusb_device_handle *devHandle;  // Device handle used to allocate the buffer, or a null pointer if it was allocated on the heap
+    };
+
+    mutable std::mutex mutex_;
+    libusb_device_handle *handle_;
+    bool devMemFailed_;  // Set when libusb_dev_mem_alloc() fails, so that it is not attempted again for the same handle
+    std::vector<Block> free_, used_;
+    Stats stats_;
+
+    void freeBlock(const Block &block);
+
+public:
+    CP2130BufferPool();
+    ~CP2130BufferPool();
+
+    CP2130BufferPool(const CP2130BufferPool &) = delete;
+    CP2130BufferPool &operator =(const CP2130BufferPool &) = delete;
+
+    bool devMemEnabled() const;
+    Stats stats() const;
+
+    unsigned char *acquire(size_t size, bool devMem = false);
+    void release(unsigned char *buffer);
+    void resetStats();
+    void setHandle(libusb_device_handle *handle);
+    void trim();
+};
+
+#endif  // CP2130BUFFERPOOL_H
@@ -0,0 +1,318 @@
+/* CP2130Coroutine class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130COROUTINE_H
+#define CP2130COROUTINE_H
+
+// This header requires C++20, and is empty otherwise, so that the rest of the library keeps following the C++11 standard
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+
+// Includes
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cp2130async.h"
+
+// Awaitable operation of a CP2130Async object, which suspends the awaiting coroutine until the operation completes
+// The coroutine is resumed from within CP2130Async::handleEvents(), so that no thread is used while the operation is in flight
+template <typename T>
+class CP2130Awaitable
+{
+private:
+    std::function<void(const CP2130Async::Callback<T> &)> start_;
+    std::coroutine_handle<> handle_;
+    std::optional<CP2130Async::Reply<T>> reply_;
+    bool suspended_;
+
+public:
+    explicit CP2130Awaitable(std::function<void(const CP2130Async::Callback<T> &)> start) :
+        start_(std::move(start)),
+        suspended_(false)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    // Starts the operation, and suspends the coroutine unless the operation completes right away (e.g., if its arguments are invalid)
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        start_([this](const CP2130Async::Reply<T> &reply) {
+            reply_ = reply;
+            if (suspended_) {
+                handle_.resume();
+            }
+        });
+        suspended_ = !reply_.has_value();
+        return suspended_;
+    }
+
+    CP2130Async::Reply<T> await_resume()
+    {
+        return std::move(*reply_);
+    }
+};
+
+template <typename T>
+class CP2130Task;
+
+// Private base of the promise type of CP2130Task, which keeps the coroutine that awaits the task, if any
+struct CP2130TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    std::suspend_never initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        exception = std::current_exception();
+    }
+};
+
+template <typename T>
+struct CP2130TaskPromise : CP2130TaskPromiseBase {
+    std::optional<T> value;
+
+    CP2130Task<T> get_return_object();
+
+    void return_value(T v)
+    {
+        value = std::move(v);
+    }
+
+    T result()
+    {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct CP2130TaskPromise<void> : CP2130TaskPromiseBase {
+    CP2130Task<void> get_return_object();
+
+    void return_void() const noexcept
+    {
+    }
+
+    void result()
+    {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+// Coroutine type for sequences of CP2130 operations, which starts running as soon as it is called
+// A task can be awaited by another coroutine, or polled via done() by an event loop, and its frame is destroyed along with the task object
+// A task must not be destroyed while suspended on an operation, unless that operation was cancelled and has completed (see CP2130Async::cancel())
+template <typename T = void>
+class CP2130Task
+{
+public:
+    using promise_type = CP2130TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+public:
+    explicit CP2130Task(std::coroutine_handle<promise_type> handle) :
+        handle_(handle)
+    {
+    }
+
+    CP2130Task(CP2130Task &&other) noexcept :
+        handle_(std::exchange(other.handle_, nullptr))
+    {
+    }
+
+    ~CP2130Task()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    CP2130Task(const CP2130Task &) = delete;
+    CP2130Task &operator =(const CP2130Task &) = delete;
+
+    // Returns true once the coroutine has finished
+    bool done() const
+    {
+        return !handle_ || handle_.done();
+    }
+
+    // Returns the value of the coroutine, which must be done, or rethrows the exception that escaped it
+    T result()
+    {
+        return handle_.promise().result();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return done();
+    }
+
+    void await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+        handle_.promise().continuation = continuation;
+    }
+
+    T await_resume()
+    {
+        return result();
+    }
+};
+
+template <typename T>
+CP2130Task<T> CP2130TaskPromise<T>::get_return_object()
+{
+    return CP2130Task<T>(std::coroutine_handle<CP2130TaskPromise<T>>::from_promise(*this));
+}
+
+inline CP2130Task<void> CP2130TaskPromise<void>::get_return_object()
+{
+    return CP2130Task<void>(std::coroutine_handle<CP2130TaskPromise<void>>::from_promise(*this));
+}
+
+// Awaitable front end to a CP2130Async object, so that a sequence such as selecting a chip select, writing a command and reading the response reads as straight-line code
+// Thousands of operations may be awaited at once, across any number of devices, since each suspended coroutine only costs its frame
+// Each awaited operation completes before the coroutine goes on, but operations of different coroutines that share a device may interleave, which matters for sequences that depend on the selected chip select
+class CP2130Coroutine
+{
+private:
+    CP2130Async &async_;
+
+public:
+    explicit CP2130Coroutine(CP2130Async &async) :
+        async_(async)
+    {
+    }
+
+    CP2130Async &async() const
+    {
+        return async_;
+    }
+
+    CP2130Awaitable<bool> configureSPIMode(uint8_t channel, const CP2130::SPIMode &mode)
+    {
+        return CP2130Awaitable<bool>([this, channel, mode](const CP2130Async::Callback<bool> &callback) {
+            async_.configureSPIMode(channel, mode, callback);
+        });
+    }
+
+    CP2130Awaitable<std::vector<uint8_t>> controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &data)
+    {
+        return CP2130Awaitable<std::vector<uint8_t>>([this, bmRequestType, bRequest, wValue, wIndex, data](const CP2130Async::Callback<std::vector<uint8_t>> &callback) {
+            async_.controlTransfer(bmRequestType, bRequest, wValue, wIndex, data, callback);
+        });
+    }
+
+    CP2130Awaitable<CP2130::EventCounter> getEventCounter()
+    {
+        return CP2130Awaitable<CP2130::EventCounter>([this](const CP2130Async::Callback<CP2130::EventCounter> &callback) {
+            async_.getEventCounter(callback);
+        });
+    }
+
+    CP2130Awaitable<uint16_t> getGPIOs()
+    {
+        return CP2130Awaitable<uint16_t>([this](const CP2130Async::Callback<uint16_t> &callback) {
+            async_.getGPIOs(callback);
+        });
+    }
+
+    CP2130Awaitable<bool> selectCS(uint8_t channel)
+    {
+        return CP2130Awaitable<bool>([this, channel](const CP2130Async::Callback<bool> &callback) {
+            async_.selectCS(channel, callback);
+        });
+    }
+
+    CP2130Awaitable<bool> setGPIOs(uint16_t bmValues, uint16_t bmMask)
+    {
+        return CP2130Awaitable<bool>([this, bmValues, bmMask](const CP2130Async::Callback<bool> &callback) {
+            async_.setGPIOs(bmValues, bmMask, callback);
+        });
+    }
+
+    CP2130Awaitable<std::vector<uint8_t>> spiRead(uint32_t bytesToRead)
+    {
+        return CP2130Awaitable<std::vector<uint8_t>>([this, bytesToRead](const CP2130Async::Callback<std::vector<uint8_t>> &callback) {
+            async_.spiRead(bytesToRead, callback);
+        });
+    }
+
+    CP2130Awaitable<bool> spiWrite(const std::vector<uint8_t> &data)
+    {
+        return CP2130Awaitable<bool>([this, data](const CP2130Async::Callback<bool> &callback) {
+            async_.spiWrite(data, callback);
+        });
+    }
+
+    CP2130Awaitable<std::vector<uint8_t>> spiWriteRead(const std::vector<uint8_t> &data)
+    {
+        return CP2130Awaitable<std::vector<uint8_t>>([this, data](const CP2130Async::Callback<std::vector<uint8_t>> &callback) {
+            async_.spiWriteRead(data, callback);
+        });
+    }
+};
+
+#endif  // __has_include(<coroutine>)
+#endif  // __cplusplus >= 202002L
+
+#endif  // CP2130COROUTINE_H
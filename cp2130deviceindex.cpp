@@ -0,0 +1,175 @@
+/* CP2130DeviceIndex class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <sstream>
+#include "cp2130deviceindex.h"
+
+// Private function that returns the bus/port path of the given device
+static std::string devicePath(libusb_device *device)
+{
+    std::ostringstream stream;
+    stream << static_cast<int>(libusb_get_bus_number(device));
+    uint8_t ports[7];  // As per the USB 3.0 specification, the maximum depth is 7
+    int nports = libusb_get_port_numbers(device, ports, static_cast<int>(sizeof(ports)));
+    for (int i = 0; i < nports; ++i) {
+        stream << (i == 0 ? "-" : ".") << static_cast<int>(ports[i]);
+    }
+    return stream.str();
+}
+
+// Creates an index that uses its own libusb context, for devices having the given VID and PID
+CP2130DeviceIndex::CP2130DeviceIndex(uint16_t vid, uint16_t pid) :
+    context_(nullptr),
+    ownsContext_(true),
+    initialized_(false),
+    vid_(vid),
+    pid_(pid)
+{
+    initialized_ = libusb_init(&context_) == 0;
+}
+
+// Creates an index that uses the given libusb context, for devices having the given VID and PID
+// The context must outlive the index, as well as any device opened through it
+CP2130DeviceIndex::CP2130DeviceIndex(libusb_context *context, uint16_t vid, uint16_t pid) :
+    context_(context),
+    ownsContext_(false),
+    initialized_(true),
+    vid_(vid),
+    pid_(pid)
+{
+}
+
+CP2130DeviceIndex::~CP2130DeviceIndex()
+{
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        libusb_unref_device(entries_[i].device);
+    }
+    if (ownsContext_ && initialized_) {
+        libusb_exit(context_);  // Deinitialize libusb
+    }
+}
+
+// Returns the libusb context used by the index
+libusb_context *CP2130DeviceIndex::context() const
+{
+    return context_;
+}
+
+// Returns the device having the given serial number, or a null pointer if no such device is indexed
+// If the serial number is an empty string, the first device indexed is returned instead
+// The device returned is referenced, and must be released using libusb_unref_device()
+libusb_device *CP2130DeviceIndex::device(const std::string &serial) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    libusb_device *device = nullptr;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (serial.empty() || entries_[i].serial == serial) {
+            device = libusb_ref_device(entries_[i].device);
+            break;
+        }
+    }
+    return device;
+}
+
+// Returns the bus/port path of the device having the given serial number, or an empty string if no such device is indexed
+std::string CP2130DeviceIndex::path(const std::string &serial) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string retpath;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].serial == serial) {
+            retpath = entries_[i].path;
+            break;
+        }
+    }
+    return retpath;
+}
+
+// Returns the serial numbers of every indexed device, in the order the devices were found (same as CP2130::listDevices(), but without walking the bus)
+std::list<std::string> CP2130DeviceIndex::serials() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::list<std::string> retserials;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        retserials.push_back(entries_[i].serial);
+    }
+    return retserials;
+}
+
+// Returns the number of indexed devices
+size_t CP2130DeviceIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+// Walks the bus once, in order to bring the index up to date
+// Devices that were already indexed are kept as they are, devices that are gone are removed, and only new devices are opened to read their serial numbers
+void CP2130DeviceIndex::refresh(int &errcnt, std::string &errstr)
+{
+    if (!initialized_) {
+        ++errcnt;
+        errstr += "Could not initialize libusb.\n";
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        libusb_device **devs;
+        ssize_t devlist = libusb_get_device_list(context_, &devs);  // Get a device list
+        if (devlist < 0) {  // If the previous operation fails to get a device list
+            ++errcnt;
+            errstr += "Failed to retrieve a list of devices.\n";
+        } else {
+            std::vector<Entry> entries;
+            for (ssize_t i = 0; i < devlist; ++i) {  // Run through all listed devices
+                size_t index = entries_.size();
+                for (size_t j = 0; j < entries_.size(); ++j) {  // Since indexed devices are referenced, libusb keeps listing the same objects for them
+                    if (entries_[j].device == devs[i]) {
+                        index = j;
+                        break;
+                    }
+                }
+                if (index < entries_.size()) {  // If the device is already indexed, its entry (along with its reference) is moved to the new index
+                    entries.push_back(entries_[index]);
+                    entries_[index].device = nullptr;
+                } else {
+                    libusb_device_descriptor desc;
+                    if (libusb_get_device_descriptor(devs[i], &desc) == 0 && desc.idVendor == vid_ && desc.idProduct == pid_) {  // If the device descriptor is retrieved, and both VID and PID correspond to the respective given values
+                        libusb_device_handle *handle;
+                        if (libusb_open(devs[i], &handle) == 0) {  // Open the listed device. If successfull
+                            unsigned char str_desc[256];
+                            if (libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, str_desc, static_cast<int>(sizeof(str_desc))) >= 0) {  // Get the serial number string in ASCII format
+                                Entry entry = {reinterpret_cast<char *>(str_desc), devicePath(devs[i]), libusb_ref_device(devs[i])};
+                                entries.push_back(entry);
+                            }
+                            libusb_close(handle);  // Close the device
+                        }
+                    }
+                }
+            }
+            for (size_t i = 0; i < entries_.size(); ++i) {  // Devices that are gone are released
+                if (entries_[i].device != nullptr) {
+                    libusb_unref_device(entries_[i].device);
+                }
+            }
+            entries_.swap(entries);
+            libusb_free_device_list(devs, 1);  // Free device list
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/* CP2130DeviceIndex class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130DEVICEINDEX_H
+#define CP2130DEVICEINDEX_H
+
+// Includes
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+
+// Index of the devices having a given VID and PID, which maps each serial number to a bus/port path and to a libusb device
+// The bus is walked once per refresh, and only devices that were not indexed before are opened to read their serial numbers
+// Devices can then be opened via CP2130::open(CP2130DeviceIndex &, ...) at the cost of a single open each, instead of one open per device walked
+class CP2130DeviceIndex
+{
+public:
+    struct Entry {
+        std::string serial;     // Serial number
+        std::string path;       // Bus number followed by the port numbers (e.g., "1-4.2")
+        libusb_device *device;  // Device, which is referenced for as long as it is indexed
+    };
+
+private:
+    libusb_context *context_;
+    bool ownsContext_, initialized_;
+    uint16_t vid_, pid_;
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+
+public:
+    CP2130DeviceIndex(uint16_t vid, uint16_t pid);
+    CP2130DeviceIndex(libusb_context *context, uint16_t vid, uint16_t pid);
+    ~CP2130DeviceIndex();
+
+    libusb_context *context() const;
+    libusb_device *device(const std::string &serial) const;
+    std::string path(const std::string &serial) const;
+    std::list<std::string> serials() const;
+    size_t size() const;
+
+    void refresh(int &errcnt, std::string &errstr);
+};
+
+#endif  // CP2130DEVICEINDEX_H
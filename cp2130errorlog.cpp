@@ -0,0 +1,96 @@
+/* CP2130ErrorLog class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <cstdio>
+#include "cp2130errorlog.h"
+
+CP2130ErrorLog::CP2130ErrorLog() :
+    count_(0)
+{
+}
+
+// Returns the number of records logged since construction or since the log was last cleared, including the ones already overwritten
+uint64_t CP2130ErrorLog::count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+// Copies up to "maxRecords" of the most recent records into the given array, from the oldest to the newest, returning the number of records copied
+size_t CP2130ErrorLog::copy(Record *records, size_t maxRecords) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t available = count_ < CAPACITY ? static_cast<size_t>(count_) : CAPACITY;
+    size_t ncopied = maxRecords < available ? maxRecords : available;
+    for (size_t i = 0; i < ncopied; ++i) {
+        records[i] = records_[(count_ - ncopied + i) % CAPACITY];
+    }
+    return ncopied;
+}
+
+// Returns the most recent record, or a record whose code is "NONE" if the log is empty
+CP2130ErrorLog::Record CP2130ErrorLog::last() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Record record;
+    if (count_ == 0) {
+        record = {NONE, 0, 0x00, 0x00, 0x00, std::chrono::system_clock::time_point()};
+    } else {
+        record = records_[(count_ - 1) % CAPACITY];
+    }
+    return record;
+}
+
+// Clears the log
+void CP2130ErrorLog::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_ = 0;
+}
+
+// Logs a record, overwriting the oldest one if the log is full
+// This function does not allocate memory, so it is suitable for the transfer hot path
+void CP2130ErrorLog::log(const Record &record)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_[count_ % CAPACITY] = record;
+    ++count_;
+}
+
+// Formats a record into the same message that CP2130 appends to "errstr"
+std::string CP2130ErrorLog::format(const Record &record)
+{
+    char buffer[64];
+    switch (record.code) {
+        case BULK_OUT:
+            std::snprintf(buffer, sizeof(buffer), "Failed bulk OUT transfer to endpoint %d (address 0x%02x).\n", 0x0f & record.endpointAddr, record.endpointAddr);
+            break;
+        case BULK_IN:
+            std::snprintf(buffer, sizeof(buffer), "Failed bulk IN transfer from endpoint %d (address 0x%02x).\n", 0x0f & record.endpointAddr, record.endpointAddr);
+            break;
+        case CONTROL:
+            std::snprintf(buffer, sizeof(buffer), "Failed control transfer (0x%02x, 0x%02x).\n", record.bmRequestType, record.bRequest);
+            break;
+        default:
+            buffer[0] = '\0';
+    }
+    return std::string(buffer);
+}
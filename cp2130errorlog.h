@@ -0,0 +1,71 @@
+/* CP2130ErrorLog class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130ERRORLOG_H
+#define CP2130ERRORLOG_H
+
+// Includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Bounded log of the transfer failures of a CP2130, which keeps the most recent ones without allocating memory
+class CP2130ErrorLog
+{
+public:
+    enum Code {
+        NONE,      // No error (returned by last() if the log is empty)
+        BULK_OUT,  // Failed bulk OUT transfer
+        BULK_IN,   // Failed bulk IN transfer
+        CONTROL    // Failed control transfer
+    };
+
+    struct Record {
+        Code code;                                        // Kind of failure
+        int result;                                       // Error code returned by libusb, or zero if fewer bytes than expected were transferred
+        uint8_t endpointAddr;                             // Endpoint address (bulk transfers only)
+        uint8_t bmRequestType;                            // Request type (control transfers only)
+        uint8_t bRequest;                                 // Request code (control transfers only)
+        std::chrono::system_clock::time_point timestamp;  // Time of the failure
+    };
+
+    static const size_t CAPACITY = 64;  // Number of records kept, after which the oldest ones are overwritten
+
+private:
+    mutable std::mutex mutex_;
+    Record records_[CAPACITY];
+    uint64_t count_;
+
+public:
+    CP2130ErrorLog();
+
+    uint64_t count() const;
+    size_t copy(Record *records, size_t maxRecords) const;
+    Record last() const;
+
+    void clear();
+    void log(const Record &record);
+
+    static std::string format(const Record &record);
+};
+
+#endif  // CP2130ERRORLOG_H
@@ -0,0 +1,249 @@
+/* CP2130EventMonitor class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include "cp2130eventmonitor.h"
+
+// Definitions
+const double WRAP_MARGIN = 16384.0;  // Number of events expected between polls, which is a quarter of the counter range, so that the rate can grow fourfold between polls before counts are lost
+const double RATE_WINDOW = 0.25;     // Time constant in seconds of the smoothing applied to the estimated rate
+
+// Private callback function for the requests issued by the monitor, which is called from whichever thread is handling the events of the device
+void LIBUSB_CALL CP2130EventMonitor::callback(libusb_transfer *transfer)
+{
+    *static_cast<int *>(transfer->user_data) = 1;
+}
+
+// Private procedure that stops the monitor because of a failed request, which is reported later by stop()
+void CP2130EventMonitor::fail(int result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        running_ = false;
+        ++errcnt_;
+        if (device_.errstrEnabled()) {
+            CP2130ErrorLog::Record record = {
+                CP2130ErrorLog::CONTROL,
+                result,
+                0x00,  // Not applicable to control transfers
+                CP2130::GET,
+                CP2130::GET_EVENT_COUNTER,
+                std::chrono::system_clock::now()
+            };
+            errstr_ += CP2130ErrorLog::format(record);
+        }
+    }
+}
+
+// Private function that issues a Get_Event_Counter request and waits for its response, returning false if the request failed
+bool CP2130EventMonitor::poll(CP2130::EventCounter &evtcntr)
+{
+    libusb_fill_control_setup(buffer_, CP2130::GET, CP2130::GET_EVENT_COUNTER, 0x0000, 0x0000, CP2130::GET_EVENT_COUNTER_WLEN);
+    libusb_fill_control_transfer(transfer_, nullptr, buffer_, callback, &completed_, CP2130::TR_TIMEOUT);  // The device handle is set by CP2130::submitBackgroundTransfer()
+    completed_ = 0;
+    int result = device_.submitBackgroundTransfer(transfer_);  // The device may be in use by another thread, so its state is left untouched
+    int errcnt = 0;
+    std::string errstr;
+    bool cancelled = false;
+    while (result == 0 && completed_ == 0 && device_.isOpen()) {  // The callback is awaited, so that the transfer is never reused or freed while in flight
+        device_.handleBackgroundEvents(CP2130::EVENT_INTERVAL, &completed_, errcnt, errstr);
+        if (errcnt != 0 && !cancelled) {  // If events could not be handled, the request is cancelled
+            device_.cancelTransfer(transfer_);
+            cancelled = true;
+        }
+    }
+    bool retval = false;
+    if (result != 0) {
+        fail(result);
+    } else if (cancelled || completed_ == 0) {  // Events could no longer be handled
+        fail(LIBUSB_ERROR_IO);
+    } else if (transfer_->status != LIBUSB_TRANSFER_COMPLETED || transfer_->actual_length != CP2130::GET_EVENT_COUNTER_WLEN) {
+        fail(CP2130::transferResult(transfer_->status));  // A short transfer yields zero
+    } else {
+        evtcntr = CP2130::decodeEventCounter(buffer_ + LIBUSB_CONTROL_SETUP_SIZE);
+        retval = true;
+    }
+    return retval;
+}
+
+// Private procedure that polls the event counter, and runs in its own thread while monitoring
+// The count is extended by adding the difference between consecutive values modulo 2^16, plus a full wrap if the overflow flag was set although the value did not go backwards
+void CP2130EventMonitor::pollLoop(std::chrono::microseconds maxInterval)
+{
+    CP2130::EventCounter evtcntr;
+    uint64_t polls = 0, count = 0;
+    uint16_t lastValue = 0;
+    bool lastOverflow = false;
+    double rate = 0.0;
+    std::chrono::steady_clock::time_point lastTime;
+    while (running_ && poll(evtcntr)) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double instantRate = 0.0;
+        if (polls == 0) {
+            count = evtcntr.value;
+        } else {
+            uint64_t delta = static_cast<uint16_t>(evtcntr.value - lastValue);
+            if (evtcntr.overflow && !lastOverflow && evtcntr.value >= lastValue) {
+                delta += 0x10000;
+            }
+            count += delta;
+            double elapsed = std::chrono::duration<double>(now - lastTime).count();
+            if (elapsed > 0.0) {
+                instantRate = static_cast<double>(delta) / elapsed;
+                rate = polls == 1 ? instantRate : rate + elapsed / (RATE_WINDOW + elapsed) * (instantRate - rate);  // Exponential smoothing, weighted by the time between polls
+            }
+        }
+        ++polls;
+        lastValue = evtcntr.value;
+        lastOverflow = evtcntr.overflow;
+        lastTime = now;
+        publish(count, rate, now);
+        double schedulingRate = std::max(rate, instantRate);  // The instantaneous rate is also considered, so that the interval shrinks as soon as the rate rises
+        std::chrono::microseconds interval = maxInterval;
+        if (polls == 1) {  // The second poll is done right away, since the rate is not known yet
+            interval = std::chrono::microseconds(0);
+        } else if (schedulingRate > 0.0 && WRAP_MARGIN * 1000000.0 / schedulingRate < static_cast<double>(maxInterval.count())) {
+            interval = std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(WRAP_MARGIN * 1000000.0 / schedulingRate));
+        }
+        interval_ = static_cast<uint64_t>(interval.count());
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait_until(lock, now + interval, [this] {
+            return !running_;
+        });
+    }
+}
+
+// Private procedure that publishes a snapshot, which is only ever done by the polling thread
+// The sequence number is odd while the fields are being written, so that readers can retry instead of getting a torn snapshot
+void CP2130EventMonitor::publish(uint64_t count, double rate, std::chrono::steady_clock::time_point timestamp)
+{
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    count_.store(count, std::memory_order_relaxed);
+    rate_.store(rate, std::memory_order_relaxed);
+    timestamp_.store(timestamp.time_since_epoch().count(), std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+// Creates an event counter monitor for the given device, which must be open while start() is called
+CP2130EventMonitor::CP2130EventMonitor(CP2130 &device) :
+    device_(device),
+    transfer_(nullptr),
+    completed_(0),
+    sequence_(0),
+    count_(0),
+    rate_(0.0),
+    timestamp_(0),
+    interval_(0),
+    running_(false),
+    errcnt_(0)
+{
+}
+
+CP2130EventMonitor::~CP2130EventMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        wake_.notify_all();
+    }
+    if (pollThread_.joinable()) {
+        pollThread_.join();
+    }
+    libusb_free_transfer(transfer_);
+}
+
+// Returns the current interval between polls, in microseconds
+uint64_t CP2130EventMonitor::interval() const
+{
+    return interval_;
+}
+
+// Returns true while monitoring, or false otherwise (i.e., if the monitor was never started, was stopped, or stopped because a request failed)
+bool CP2130EventMonitor::isRunning() const
+{
+    return running_;
+}
+
+// Returns the latest count and rate, which never blocks the monitor
+CP2130EventMonitor::Snapshot CP2130EventMonitor::snapshot() const
+{
+    Snapshot retsnapshot;
+    uint32_t sequence;
+    do {
+        sequence = sequence_.load(std::memory_order_acquire);
+        retsnapshot.count = count_.load(std::memory_order_relaxed);
+        retsnapshot.rate = rate_.load(std::memory_order_relaxed);
+        retsnapshot.timestamp = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(timestamp_.load(std::memory_order_relaxed)));
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0 || sequence_.load(std::memory_order_relaxed) != sequence);
+    return retsnapshot;
+}
+
+// Starts monitoring, polling the event counter at least once every given number of milliseconds
+// The count starts at the value held by the device, and the snapshot from any previous run is discarded
+void CP2130EventMonitor::start(unsigned int maxInterval, int &errcnt, std::string &errstr)
+{
+    if (running_) {
+        ++errcnt;
+        errstr += "In start(): the monitor is already running.\n";  // Program logic error
+    } else if (!device_.isOpen()) {
+        ++errcnt;
+        errstr += "In start(): device is not open.\n";  // Program logic error
+    } else {
+        if (pollThread_.joinable()) {  // The monitor may have stopped by itself
+            pollThread_.join();
+        }
+        if (transfer_ == nullptr) {  // The transfer is allocated once and reused by subsequent runs
+            transfer_ = libusb_alloc_transfer(0);
+        }
+        if (transfer_ == nullptr) {
+            ++errcnt;
+            errstr += "In start(): could not allocate transfer.\n";
+        } else {
+            errcnt_ = 0;
+            errstr_.clear();
+            publish(0, 0.0, std::chrono::steady_clock::time_point());
+            interval_ = 1000 * static_cast<uint64_t>(maxInterval);
+            running_ = true;
+            pollThread_ = std::thread(&CP2130EventMonitor::pollLoop, this, std::chrono::microseconds(1000 * static_cast<std::chrono::microseconds::rep>(maxInterval)));
+        }
+    }
+}
+
+// Stops monitoring, and reports the failure that stopped the monitor by itself, if that was the case
+// The last snapshot is kept until the monitor is started again
+void CP2130EventMonitor::stop(int &errcnt, std::string &errstr)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        wake_.notify_all();
+    }
+    if (pollThread_.joinable()) {
+        pollThread_.join();
+    }
+    errcnt += errcnt_;
+    errstr += errstr_;
+    errcnt_ = 0;
+    errstr_.clear();
+}
@@ -0,0 +1,89 @@
+/* CP2130EventMonitor class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130EVENTMONITOR_H
+#define CP2130EVENTMONITOR_H
+
+// Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Background monitor of the event counter of a CP2130 (GPIO.4/EVTCNTR), which extends the 16-bit count to 64 bits and estimates the event rate
+// The counter is polled often enough that it cannot wrap more than once between polls, based on the rate observed, and the latest count and rate can be read at any time without locking
+// The pin must be configured as an event counter input beforehand (see CP2130::setEventCounter() and CP2130::writePinConfig())
+// The device can still be used while monitoring, since the monitor thread stops handling events while an operation of the device holds its event lock (see CP2130::lockEvents()), whose event handling then completes the requests of the monitor
+// Requests are submitted using CP2130::submitBackgroundTransfer(), so that the monitor never changes the state of the device, but the device must not be closed while monitoring
+class CP2130EventMonitor
+{
+public:
+    struct Snapshot {
+        uint64_t count;                                   // Event count, extended to 64 bits
+        double rate;                                      // Estimated event rate, in hertz
+        std::chrono::steady_clock::time_point timestamp;  // Time at which the count was received (zero if the counter was never polled)
+    };
+
+    static const unsigned int MAX_INTERVAL_DEFAULT = 100;  // Default maximum interval between polls, in milliseconds
+
+private:
+    CP2130 &device_;
+    libusb_transfer *transfer_;
+    unsigned char buffer_[LIBUSB_CONTROL_SETUP_SIZE + CP2130::GET_EVENT_COUNTER_WLEN];
+    int completed_;
+    std::atomic<uint32_t> sequence_;  // Odd while a snapshot is being published
+    std::atomic<uint64_t> count_;
+    std::atomic<double> rate_;
+    std::atomic<std::chrono::steady_clock::rep> timestamp_;
+    std::atomic<uint64_t> interval_;  // Current interval between polls, in microseconds
+    std::atomic<bool> running_;
+    std::thread pollThread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    int errcnt_;                      // Failures that stopped the monitor, reported by stop()
+    std::string errstr_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    void fail(int result);
+    bool poll(CP2130::EventCounter &evtcntr);
+    void pollLoop(std::chrono::microseconds maxInterval);
+    void publish(uint64_t count, double rate, std::chrono::steady_clock::time_point timestamp);
+
+public:
+    explicit CP2130EventMonitor(CP2130 &device);
+    ~CP2130EventMonitor();
+
+    CP2130EventMonitor(const CP2130EventMonitor &) = delete;
+    CP2130EventMonitor &operator =(const CP2130EventMonitor &) = delete;
+
+    uint64_t interval() const;
+    bool isRunning() const;
+    Snapshot snapshot() const;
+
+    void start(unsigned int maxInterval, int &errcnt, std::string &errstr);
+    void stop(int &errcnt, std::string &errstr);
+};
+
+#endif  // CP2130EVENTMONITOR_H
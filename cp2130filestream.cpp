@@ -0,0 +1,256 @@
+/* CP2130FileStream class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include "cp2130filestream.h"
+
+// Definitions
+const uint64_t MIN_BYTE_RATE = 11718;  // Rate of the SPI bus at its slowest clock [93.75kHz], in bytes per second, from which the time taken to clock out queued data is estimated
+
+// Private callback function for the transfers issued by the stream, which is called from within CP2130::handleEvents()
+void LIBUSB_CALL CP2130FileStream::callback(libusb_transfer *transfer)
+{
+    Buffer *buffer = static_cast<Buffer *>(transfer->user_data);
+    CP2130FileStream *stream = buffer->stream;
+    if ((transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != transfer->length) && transfer->status != LIBUSB_TRANSFER_CANCELLED && stream->failedTransfer_ == nullptr) {  // Only the first failure is reported, and transfers are only cancelled after a failure
+        stream->failedTransfer_ = transfer;
+    }
+    stream->queued_ -= static_cast<uint64_t>(transfer->length);
+    --buffer->pending;
+    stream->completed_ = 1;
+}
+
+// Private function that moves the given number of bytes in the given direction, returning the number of payload bytes carried by the batches that completed
+// The data is split in batches of up to one buffer each, and a batch is submitted as soon as a buffer is free, so that the next batch is already in flight while the file I/O of the previous one is done
+// Every batch of a Write command is aligned to the stream formed by the command header and its payload, so that every packet is full except the last one
+uint32_t CP2130FileStream::run(Mode mode, int fd, const uint8_t *data, uint32_t length, int &errcnt, std::string &errstr)
+{
+    uint32_t transferred = 0;
+    int preverrcnt = errcnt;
+    uint8_t endpointInAddr = 0x00, endpointOutAddr = 0x00;
+    if (!device_.isOpen()) {
+        ++errcnt;
+        errstr += mode == READ_FILE ? "In readToFile(): device is not open.\n" : (mode == WRITE_FILE ? "In writeFromFile(): device is not open.\n" : "In writeFromMemory(): device is not open.\n");  // Program logic error
+    } else {
+        endpointInAddr = device_.getEndpointInAddr(errcnt, errstr);
+        endpointOutAddr = device_.getEndpointOutAddr(errcnt, errstr);
+        for (size_t i = 0; mode != WRITE_MEMORY && i < NBUFFERS; ++i) {  // The buffers are obtained from the buffer pool of the device, which keeps them for the next call
+            buffers_[i].data = device_.bufferPool().acquire(bufferSize_);
+        }
+    }
+    device_.lockEvents();  // The callback changes the state read below, so it must not be called by a background thread meanwhile
+    failedTransfer_ = nullptr;
+    queued_ = 0;
+    uint32_t position = 0;  // Number of payload bytes assigned to batches
+    size_t next = 0, oldest = 0, nbusy = 0;
+    bool failed = errcnt != preverrcnt;
+    while (!failed && (position < length || nbusy > 0)) {
+        while (!failed && nbusy < NBUFFERS && position < length) {  // Every free buffer gets the next batch
+            Buffer &buffer = buffers_[next];
+            buffer.ntransfers = 0;
+            buffer.pending = 0;
+            size_t headroom = position == 0 && mode != READ_FILE ? CP2130::CMD_HEADER_SIZE : 0;
+            buffer.length = static_cast<uint32_t>(std::min<size_t>(bufferSize_ - headroom, length - position));
+            if (mode == READ_FILE) {
+                if (position == 0) {
+                    CP2130::fillCommandHeader(commandBuffer_, CP2130::READ, length);
+                    failed = !submit(buffer, endpointOutAddr, commandBuffer_, CP2130::CMD_HEADER_SIZE, errcnt, errstr);
+                }
+                failed = failed || !submit(buffer, endpointInAddr, buffer.data, buffer.length, errcnt, errstr);
+            } else if (mode == WRITE_FILE) {
+                if (position == 0) {
+                    CP2130::fillCommandHeader(buffer.data, CP2130::WRITE, length);
+                }
+                size_t bytesRead = 0;
+                while (bytesRead < buffer.length) {
+                    ssize_t result = ::read(fd, buffer.data + headroom + bytesRead, buffer.length - bytesRead);
+                    if (result > 0) {
+                        bytesRead += static_cast<size_t>(result);
+                    } else if (result == 0 || errno != EINTR) {
+                        ++errcnt;
+                        errstr += result == 0 ? "Unexpected end of file.\n" : "Could not read from file: " + std::string(std::strerror(errno)) + ".\n";
+                        failed = true;
+                        break;
+                    }
+                }
+                failed = failed || !submit(buffer, endpointOutAddr, buffer.data, headroom + buffer.length, errcnt, errstr);
+            } else {
+                unsigned char *payload = const_cast<unsigned char *>(data + position);  // Bulk OUT transfers do not modify their buffers
+                size_t offset = 0;
+                if (position == 0) {  // The command header cannot be placed in front of the payload, so it is sent along with the start of the payload, which fills a whole packet
+                    offset = std::min<size_t>(buffer.length, sizeof(commandBuffer_) - CP2130::CMD_HEADER_SIZE);
+                    CP2130::fillCommandHeader(commandBuffer_, CP2130::WRITE, length);
+                    std::memcpy(commandBuffer_ + CP2130::CMD_HEADER_SIZE, payload, offset);
+                    failed = !submit(buffer, endpointOutAddr, commandBuffer_, CP2130::CMD_HEADER_SIZE + offset, errcnt, errstr);
+                }
+                failed = failed || !submit(buffer, endpointOutAddr, payload + offset, buffer.length - offset, errcnt, errstr);
+            }
+            position += buffer.length;
+            ++nbusy;  // Even if it failed, the batch is waited for, since part of it may be in flight
+            next = (next + 1) % NBUFFERS;
+        }
+        if (nbusy > 0) {
+            Buffer &buffer = buffers_[oldest];
+            while (!failed && buffer.pending > 0 && failedTransfer_ == nullptr) {
+                int prevevterrcnt = errcnt;
+                completed_ = 0;
+                device_.handleEvents(CP2130::EVENT_INTERVAL, &completed_, errcnt, errstr);
+                failed = errcnt != prevevterrcnt;
+            }
+            failed = failed || failedTransfer_ != nullptr;
+            if (!failed && mode == READ_FILE) {  // Meanwhile, the next batch is in flight
+                size_t bytesWritten = 0;
+                while (bytesWritten < buffer.length) {
+                    ssize_t result = ::write(fd, buffer.data + bytesWritten, buffer.length - bytesWritten);
+                    if (result >= 0) {
+                        bytesWritten += static_cast<size_t>(result);
+                    } else if (errno != EINTR) {
+                        ++errcnt;
+                        errstr += "Could not write to file: " + std::string(std::strerror(errno)) + ".\n";
+                        failed = true;
+                        break;
+                    }
+                }
+            }
+            if (!failed) {
+                transferred += buffer.length;
+                --nbusy;
+                oldest = (oldest + 1) % NBUFFERS;
+            }
+        }
+    }
+    if (failed) {  // On failure, every transfer still in flight is cancelled, and the stream waits for them to complete before the buffers can be reused
+        for (size_t i = 0; i < NBUFFERS; ++i) {
+            for (size_t j = 0; buffers_[i].pending > 0 && j < buffers_[i].ntransfers; ++j) {
+                device_.cancelTransfer(buffers_[i].transfers[j]);
+            }
+        }
+        for (size_t i = 0; i < NBUFFERS; ++i) {
+            while (buffers_[i].pending > 0) {
+                int prevevterrcnt = errcnt;
+                completed_ = 0;
+                device_.handleEvents(CP2130::EVENT_INTERVAL, &completed_, errcnt, errstr);
+                if (errcnt != prevevterrcnt) {  // Events can no longer be handled (e.g., the device was closed)
+                    break;
+                }
+            }
+        }
+        if (failedTransfer_ != nullptr) {
+            device_.checkFullTransfer(failedTransfer_, errcnt, errstr);  // Short bulk transfers are also reported
+        }
+    }
+    device_.unlockEvents();
+    for (size_t i = 0; i < NBUFFERS; ++i) {
+        device_.bufferPool().release(buffers_[i].data);
+        buffers_[i].data = nullptr;
+    }
+    return transferred;
+}
+
+// Private function that submits the given data as bulk transfers of up to "TRANSFER_SIZE" bytes each, which are added to the batch of the given buffer, returning false if a transfer could not be submitted
+// The timeout of each transfer allows for the data queued ahead of it, which may take a while to go through at slow SPI clocks
+bool CP2130FileStream::submit(Buffer &buffer, uint8_t endpointAddr, unsigned char *data, size_t length, int &errcnt, std::string &errstr)
+{
+    bool submitted = true;
+    for (size_t offset = 0; submitted && offset < length; offset += TRANSFER_SIZE) {
+        if (buffer.ntransfers == buffer.transfers.size()) {  // Transfers are allocated once and reused by subsequent batches
+            libusb_transfer *transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr) {
+                ++errcnt;
+                errstr += "Could not allocate transfers.\n";
+                submitted = false;
+                break;
+            }
+            buffer.transfers.push_back(transfer);
+        }
+        libusb_transfer *transfer = buffer.transfers[buffer.ntransfers];
+        size_t chunk = length - offset < TRANSFER_SIZE ? length - offset : TRANSFER_SIZE;
+        unsigned int timeout = static_cast<unsigned int>(CP2130::TR_TIMEOUT + (queued_ + chunk) * 1000 / MIN_BYTE_RATE);
+        libusb_fill_bulk_transfer(transfer, nullptr, endpointAddr, data + offset, static_cast<int>(chunk), callback, &buffer, timeout);  // The device handle is set by CP2130::submitTransfer()
+        int preverrcnt = errcnt;
+        device_.submitTransfer(transfer, errcnt, errstr);
+        submitted = errcnt == preverrcnt;  // The failure is already reported by submitTransfer()
+        if (submitted) {
+            ++buffer.ntransfers;
+            ++buffer.pending;
+            queued_ += chunk;
+        }
+    }
+    return submitted;
+}
+
+// Creates a stream for the given device, whose buffers are the given size (rounded up to a multiple of "TRANSFER_SIZE")
+CP2130FileStream::CP2130FileStream(CP2130 &device, size_t bufferSize) :
+    device_(device),
+    bufferSize_(std::max<size_t>(1, (bufferSize + TRANSFER_SIZE - 1) / TRANSFER_SIZE) * TRANSFER_SIZE),
+    failedTransfer_(nullptr),
+    queued_(0),
+    completed_(0)
+{
+    for (size_t i = 0; i < NBUFFERS; ++i) {
+        buffers_[i].stream = this;
+        buffers_[i].data = nullptr;
+        buffers_[i].ntransfers = 0;
+        buffers_[i].pending = 0;
+        buffers_[i].length = 0;
+    }
+}
+
+CP2130FileStream::~CP2130FileStream()
+{
+    for (size_t i = 0; i < NBUFFERS; ++i) {
+        for (size_t j = 0; j < buffers_[i].transfers.size(); ++j) {
+            libusb_free_transfer(buffers_[i].transfers[j]);
+        }
+    }
+}
+
+// Returns the size of each buffer
+size_t CP2130FileStream::bufferSize() const
+{
+    return bufferSize_;
+}
+
+// Reads the given number of bytes from the SPI bus, and writes them to the given file descriptor, returning the number of bytes written
+// The data is written in whole buffers, so on failure, the bytes returned are those of the buffers written before the failure
+// To read into memory, including a memory-mapped file, CP2130::spiRead(uint8_t *, ...) already avoids any intermediate copy
+uint32_t CP2130FileStream::readToFile(int fd, uint32_t bytesToRead, int &errcnt, std::string &errstr)
+{
+    return run(READ_FILE, fd, nullptr, bytesToRead, errcnt, errstr);
+}
+
+// Reads the given number of bytes from the given file descriptor, and writes them to the SPI bus, returning the number of bytes transferred
+// If the file ends early or a transfer fails, the device is left expecting the rest of the payload, and should be reset (see CP2130::reset())
+uint32_t CP2130FileStream::writeFromFile(int fd, uint32_t bytesToWrite, int &errcnt, std::string &errstr)
+{
+    return run(WRITE_FILE, fd, nullptr, bytesToWrite, errcnt, errstr);
+}
+
+// Writes the given number of bytes from the given memory, such as a memory-mapped file, to the SPI bus, returning the number of bytes transferred
+// Unlike CP2130::spiWrite(uint8_t *, ...), no room for the command header is required, and only the first 56 bytes are copied
+// If a transfer fails, the device is left expecting the rest of the payload, and should be reset (see CP2130::reset())
+uint32_t CP2130FileStream::writeFromMemory(const uint8_t *data, uint32_t bytesToWrite, int &errcnt, std::string &errstr)
+{
+    return run(WRITE_MEMORY, -1, data, bytesToWrite, errcnt, errstr);
+}
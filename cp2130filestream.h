@@ -0,0 +1,85 @@
+/* CP2130FileStream class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130FILESTREAM_H
+#define CP2130FILESTREAM_H
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Streams SPI reads and writes of any length between a CP2130 and a file descriptor, using two fixed-size buffers, so that memory use does not depend on the transfer size
+// While the bulk transfers of one buffer are in flight, the other buffer is written to or read from the file, so that USB transfers overlap with file I/O
+// Either way, a single Read or Write command is issued, so that the chip select stays asserted for the whole transfer, as with CP2130::spiRead() and CP2130::spiWrite()
+class CP2130FileStream
+{
+public:
+    static const size_t BUFFER_SIZE_DEFAULT = 0x40000;  // Default size of each buffer, in bytes [256KiB]
+    static const size_t TRANSFER_SIZE = 0x4000;         // Size of each bulk transfer, which must be a multiple of 64 so that only the last packet can be short [16KiB]
+
+private:
+    enum Mode {
+        READ_FILE,    // From the SPI bus to a file
+        WRITE_FILE,   // From a file to the SPI bus
+        WRITE_MEMORY  // From memory to the SPI bus
+    };
+
+    struct Buffer {
+        CP2130FileStream *stream;                  // Stream to which the buffer belongs
+        unsigned char *data;                       // Buffer obtained from the buffer pool of the device, while a transfer is running
+        std::vector<libusb_transfer *> transfers;  // Transfers, which are allocated as needed and reused by subsequent batches
+        size_t ntransfers;                         // Number of transfers used by the current batch
+        size_t pending;                            // Number of transfers of the current batch still in flight
+        uint32_t length;                           // Number of payload bytes carried by the current batch
+    };
+
+    static const size_t NBUFFERS = 2;
+
+    CP2130 &device_;
+    size_t bufferSize_;
+    Buffer buffers_[NBUFFERS];
+    unsigned char commandBuffer_[64];        // Read command, or Write command followed by the start of its payload when writing from memory (a whole packet)
+    const libusb_transfer *failedTransfer_;  // First transfer that failed, if any
+    uint64_t queued_;                        // Number of bytes submitted but not yet transferred
+    int completed_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    uint32_t run(Mode mode, int fd, const uint8_t *data, uint32_t length, int &errcnt, std::string &errstr);
+    bool submit(Buffer &buffer, uint8_t endpointAddr, unsigned char *data, size_t length, int &errcnt, std::string &errstr);
+
+public:
+    explicit CP2130FileStream(CP2130 &device, size_t bufferSize = BUFFER_SIZE_DEFAULT);
+    ~CP2130FileStream();
+
+    CP2130FileStream(const CP2130FileStream &) = delete;
+    CP2130FileStream &operator =(const CP2130FileStream &) = delete;
+
+    size_t bufferSize() const;
+
+    uint32_t readToFile(int fd, uint32_t bytesToRead, int &errcnt, std::string &errstr);
+    uint32_t writeFromFile(int fd, uint32_t bytesToWrite, int &errcnt, std::string &errstr);
+    uint32_t writeFromMemory(const uint8_t *data, uint32_t bytesToWrite, int &errcnt, std::string &errstr);
+};
+
+#endif  // CP2130FILESTREAM_H
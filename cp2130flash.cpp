@@ -0,0 +1,395 @@
+/* CP2130Flash class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "cp2130flash.h"
+
+// Definitions
+const size_t READ_CHUNK = 0x1000000;              // Maximum length of each Read command issued by read(), which bounds the number of bulk transfers prepared at once
+const size_t SFDP_OVERHEAD = 5;                   // Length of the Read SFDP instruction, address and dummy byte
+const std::chrono::microseconds POLL_MIN(20);     // Shortest interval between status polls
+const std::chrono::microseconds POLL_MAX(10000);  // Longest interval between status polls
+const unsigned int PROGRAM_TIMEOUT = 50;          // Page program timeout in milliseconds
+const unsigned int SECTOR_ERASE_TIMEOUT = 2000;   // Sector erase timeout in milliseconds
+const unsigned int CHIP_ERASE_TIMEOUT = 600000;   // Chip erase timeout in milliseconds
+const uint32_t SFDP_SIGNATURE = 0x50444653;       // "SFDP" (little-endian)
+
+// Private callback function for the transfers issued by writeEnabled(), which is called from within CP2130::handleEvents()
+void LIBUSB_CALL CP2130Flash::callback(libusb_transfer *transfer)
+{
+    CP2130Flash *flash = static_cast<CP2130Flash *>(transfer->user_data);
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != transfer->length) {
+        flash->failed_ = true;
+    }
+    if (--flash->remaining_ == 0) {
+        flash->completed_ = 1;
+    }
+}
+
+// Private function that writes the given address to the given buffer, returning the number of bytes written
+size_t CP2130Flash::fillAddress(unsigned char *buffer, uint32_t address) const
+{
+    size_t nbytes = geometry_.addressBytes;
+    for (size_t i = 0; i < nbytes; ++i) {
+        buffer[i] = static_cast<uint8_t>(address >> 8 * (nbytes - i - 1));  // Big-endian
+    }
+    return nbytes;
+}
+
+// Private function that returns true if the given range lies within the flash, or if the capacity is unknown
+bool CP2130Flash::inRange(uint32_t address, size_t length) const
+{
+    return geometry_.size == 0 || static_cast<uint64_t>(address) + length <= geometry_.size;
+}
+
+// Private function that reads the status register, assuming the channel is already selected
+uint8_t CP2130Flash::statusRegister(int &errcnt, std::string &errstr)
+{
+    uint8_t dataOut[2] = {RDSR, 0x00}, dataIn[2] = {0x00, 0x00};
+    device_.spiWriteRead(dataOut, dataIn, sizeof(dataOut), errcnt, errstr);
+    return dataIn[1];
+}
+
+// Private function that polls the status register until the write in progress bit clears, returning false if that does not happen within the given timeout (in milliseconds)
+// Most of the typical time of the operation is slept through before the first poll, and the interval between polls then doubles, so that short operations are detected promptly without flooding the bus during long ones
+bool CP2130Flash::waitReady(std::chrono::microseconds &typical, unsigned int timeout, int &errcnt, std::string &errstr)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), deadline = start + std::chrono::milliseconds(timeout);
+    std::this_thread::sleep_for(typical * 3 / 4);
+    std::chrono::microseconds interval = POLL_MIN, busy(0), sample(0);
+    bool ready = false;
+    int preverrcnt = errcnt;
+    while (errcnt == preverrcnt) {
+        std::chrono::steady_clock::time_point issued = std::chrono::steady_clock::now();
+        if ((SRWIP & statusRegister(errcnt, errstr)) == 0x00) {
+            ready = errcnt == preverrcnt;
+            sample = (busy + std::chrono::duration_cast<std::chrono::microseconds>(issued - start)) / 2;  // The operation ended between the last poll that found it busy and this one
+            break;
+        } else if (std::chrono::steady_clock::now() >= deadline) {
+            ++errcnt;
+            errstr += "Timed out waiting for the flash to become ready.\n";
+            break;
+        }
+        busy = std::chrono::duration_cast<std::chrono::microseconds>(issued - start);
+        std::this_thread::sleep_for(interval);
+        interval = std::min(2 * interval, POLL_MAX);
+    }
+    if (ready) {  // The typical time follows the operations as they complete, and shrinks whenever the first poll already finds the operation done
+        typical = (3 * typical + sample) / 4;
+    }
+    return ready;
+}
+
+// Private procedure that issues Write Enable followed by the given instruction, as two Write commands that are submitted at once
+// Each command asserts the chip select on its own, as the flash requires, but both cost a single round trip instead of one each
+void CP2130Flash::writeEnabled(uint8_t opcode, bool addressed, uint32_t address, const uint8_t *data, size_t length, int &errcnt, std::string &errstr)
+{
+    for (size_t i = 0; i < 2; ++i) {  // Transfers are allocated once and reused by subsequent calls
+        if (transfers_[i] == nullptr) {
+            transfers_[i] = libusb_alloc_transfer(0);
+        }
+    }
+    if (transfers_[0] == nullptr || transfers_[1] == nullptr) {
+        ++errcnt;
+        errstr += "Could not allocate transfers.\n";
+    } else {
+        size_t wrenLength = CP2130::CMD_HEADER_SIZE + 1;
+        buffer_.resize(wrenLength + CP2130::CMD_HEADER_SIZE + 1 + geometry_.addressBytes + length);  // The buffer is kept between calls, so this only allocates when a larger page is programmed
+        unsigned char *wren = buffer_.data(), *instruction = wren + wrenLength + CP2130::CMD_HEADER_SIZE;
+        instruction[0] = opcode;
+        size_t instructionLength = 1 + (addressed ? fillAddress(instruction + 1, address) : 0);
+        if (length > 0) {
+            std::memcpy(instruction + instructionLength, data, length);
+            instructionLength += length;
+        }
+        wren[CP2130::CMD_HEADER_SIZE] = WREN;
+        unsigned char *frames[2] = {wren, wren + wrenLength};
+        size_t payloads[2] = {1, instructionLength};
+        uint8_t endpointOutAddr = device_.getEndpointOutAddr(errcnt, errstr);
+        for (size_t i = 0; i < 2; ++i) {
+            CP2130::fillCommandHeader(frames[i], CP2130::WRITE, static_cast<uint32_t>(payloads[i]));
+            libusb_fill_bulk_transfer(transfers_[i], nullptr, endpointOutAddr, frames[i], static_cast<int>(CP2130::CMD_HEADER_SIZE + payloads[i]), callback, this, CP2130::TR_TIMEOUT);  // The device handle is set by CP2130::submitTransfer()
+        }
+        device_.lockEvents();  // The callback changes the state read below, so it must not be called by a background thread meanwhile
+        remaining_ = 0;
+        completed_ = 0;
+        failed_ = false;
+        size_t nsubmitted = 0;
+        int preverrcnt = errcnt;
+        while (nsubmitted < 2 && errcnt == preverrcnt) {  // The instruction is not submitted if Write Enable could not be
+            device_.submitTransfer(transfers_[nsubmitted], errcnt, errstr);
+            if (errcnt == preverrcnt) {
+                ++remaining_;
+                ++nsubmitted;
+            }
+        }
+        bool cancelled = false, evtfailed = false;
+        while (remaining_ > 0 && device_.isOpen()) {  // Every callback is awaited, so that no transfer is reused or freed while in flight
+            if ((failed_ || evtfailed) && !cancelled) {  // If Write Enable fails, or if events could not be handled, the transfers still in flight are cancelled
+                for (size_t i = 0; i < nsubmitted; ++i) {
+                    device_.cancelTransfer(transfers_[i]);
+                }
+                cancelled = true;
+            }
+            int evterrcnt = 0;
+            std::string evterrstr;
+            device_.handleEvents(CP2130::EVENT_INTERVAL, &completed_, evterrcnt, evterrstr);
+            if (evterrcnt != 0 && !evtfailed) {  // This failure is only reported once
+                ++errcnt;
+                errstr += evterrstr;
+                evtfailed = true;
+            }
+        }
+        device_.unlockEvents();
+        for (size_t i = 0; i < nsubmitted && remaining_ == 0; ++i) {
+            device_.checkFullTransfer(transfers_[i], errcnt, errstr);  // Short bulk transfers are also reported
+        }
+    }
+}
+
+// Creates a driver for the flash attached to the given SPI channel of the given device
+// The channel should be configured beforehand (see CP2130::configureSPIMode()), and probe() should be called before anything else, so that the geometry of the flash is known
+CP2130Flash::CP2130Flash(CP2130 &device, uint8_t channel) :
+    device_(device),
+    channel_(channel),
+    remaining_(0),
+    completed_(0),
+    failed_(false),
+    programTime_(700),
+    sectorEraseTime_(45000),
+    chipEraseTime_(1000000)
+{
+    Geometry geometry = {0x000000, false, 0, 256, 4096, SE, 3};  // Until probe() is called, a small flash with 256-byte pages and 4KiB sectors is assumed
+    geometry_ = geometry;
+    transfers_[0] = nullptr;
+    transfers_[1] = nullptr;
+}
+
+CP2130Flash::~CP2130Flash()
+{
+    libusb_free_transfer(transfers_[0]);
+    libusb_free_transfer(transfers_[1]);
+}
+
+// Returns the SPI channel of the flash
+uint8_t CP2130Flash::channel() const
+{
+    return channel_;
+}
+
+// Returns the geometry of the flash, as found by probe()
+const CP2130Flash::Geometry &CP2130Flash::geometry() const
+{
+    return geometry_;
+}
+
+// Erases the whole flash
+void CP2130Flash::eraseChip(int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    device_.selectCS(channel_, errcnt, errstr);
+    if (errcnt == preverrcnt) {
+        writeEnabled(CE, false, 0x00000000, nullptr, 0, errcnt, errstr);
+    }
+    if (errcnt == preverrcnt) {
+        waitReady(chipEraseTime_, CHIP_ERASE_TIMEOUT, errcnt, errstr);
+    }
+}
+
+// Erases the sector that contains the given address
+void CP2130Flash::eraseSector(uint32_t address, int &errcnt, std::string &errstr)
+{
+    if (!inRange(address, 1)) {
+        ++errcnt;
+        errstr += "In eraseSector(): address exceeds the capacity of the flash.\n";  // Program logic error
+    } else {
+        int preverrcnt = errcnt;
+        device_.selectCS(channel_, errcnt, errstr);
+        if (errcnt == preverrcnt) {
+            writeEnabled(geometry_.sectorEraseOpcode, true, address, nullptr, 0, errcnt, errstr);
+        }
+        if (errcnt == preverrcnt) {
+            waitReady(sectorEraseTime_, SECTOR_ERASE_TIMEOUT, errcnt, errstr);
+        }
+    }
+}
+
+// Identifies the flash via its JEDEC ID and SFDP tables, and returns its geometry, which is also kept for subsequent operations
+// If the flash has no SFDP tables, the capacity is deduced from the JEDEC ID, assuming the common encoding where the last byte is its base-2 logarithm
+CP2130Flash::Geometry CP2130Flash::probe(int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    Geometry geometry = {0x000000, false, 0, 256, 4096, SE, 3};
+    geometry.jedecID = readJEDECID(errcnt, errstr);
+    std::vector<uint8_t> header = readSFDP(0x000000, 16, errcnt, errstr);  // SFDP header followed by the first parameter header, which belongs to the basic flash parameter table
+    if (errcnt == preverrcnt) {
+        uint32_t signature = static_cast<uint32_t>(header[3] << 24 | header[2] << 16 | header[1] << 8 | header[0]);
+        size_t ndwords = std::min<size_t>(header[11], 16);  // Only the first 16 DWORDs are used
+        if (signature == SFDP_SIGNATURE && header[8] == 0x00 && header[15] == 0xff && ndwords >= 2) {
+            uint32_t pointer = static_cast<uint32_t>(header[14] << 16 | header[13] << 8 | header[12]);
+            std::vector<uint8_t> table = readSFDP(pointer, 4 * ndwords, errcnt, errstr);
+            if (errcnt == preverrcnt) {
+                uint32_t dwords[16] = {0};
+                for (size_t i = 0; i < ndwords; ++i) {
+                    dwords[i] = static_cast<uint32_t>(table[4 * i + 3] << 24 | table[4 * i + 2] << 16 | table[4 * i + 1] << 8 | table[4 * i]);
+                }
+                geometry.sfdp = true;
+                if ((0x80000000 & dwords[1]) == 0) {  // Density in bits, minus one
+                    geometry.size = (static_cast<uint64_t>(dwords[1]) + 1) / 8;
+                } else if ((0x7fffffff & dwords[1]) < 64) {  // Density as a power of two, in bits
+                    geometry.size = (static_cast<uint64_t>(1) << (0x7fffffff & dwords[1])) / 8;
+                }
+                if ((0x03 & dwords[0]) == 0x01) {  // 4KiB erase is supported, and its instruction is given in the first DWORD
+                    geometry.sectorEraseOpcode = static_cast<uint8_t>(dwords[0] >> 8);
+                } else if (ndwords >= 8 && (0xff & dwords[7]) != 0x00) {  // Otherwise, the first erase type is used
+                    geometry.sectorSize = static_cast<uint32_t>(1) << (0x1f & dwords[7]);
+                    geometry.sectorEraseOpcode = static_cast<uint8_t>(dwords[7] >> 8);
+                }
+                if (ndwords >= 11) {  // Page size as a power of two, since JESD216A
+                    geometry.pageSize = static_cast<uint32_t>(1) << (0x0f & dwords[10] >> 4);
+                }
+            }
+        } else if ((0xff & geometry.jedecID) >= 0x10 && (0xff & geometry.jedecID) <= 0x19) {
+            geometry.size = static_cast<uint64_t>(1) << (0xff & geometry.jedecID);
+        }
+    }
+    if (errcnt == preverrcnt) {
+        if (geometry.size > 0x1000000) {  // Flash devices larger than 16MiB require 4-byte addresses, which are used via the dedicated instructions, so that the addressing mode of the flash is never changed
+            geometry.addressBytes = 4;
+            geometry.sectorEraseOpcode = geometry.sectorEraseOpcode == SE ? SE4 : (geometry.sectorEraseOpcode == 0x52 ? 0x5c : (geometry.sectorEraseOpcode == 0xd8 ? 0xdc : geometry.sectorEraseOpcode));
+        }
+        geometry_ = geometry;
+    }
+    return geometry_;
+}
+
+// Programs the given data starting at the given address, which may span several pages (the range should be erased beforehand)
+// Each page is programmed with Write Enable and Page Program submitted together, and the status register is then polled until the page is done
+void CP2130Flash::program(uint32_t address, const uint8_t *data, size_t length, int &errcnt, std::string &errstr)
+{
+    if (!inRange(address, length)) {
+        ++errcnt;
+        errstr += "In program(): address range exceeds the capacity of the flash.\n";  // Program logic error
+    } else {
+        int preverrcnt = errcnt;
+        device_.selectCS(channel_, errcnt, errstr);
+        size_t offset = 0;
+        while (offset < length && errcnt == preverrcnt) {
+            uint32_t pageAddress = static_cast<uint32_t>(address + offset);
+            size_t chunk = std::min<size_t>(length - offset, geometry_.pageSize - pageAddress % geometry_.pageSize);  // Page Program wraps around within the page, so writes never cross a page boundary
+            writeEnabled(geometry_.addressBytes == 4 ? PP4 : PP, true, pageAddress, data + offset, chunk, errcnt, errstr);
+            if (errcnt == preverrcnt) {
+                waitReady(programTime_, PROGRAM_TIMEOUT, errcnt, errstr);
+            }
+            offset += chunk;
+        }
+    }
+}
+
+// Programs the given vector starting at the given address
+void CP2130Flash::program(uint32_t address, const std::vector<uint8_t> &data, int &errcnt, std::string &errstr)
+{
+    program(address, data.data(), data.size(), errcnt, errstr);
+}
+
+// Reads the given number of bytes starting at the given address into the given buffer, returning the number of bytes actually read
+// A single Fast Read instruction is followed by Read commands of up to 16MiB each, which are pipelined by CP2130::spiRead(), so that a whole flash is read at the full bulk rate
+size_t CP2130Flash::read(uint32_t address, uint8_t *data, size_t length, int &errcnt, std::string &errstr)
+{
+    size_t bytesRead = 0;
+    if (!inRange(address, length)) {
+        ++errcnt;
+        errstr += "In read(): address range exceeds the capacity of the flash.\n";  // Program logic error
+    } else if (length > 0) {
+        int preverrcnt = errcnt;
+        device_.selectCS(channel_, errcnt, errstr);
+        device_.configureGPIO(channel_, CP2130::PCOUTPP, false, errcnt, errstr);  // The chip select is asserted by driving its pin low, so that it stays asserted across commands
+        if (errcnt == preverrcnt) {
+            unsigned char commandBuffer[CP2130::CMD_HEADER_SIZE + 6];
+            uint8_t *instruction = commandBuffer + CP2130::CMD_HEADER_SIZE;
+            instruction[0] = geometry_.addressBytes == 4 ? FASTREAD4 : FASTREAD;
+            size_t instructionLength = 1 + fillAddress(instruction + 1, address);
+            instruction[instructionLength++] = 0x00;  // Dummy byte
+            device_.spiWrite(commandBuffer, static_cast<uint32_t>(instructionLength), errcnt, errstr);
+            while (bytesRead < length && errcnt == preverrcnt) {
+                uint32_t chunk = static_cast<uint32_t>(std::min(length - bytesRead, READ_CHUNK));
+                size_t chunkRead = device_.spiRead(data + bytesRead, chunk, errcnt, errstr);
+                bytesRead += chunkRead;
+                if (chunkRead != chunk) {
+                    break;
+                }
+            }
+        }
+        device_.configureGPIO(channel_, CP2130::PCCS, true, errcnt, errstr);  // The chip select is deasserted, and its pin is given back to the SPI engine, even if the read failed
+    }
+    return bytesRead;
+}
+
+// Reads the given number of bytes starting at the given address, and then returns a vector
+std::vector<uint8_t> CP2130Flash::read(uint32_t address, size_t length, int &errcnt, std::string &errstr)
+{
+    std::vector<uint8_t> retdata(length);
+    retdata.resize(read(address, retdata.data(), length, errcnt, errstr));
+    return retdata;
+}
+
+// Returns the JEDEC ID of the flash (see Geometry::jedecID)
+uint32_t CP2130Flash::readJEDECID(int &errcnt, std::string &errstr)
+{
+    uint8_t dataOut[4] = {RDID, 0x00, 0x00, 0x00}, dataIn[4] = {0x00, 0x00, 0x00, 0x00};
+    device_.selectCS(channel_, errcnt, errstr);
+    device_.spiWriteRead(dataOut, dataIn, sizeof(dataOut), errcnt, errstr);
+    return static_cast<uint32_t>(dataIn[1] << 16 | dataIn[2] << 8 | dataIn[3]);
+}
+
+// Reads the given number of bytes from the SFDP tables of the flash, starting at the given address
+// Each WriteRead command carries its own instruction, so the returned vector is only shorter than requested if a command failed
+std::vector<uint8_t> CP2130Flash::readSFDP(uint32_t address, size_t length, int &errcnt, std::string &errstr)
+{
+    std::vector<uint8_t> retdata;
+    int preverrcnt = errcnt;
+    device_.selectCS(channel_, errcnt, errstr);
+    size_t sfdpChunk = device_.writeReadChunk() - SFDP_OVERHEAD;  // Maximum number of SFDP bytes read per WriteRead command
+    std::vector<uint8_t> dataOut(device_.writeReadChunk()), dataIn(device_.writeReadChunk());
+    while (retdata.size() < length && errcnt == preverrcnt) {
+        size_t chunk = std::min(length - retdata.size(), sfdpChunk);
+        uint32_t chunkAddress = static_cast<uint32_t>(address + retdata.size());
+        dataOut[0] = RDSFDP;
+        dataOut[1] = static_cast<uint8_t>(chunkAddress >> 16);  // SFDP addresses are always 3 bytes long (big-endian)
+        dataOut[2] = static_cast<uint8_t>(chunkAddress >> 8);
+        dataOut[3] = static_cast<uint8_t>(chunkAddress);
+        dataOut[4] = 0x00;                                      // Dummy byte
+        if (device_.spiWriteRead(dataOut.data(), dataIn.data(), SFDP_OVERHEAD + chunk, errcnt, errstr) != SFDP_OVERHEAD + chunk) {
+            break;
+        }
+        retdata.insert(retdata.end(), dataIn.begin() + SFDP_OVERHEAD, dataIn.begin() + static_cast<std::ptrdiff_t>(SFDP_OVERHEAD + chunk));
+    }
+    return retdata;
+}
+
+// Returns the value of the status register of the flash
+uint8_t CP2130Flash::readStatus(int &errcnt, std::string &errstr)
+{
+    device_.selectCS(channel_, errcnt, errstr);
+    return statusRegister(errcnt, errstr);
+}
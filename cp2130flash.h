@@ -0,0 +1,104 @@
+/* CP2130Flash class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130FLASH_H
+#define CP2130FLASH_H
+
+// Includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Driver for 25-series SPI NOR flash devices attached to a given SPI channel of a CP2130, whose chip select must be wired to the flash
+// Since the CP2130 deasserts the chip select at the end of every command, reads drive the chip select pin as a GPIO output, so that a single instruction can be followed by a Read command of any length
+// Every other instruction fits in a single command, and uses the chip select as configured (the pin is given back to the SPI engine after each read)
+class CP2130Flash
+{
+public:
+    struct Geometry {
+        uint32_t jedecID;           // Manufacturer ID (bits 23:16), memory type (bits 15:8) and capacity (bits 7:0), as returned by the Read JEDEC ID instruction
+        bool sfdp;                  // True if the geometry was read from the SFDP basic flash parameter table, or false if it was deduced from the JEDEC ID
+        uint64_t size;              // Capacity in bytes (zero if unknown, in which case addresses are not checked)
+        uint32_t pageSize;          // Page size in bytes
+        uint32_t sectorSize;        // Size in bytes of the smallest erasable sector
+        uint8_t sectorEraseOpcode;  // Instruction that erases a sector
+        uint8_t addressBytes;       // Number of address bytes (four if the capacity exceeds 16MiB, or three otherwise)
+    };
+
+    // Instructions common to 25-series SPI NOR flash devices
+    static const uint8_t WREN = 0x06;       // Write Enable
+    static const uint8_t RDSR = 0x05;       // Read Status Register
+    static const uint8_t RDID = 0x9f;       // Read JEDEC ID
+    static const uint8_t RDSFDP = 0x5a;     // Read SFDP
+    static const uint8_t FASTREAD = 0x0b;   // Fast Read
+    static const uint8_t FASTREAD4 = 0x0c;  // Fast Read with 4-byte address
+    static const uint8_t PP = 0x02;         // Page Program
+    static const uint8_t PP4 = 0x12;        // Page Program with 4-byte address
+    static const uint8_t SE = 0x20;         // Sector Erase (4KiB)
+    static const uint8_t SE4 = 0x21;        // Sector Erase (4KiB) with 4-byte address
+    static const uint8_t CE = 0xc7;         // Chip Erase
+
+    static const uint8_t SRWIP = 0x01;  // Write in progress bit of the status register
+    static const uint8_t SRWEL = 0x02;  // Write enable latch bit of the status register
+
+private:
+    CP2130 &device_;
+    uint8_t channel_;
+    Geometry geometry_;
+    libusb_transfer *transfers_[2];
+    std::vector<unsigned char> buffer_;
+    int remaining_, completed_;
+    bool failed_;
+    std::chrono::microseconds programTime_, sectorEraseTime_, chipEraseTime_;  // Typical times learned from previous operations, which schedule the first status poll of the next ones
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    size_t fillAddress(unsigned char *buffer, uint32_t address) const;
+    bool inRange(uint32_t address, size_t length) const;
+    uint8_t statusRegister(int &errcnt, std::string &errstr);
+    bool waitReady(std::chrono::microseconds &typical, unsigned int timeout, int &errcnt, std::string &errstr);
+    void writeEnabled(uint8_t opcode, bool addressed, uint32_t address, const uint8_t *data, size_t length, int &errcnt, std::string &errstr);
+
+public:
+    CP2130Flash(CP2130 &device, uint8_t channel);
+    ~CP2130Flash();
+
+    CP2130Flash(const CP2130Flash &) = delete;
+    CP2130Flash &operator =(const CP2130Flash &) = delete;
+
+    uint8_t channel() const;
+    const Geometry &geometry() const;
+
+    void eraseChip(int &errcnt, std::string &errstr);
+    void eraseSector(uint32_t address, int &errcnt, std::string &errstr);
+    Geometry probe(int &errcnt, std::string &errstr);
+    void program(uint32_t address, const uint8_t *data, size_t length, int &errcnt, std::string &errstr);
+    void program(uint32_t address, const std::vector<uint8_t> &data, int &errcnt, std::string &errstr);
+    size_t read(uint32_t address, uint8_t *data, size_t length, int &errcnt, std::string &errstr);
+    std::vector<uint8_t> read(uint32_t address, size_t length, int &errcnt, std::string &errstr);
+    uint32_t readJEDECID(int &errcnt, std::string &errstr);
+    std::vector<uint8_t> readSFDP(uint32_t address, size_t length, int &errcnt, std::string &errstr);
+    uint8_t readStatus(int &errcnt, std::string &errstr);
+};
+
+#endif  // CP2130FLASH_H
@@ -0,0 +1,379 @@
+/* CP2130Group class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "cp2130deviceindex.h"
+#include "cp2130group.h"
+
+// Private callback function for the transfers issued by the group, which is called from within run()
+// Each completed transfer frees its slot, so that the next segment of the same device can be submitted right away
+void LIBUSB_CALL CP2130Group::callback(libusb_transfer *transfer)
+{
+    Slot *slot = static_cast<Slot *>(transfer->user_data);
+    CP2130Group *group = slot->group;
+    Lane &lane = *slot->lane;
+    Segment &segment = lane.segments[slot->segment];
+    segment.transferred = transfer->actual_length;
+    if (!lane.stopped) {  // Only the first failure of each device is reported, as CP2130::spiRead() and the like do
+        if (transfer->status == LIBUSB_TRANSFER_CANCELLED && group->stalled_) {
+            transfer->status = LIBUSB_TRANSFER_TIMED_OUT;  // Transfers cancelled because the group stalled are reported as timeouts
+        }
+        lane.device->checkTransfer(transfer, lane.result.errcnt, lane.result.errstr);
+        if (transfer->status != LIBUSB_TRANSFER_COMPLETED || segment.transferred != segment.length) {
+            lane.stopped = true;
+        }
+    }
+    slot->inflight = false;
+    lane.freeSlots.push_back(static_cast<size_t>(slot - lane.slots.data()));
+    --lane.inflight;
+    --group->inflight_;
+    ++group->completions_;
+    group->submitNext(lane);
+}
+
+// Private procedure that readies the given lane for a new operation, keeping up to "depth" transfers in flight
+// The segments must be set beforehand, and transfers are allocated once and reused by subsequent operations
+void CP2130Group::prepare(Lane &lane, size_t depth)
+{
+    depth = std::max<size_t>(1, std::min(depth, lane.segments.size()));
+    while (lane.slots.size() < depth) {
+        libusb_transfer *transfer = libusb_alloc_transfer(0);
+        if (transfer == nullptr) {  // If allocation fails, the lane is simply shallower
+            break;
+        }
+        Slot slot = {this, &lane, 0, transfer, false};
+        lane.slots.push_back(slot);
+    }
+    depth = std::min(depth, lane.slots.size());
+    lane.depth = depth;
+    lane.freeSlots.clear();
+    for (size_t i = depth; i > 0; --i) {
+        lane.freeSlots.push_back(i - 1);
+    }
+    lane.next = 0;
+    lane.inflight = 0;
+    lane.stopped = false;
+    lane.cancelled = false;
+    if (depth == 0) {
+        ++lane.result.errcnt;
+        lane.result.errstr += "In CP2130Group: could not allocate transfers.\n";
+        lane.stopped = true;
+    }
+}
+
+// Private function that returns the results of the last operation, in the same order as the devices
+std::vector<CP2130Group::Result> CP2130Group::results() const
+{
+    std::vector<Result> retresults;
+    retresults.reserve(lanes_.size());
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        retresults.push_back(lanes_[i].result);
+    }
+    return retresults;
+}
+
+// Private procedure that submits the prepared segments of every device, and handles the events of the shared context until all of them complete
+// If a device fails, the transfers it still has in flight are cancelled, and if the whole group stalls for "CP2130::TR_TIMEOUT", every transfer still in flight is cancelled
+void CP2130Group::run()
+{
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        lanes_[i].device->lockEvents();  // The callbacks change the state of the lanes, so they must not be called by a background thread of any device meanwhile
+    }
+    stalled_ = false;
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        submitNext(lanes_[i]);
+    }
+    std::chrono::steady_clock::time_point lastProgress = std::chrono::steady_clock::now();
+    while (inflight_ > 0) {
+        std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastProgress);
+        long long remaining = static_cast<long long>(CP2130::TR_TIMEOUT) - elapsed.count();
+        if (remaining <= 0) {
+            stalled_ = true;
+        }
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            Lane &lane = lanes_[i];
+            if ((lane.stopped || stalled_) && !lane.cancelled && lane.inflight > 0) {
+                lane.cancelled = true;
+                for (size_t j = 0; j < lane.slots.size(); ++j) {
+                    if (lane.slots[j].inflight) {
+                        lane.device->cancelTransfer(lane.slots[j].transfer);
+                    }
+                }
+            }
+        }
+        uint64_t completions = completions_;
+        int errcnt = 0;
+        std::string errstr;
+        lanes_[0].device->handleEvents(stalled_ ? CP2130::EVENT_INTERVAL : static_cast<unsigned int>(remaining), nullptr, errcnt, errstr);  // Every device uses the shared context, so this handles the events of all of them (if events cannot be handled, the group eventually stalls)
+        if (completions_ != completions) {
+            lastProgress = std::chrono::steady_clock::now();
+        }
+    }
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        lanes_[i].device->unlockEvents();
+    }
+}
+
+// Private procedure that submits the next segments of the given lane, up to the lane depth
+void CP2130Group::submitNext(Lane &lane)
+{
+    size_t oldest = lane.next;  // Oldest segment in flight
+    for (size_t i = 0; i < lane.slots.size(); ++i) {
+        if (lane.slots[i].inflight && lane.slots[i].segment < oldest) {
+            oldest = lane.slots[i].segment;
+        }
+    }
+    while (!lane.stopped && !stalled_ && lane.next < lane.segments.size() && lane.next < oldest + lane.depth && !lane.freeSlots.empty()) {  // As in CP2130::runPipeline(), no segment is submitted more than "depth" segments ahead of the oldest one in flight
+        size_t index = lane.freeSlots.back();
+        lane.freeSlots.pop_back();
+        Slot &slot = lane.slots[index];
+        Segment &segment = lane.segments[lane.next];
+        segment.transferred = 0;
+        slot.segment = lane.next;
+        libusb_fill_bulk_transfer(slot.transfer, nullptr, segment.endpointAddr, segment.buffer, segment.length, callback, &slot, 0);  // No timeout is set here, since stalls are handled by run()
+        int preverrcnt = lane.result.errcnt;
+        lane.device->submitTransfer(slot.transfer, lane.result.errcnt, lane.result.errstr);
+        if (lane.result.errcnt != preverrcnt) {  // The failure is already reported by submitTransfer()
+            lane.freeSlots.push_back(index);
+            lane.stopped = true;
+        } else {
+            slot.inflight = true;
+            ++lane.inflight;
+            ++inflight_;
+            ++lane.next;
+        }
+    }
+}
+
+CP2130Group::CP2130Group() :
+    context_(nullptr),
+    inflight_(0),
+    completions_(0),
+    stalled_(false)
+{
+}
+
+CP2130Group::~CP2130Group()
+{
+    close();  // As with CP2130, the destructor closes every device of the group
+}
+
+// Checks if the group is open
+bool CP2130Group::isOpen() const
+{
+    return context_ != nullptr;
+}
+
+// Returns the number of devices in the group
+size_t CP2130Group::size() const
+{
+    return lanes_.size();
+}
+
+// Closes every device of the group, and then deinitializes the shared context
+void CP2130Group::close()
+{
+    if (isOpen()) {
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            for (size_t j = 0; j < lanes_[i].slots.size(); ++j) {
+                libusb_free_transfer(lanes_[i].slots[j].transfer);
+            }
+        }
+        lanes_.clear();  // Each device is closed when destroyed
+        libusb_exit(context_);  // Deinitialize libusb
+        context_ = nullptr;
+    }
+}
+
+// Returns the device at the given index, which must be lower than size(), so that it can be configured or used individually
+// The order of the devices is the same as the order of the serial numbers passed to open()
+CP2130 &CP2130Group::device(size_t index)
+{
+    return *lanes_[index].device;
+}
+
+// Opens the devices having the given VID and PID and, respectively, the given serial numbers, under a single libusb context
+// Either all devices are opened, or none is, and the value returned is the one returned by CP2130::open() for the first device that failed to open (or "CP2130::SUCCESS")
+int CP2130Group::open(uint16_t vid, uint16_t pid, const std::vector<std::string> &serials)
+{
+    int retval;
+    libusb_context *context;
+    if (isOpen()) {  // As with CP2130, opening an already open group is harmless
+        retval = CP2130::SUCCESS;
+    } else if (libusb_init(&context) != 0) {  // Initialize libusb. In case of failure
+        retval = CP2130::ERROR_INIT;
+    } else {  // If libusb is initialized
+        retval = CP2130::SUCCESS;
+        {  // The index holds references to the devices listed, so it is destroyed before libusb can be deinitialized below
+            CP2130DeviceIndex index(context, vid, pid);
+            int errcnt = 0;
+            std::string errstr;
+            index.refresh(errcnt, errstr);  // The bus is walked only once, so that each device costs a single open
+            lanes_.resize(serials.size());
+            for (size_t i = 0; i < serials.size() && retval == CP2130::SUCCESS; ++i) {
+                lanes_[i].device.reset(new CP2130);
+                retval = lanes_[i].device->open(index, serials[i]);
+            }
+        }
+        if (retval != CP2130::SUCCESS) {
+            lanes_.clear();  // Close the devices that were opened
+            libusb_exit(context);  // Deinitialize libusb
+        } else {
+            context_ = context;
+        }
+    }
+    return retval;
+}
+
+// Requests and reads the given number of bytes from the SPI bus of every device, into the respective vector, and returns the results of every device
+// Each vector is resized to the number of bytes actually read
+std::vector<CP2130Group::Result> CP2130Group::spiRead(uint32_t bytesToRead, std::vector<std::vector<uint8_t>> &data)
+{
+    data.resize(lanes_.size());
+    size_t nchunks = (static_cast<size_t>(bytesToRead) + CP2130::READ_CHUNK - 1) / CP2130::READ_CHUNK;
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        Lane &lane = lanes_[i];
+        lane.result = Result();
+        uint8_t endpointInAddr = lane.device->getEndpointInAddr(lane.result.errcnt, lane.result.errstr);
+        uint8_t endpointOutAddr = lane.device->getEndpointOutAddr(lane.result.errcnt, lane.result.errstr);
+        lane.commandBuffer.resize(CP2130::CMD_HEADER_SIZE);
+        CP2130::fillCommandHeader(lane.commandBuffer.data(), CP2130::READ, bytesToRead);
+        data[i].resize(static_cast<size_t>(bytesToRead));
+        lane.segments.resize(nchunks + 1);
+        lane.segments[0] = {endpointOutAddr, lane.commandBuffer.data(), static_cast<int>(CP2130::CMD_HEADER_SIZE), 0};
+        for (size_t j = 0; j < nchunks; ++j) {
+            size_t offset = j * CP2130::READ_CHUNK;
+            lane.segments[j + 1] = {endpointInAddr, data[i].data() + offset, static_cast<int>(bytesToRead - offset < CP2130::READ_CHUNK ? bytesToRead - offset : CP2130::READ_CHUNK), 0};
+        }
+        prepare(lane, lane.device->readDepth());  // Same depth as CP2130::spiRead()
+    }
+    run();
+    for (size_t i = 0; i < lanes_.size(); ++i) {  // Only the data received before the first short or failed transfer is counted
+        Lane &lane = lanes_[i];
+        for (size_t j = 1; j < lane.segments.size(); ++j) {
+            lane.result.transferred += static_cast<size_t>(lane.segments[j].transferred);
+            if (lane.segments[j].transferred != lane.segments[j].length) {
+                break;
+            }
+        }
+        data[i].resize(lane.result.transferred);
+    }
+    return results();
+}
+
+// Writes the given vector to the SPI bus of every device, and returns the results of every device
+std::vector<CP2130Group::Result> CP2130Group::spiWrite(const std::vector<uint8_t> &data)
+{
+    return spiWrite(std::vector<std::vector<uint8_t>>(lanes_.size(), data));
+}
+
+// Writes each of the given vectors to the SPI bus of the respective device, and returns the results of every device
+// The number of vectors must match the number of devices
+std::vector<CP2130Group::Result> CP2130Group::spiWrite(const std::vector<std::vector<uint8_t>> &data)
+{
+    if (data.size() != lanes_.size()) {
+        std::vector<Result> retresults(lanes_.size());
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            ++retresults[i].errcnt;
+            retresults[i].errstr += "In spiWrite(): the number of vectors does not match the number of devices.\n";  // Program logic error
+        }
+        return retresults;
+    }
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        Lane &lane = lanes_[i];
+        lane.result = Result();
+        uint8_t endpointOutAddr = lane.device->getEndpointOutAddr(lane.result.errcnt, lane.result.errstr);
+        uint32_t bytesToWrite = static_cast<uint32_t>(data[i].size());
+        lane.commandBuffer.resize(bytesToWrite + CP2130::CMD_HEADER_SIZE);
+        CP2130::fillCommandHeader(lane.commandBuffer.data(), CP2130::WRITE, bytesToWrite);
+        std::copy(data[i].begin(), data[i].end(), lane.commandBuffer.begin() + CP2130::CMD_HEADER_SIZE);
+        lane.segments.resize(1);
+        lane.segments[0] = {endpointOutAddr, lane.commandBuffer.data(), static_cast<int>(lane.commandBuffer.size()), 0};
+        prepare(lane, 1);
+    }
+    run();
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        Lane &lane = lanes_[i];
+        if (lane.segments[0].transferred > static_cast<int>(CP2130::CMD_HEADER_SIZE)) {
+            lane.result.transferred = static_cast<size_t>(lane.segments[0].transferred) - CP2130::CMD_HEADER_SIZE;
+        }
+    }
+    return results();
+}
+
+// Writes the given vector to the SPI bus of every device while reading back into the respective vector, and returns the results of every device
+// Each vector is resized to the number of bytes actually read
+std::vector<CP2130Group::Result> CP2130Group::spiWriteRead(const std::vector<uint8_t> &dataOut, std::vector<std::vector<uint8_t>> &dataIn)
+{
+    return spiWriteRead(std::vector<std::vector<uint8_t>>(lanes_.size(), dataOut), dataIn);
+}
+
+// Writes each of the given vectors to the SPI bus of the respective device while reading back into the respective vector, and returns the results of every device
+// The number of vectors to write must match the number of devices, and each vector read is resized to the number of bytes actually read
+std::vector<CP2130Group::Result> CP2130Group::spiWriteRead(const std::vector<std::vector<uint8_t>> &dataOut, std::vector<std::vector<uint8_t>> &dataIn)
+{
+    if (dataOut.size() != lanes_.size()) {
+        std::vector<Result> retresults(lanes_.size());
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            ++retresults[i].errcnt;
+            retresults[i].errstr += "In spiWriteRead(): the number of vectors does not match the number of devices.\n";  // Program logic error
+        }
+        return retresults;
+    }
+    dataIn.resize(lanes_.size());
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        Lane &lane = lanes_[i];
+        lane.result = Result();
+        uint8_t endpointInAddr = lane.device->getEndpointInAddr(lane.result.errcnt, lane.result.errstr);
+        uint8_t endpointOutAddr = lane.device->getEndpointOutAddr(lane.result.errcnt, lane.result.errstr);
+        size_t bytesToWriteRead = dataOut[i].size();
+        size_t chunkSize = lane.device->writeReadChunk();  // Same chunk size as CP2130::spiWriteRead(), which may differ between devices
+        size_t nchunks = (bytesToWriteRead + chunkSize - 1) / chunkSize;
+        size_t frameSize = chunkSize + CP2130::CMD_HEADER_SIZE;
+        lane.commandBuffer.resize(nchunks * frameSize);
+        dataIn[i].resize(bytesToWriteRead);
+        lane.segments.resize(2 * nchunks);
+        for (size_t j = 0; j < nchunks; ++j) {
+            size_t bytesProcessed = j * chunkSize;
+            uint32_t payload = static_cast<uint32_t>(std::min(chunkSize, bytesToWriteRead - bytesProcessed));
+            unsigned char *frame = lane.commandBuffer.data() + j * frameSize;
+            CP2130::fillCommandHeader(frame, CP2130::WRITEREAD, payload);
+            std::memcpy(frame + CP2130::CMD_HEADER_SIZE, dataOut[i].data() + bytesProcessed, payload);
+            lane.segments[2 * j] = {endpointOutAddr, frame, static_cast<int>(payload + CP2130::CMD_HEADER_SIZE), 0};
+            lane.segments[2 * j + 1] = {endpointInAddr, dataIn[i].data() + bytesProcessed, static_cast<int>(payload), 0};
+        }
+        prepare(lane, lane.device->writeReadDepth());  // Same depth as CP2130::spiWriteRead()
+    }
+    run();
+    for (size_t i = 0; i < lanes_.size(); ++i) {  // As with CP2130::spiWriteRead(), the data of any chunks that follow an error is discarded
+        Lane &lane = lanes_[i];
+        for (size_t j = 0; j + 1 < lane.segments.size(); j += 2) {
+            lane.result.transferred += static_cast<size_t>(lane.segments[j + 1].transferred);
+            if (lane.segments[j].transferred != lane.segments[j].length || lane.segments[j + 1].transferred != lane.segments[j + 1].length) {
+                break;
+            }
+        }
+        dataIn[i].resize(lane.result.transferred);
+    }
+    return results();
+}
@@ -0,0 +1,107 @@
+/* CP2130Group class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130GROUP_H
+#define CP2130GROUP_H
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Group of CP2130 devices that share a single libusb context, whose events are handled by the thread running a group operation, while it runs
+// SPI transfers are issued to every device of the group at once, so that an operation takes as long as the slowest device, instead of the sum of all devices
+// The group functions are not meant to be called concurrently, but the devices can still be used individually via device(), as long as that does not overlap a group operation
+// Since no thread handles the events of the context between operations, each device then handles its own events, as it would outside a group
+class CP2130Group
+{
+public:
+    struct Result {
+        int errcnt;          // Number of errors that occurred on the device
+        std::string errstr;  // Error messages of the device
+        size_t transferred;  // Number of payload bytes transferred before the first error or short transfer
+    };
+
+private:
+    struct Segment {
+        uint8_t endpointAddr;   // Endpoint address
+        unsigned char *buffer;  // Data buffer
+        int length;             // Number of bytes to transfer
+        int transferred;        // Number of bytes actually transferred
+    };
+
+    struct Lane;
+
+    struct Slot {
+        CP2130Group *group;         // Group to which the transfer belongs
+        Lane *lane;                 // Lane (i.e., device) to which the transfer belongs
+        size_t segment;             // Index of the segment being transferred
+        libusb_transfer *transfer;  // Transfer, reused between operations
+        bool inflight;              // True while the transfer is in flight
+    };
+
+    struct Lane {
+        std::unique_ptr<CP2130> device;
+        std::vector<Segment> segments;
+        std::vector<unsigned char> commandBuffer;  // Command headers and, in the case of writes, their payloads
+        std::vector<Slot> slots;
+        std::vector<size_t> freeSlots;             // Indexes of the slots that are not in flight
+        size_t depth;                              // Number of transfers kept in flight, and how far ahead of the oldest one in flight a segment can be submitted
+        size_t next;                               // Index of the next segment to be submitted
+        size_t inflight;                           // Number of transfers in flight
+        bool stopped;                              // True if any transfer has failed or was short, after which no more segments are submitted
+        bool cancelled;                            // True once the transfers still in flight have been cancelled
+        Result result;
+    };
+
+    libusb_context *context_;
+    std::vector<Lane> lanes_;
+    size_t inflight_;
+    uint64_t completions_;
+    bool stalled_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    void prepare(Lane &lane, size_t depth);
+    std::vector<Result> results() const;
+    void run();
+    void submitNext(Lane &lane);
+
+public:
+    CP2130Group();
+    ~CP2130Group();
+
+    bool isOpen() const;
+    size_t size() const;
+
+    void close();
+    CP2130 &device(size_t index);
+    int open(uint16_t vid, uint16_t pid, const std::vector<std::string> &serials);
+    std::vector<Result> spiRead(uint32_t bytesToRead, std::vector<std::vector<uint8_t>> &data);
+    std::vector<Result> spiWrite(const std::vector<uint8_t> &data);
+    std::vector<Result> spiWrite(const std::vector<std::vector<uint8_t>> &data);
+    std::vector<Result> spiWriteRead(const std::vector<uint8_t> &dataOut, std::vector<std::vector<uint8_t>> &dataIn);
+    std::vector<Result> spiWriteRead(const std::vector<std::vector<uint8_t>> &dataOut, std::vector<std::vector<uint8_t>> &dataIn);
+};
+
+#endif  // CP2130GROUP_H
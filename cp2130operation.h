@@ -0,0 +1,77 @@
+/* CP2130Operation class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130OPERATION_H
+#define CP2130OPERATION_H
+
+// Includes
+#include <exception>
+#include <future>
+#include <string>
+#include <utility>
+#include "cp2130.h"
+
+// Outcome of an operation that completes apart from the calling thread, as delivered by CP2130Async, CP2130Queue and CP2130Scheduler
+template <typename T>
+struct CP2130Reply {
+    T value;             // Value returned by the operation
+    int errcnt;          // Number of errors that occurred during the operation
+    std::string errstr;  // Error messages of the operation
+};
+
+// Operation given as a callable object taking a "CP2130 &", an "int &errcnt" and a "std::string &errstr", and returning a value (void is not supported), which is run later by a worker thread and replies via a future
+// An exception thrown by the callable object is delivered via the future as well, so that it reaches the caller instead of ending the worker thread
+template <typename F>
+class CP2130Operation
+{
+public:
+    typedef decltype(std::declval<F &>()(std::declval<CP2130 &>(), std::declval<int &>(), std::declval<std::string &>())) Result;
+
+private:
+    F function_;
+    std::promise<CP2130Reply<Result>> promise_;
+
+public:
+    explicit CP2130Operation(F &&function) :
+        function_(std::move(function))
+    {
+    }
+
+    std::future<CP2130Reply<Result>> future()
+    {
+        return promise_.get_future();
+    }
+
+    // Runs the callable object and sets the reply, unless "errcnt" is not zero, in which case the reply only carries the given errors (e.g., the ones that occurred while preparing the device)
+    void run(CP2130 &device, int errcnt, const std::string &errstr)
+    {
+        try {
+            CP2130Reply<Result> reply = {Result(), errcnt, errstr};
+            if (errcnt == 0) {
+                reply.value = function_(device, reply.errcnt, reply.errstr);
+            }
+            promise_.set_value(std::move(reply));
+        } catch (...) {
+            promise_.set_exception(std::current_exception());
+        }
+    }
+};
+
+#endif  // CP2130OPERATION_H
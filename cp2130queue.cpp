@@ -0,0 +1,202 @@
+/* CP2130Queue class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include "cp2130queue.h"
+
+CP2130Queue::Node::Node() :
+    next(nullptr)
+{
+}
+
+CP2130Queue::Job::~Job()
+{
+}
+
+// Private procedure that appends the given node to the queue, and which is safe to call from any number of threads at the same time
+// The node becomes visible to the worker once the previous node is linked to it, which happens right after the exchange
+void CP2130Queue::link(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+// Private function that removes the oldest job from the queue, and which must only be called by the worker
+// Returns a null pointer if the queue is empty, or if the oldest job is still being linked by a producer
+CP2130Queue::Job *CP2130Queue::pop()
+{
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {  // The placeholder is skipped
+        if (next == nullptr) {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next == nullptr) {  // The tail is the last node, so it can only be removed after the placeholder is put behind it
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        link(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return nullptr;
+        }
+    }
+    tail_ = next;
+    return static_cast<Job *>(tail);
+}
+
+// Private procedure that submits the given job, and wakes up the worker if it is sleeping
+// Since the job is counted before being linked, the worker either sees it pending, or is seen waiting and gets notified
+void CP2130Queue::push(Job *job)
+{
+    pending_.fetch_add(1);
+    link(job);
+    if (waiting_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeup_.notify_one();
+    }
+}
+
+// Private procedure that runs the jobs in the order they were submitted, and which runs in its own thread
+void CP2130Queue::work()
+{
+    while (true) {
+        Job *job = pop();
+        if (job != nullptr) {
+            pending_.fetch_sub(1);
+            job->run(device_);
+            delete job;
+        } else if (pending_.load() != 0) {  // A producer is halfway through linking a job
+            std::this_thread::yield();
+        } else if (stopping_.load()) {
+            break;
+        } else {
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiting_.store(true);
+            wakeup_.wait(lock, [this] { return pending_.load() != 0 || stopping_.load(); });
+            waiting_.store(false);
+        }
+    }
+}
+
+// Creates a queue for the given device, which must be open and must outlive the queue
+CP2130Queue::CP2130Queue(CP2130 &device) :
+    device_(device),
+    head_(&stub_),
+    tail_(&stub_),
+    stub_(),
+    pending_(0),
+    stopping_(false),
+    waiting_(false)
+{
+    worker_ = std::thread(&CP2130Queue::work, this);
+}
+
+CP2130Queue::~CP2130Queue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_.store(true);
+        wakeup_.notify_one();
+    }
+    worker_.join();  // Pending jobs are run first
+}
+
+// Returns the number of operations that were submitted but have not started yet
+size_t CP2130Queue::pending() const
+{
+    return pending_.load();
+}
+
+// Queues a control transfer to the device, in which the given data is sent
+std::future<CP2130Queue::Reply<bool>> CP2130Queue::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &dataOut)
+{
+    std::vector<uint8_t> data = dataOut;
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) mutable {
+        device.controlTransfer(bmRequestType, bRequest, wValue, wIndex, data.data(), static_cast<uint16_t>(data.size()), errcnt, errstr);
+        return errcnt == 0;
+    });
+}
+
+// Queues a control transfer to the device, in which up to the given number of bytes is received
+std::future<CP2130Queue::Reply<std::vector<uint8_t>>> CP2130Queue::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        std::vector<uint8_t> data(wLength);
+        device.controlTransfer(bmRequestType, bRequest, wValue, wIndex, data.data(), wLength, errcnt, errstr);
+        return data;
+    });
+}
+
+// Queues a read of all GPIO pins (see CP2130::getGPIOs())
+std::future<CP2130Queue::Reply<uint16_t>> CP2130Queue::getGPIOs()
+{
+    return submit([](CP2130 &device, int &errcnt, std::string &errstr) {
+        return device.getGPIOs(errcnt, errstr);
+    });
+}
+
+// Queues the selection of the given chip select channel (see CP2130::selectCS())
+std::future<CP2130Queue::Reply<bool>> CP2130Queue::selectCS(uint8_t channel)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        device.selectCS(channel, errcnt, errstr);
+        return errcnt == 0;
+    });
+}
+
+// Queues the setting of the GPIO pins selected by the given mask (see CP2130::setGPIOs())
+std::future<CP2130Queue::Reply<bool>> CP2130Queue::setGPIOs(uint16_t bmValues, uint16_t bmMask)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        device.setGPIOs(bmValues, bmMask, errcnt, errstr);
+        return errcnt == 0;
+    });
+}
+
+// Queues an SPI read (see CP2130::spiRead())
+std::future<CP2130Queue::Reply<std::vector<uint8_t>>> CP2130Queue::spiRead(uint32_t bytesToRead)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        return device.spiRead(bytesToRead, errcnt, errstr);
+    });
+}
+
+// Queues an SPI write (see CP2130::spiWrite())
+std::future<CP2130Queue::Reply<bool>> CP2130Queue::spiWrite(const std::vector<uint8_t> &data)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        device.spiWrite(data, errcnt, errstr);
+        return errcnt == 0;
+    });
+}
+
+// Queues an SPI write and read (see CP2130::spiWriteRead()), whose OUT and IN transfers are never interleaved with other operations
+std::future<CP2130Queue::Reply<std::vector<uint8_t>>> CP2130Queue::spiWriteRead(const std::vector<uint8_t> &data)
+{
+    return submit([=](CP2130 &device, int &errcnt, std::string &errstr) {
+        return device.spiWriteRead(data, errcnt, errstr);
+    });
+}
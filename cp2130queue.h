@@ -0,0 +1,120 @@
+/* CP2130Queue class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130QUEUE_H
+#define CP2130QUEUE_H
+
+// Includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cp2130.h"
+#include "cp2130operation.h"
+
+// Thread-safe front end to a CP2130, which lets any number of threads share the same device
+// Operations are pushed into a lock-free multiple-producer, single-consumer queue, and executed in order by a worker thread that is the only one to use the device
+// Each operation (e.g., a control request, or a whole spiWriteRead() call) runs to completion before the next one starts, so that the traffic of different threads is never interleaved
+// While the queue exists, the device must not be used directly, and operations that are still pending when the queue is destroyed are run before the destructor returns
+class CP2130Queue
+{
+public:
+    template <typename T>
+    using Reply = CP2130Reply<T>;
+
+private:
+    struct Node {
+        std::atomic<Node *> next;
+
+        Node();
+    };
+
+    struct Job : Node {
+        virtual ~Job();
+
+        virtual void run(CP2130 &device) = 0;
+    };
+
+    template <typename F>
+    struct Operation : Job {
+        CP2130Operation<F> operation;
+
+        explicit Operation(F &&f) :
+            operation(std::move(f))
+        {
+        }
+
+        void run(CP2130 &device)
+        {
+            operation.run(device, 0, std::string());
+        }
+    };
+
+    CP2130 &device_;
+    std::atomic<Node *> head_;     // Most recently pushed node (producers)
+    Node *tail_;                   // Oldest node (consumer)
+    Node stub_;                    // Placeholder node, so that the queue always has at least one node
+    std::atomic<size_t> pending_;  // Number of jobs submitted but not yet popped
+    std::atomic<bool> stopping_, waiting_;
+    std::mutex mutex_;             // Only used to put the worker to sleep, and never held while a job is pushed
+    std::condition_variable wakeup_;
+    std::thread worker_;
+
+    void link(Node *node);
+    Job *pop();
+    void push(Job *job);
+    void work();
+
+public:
+    explicit CP2130Queue(CP2130 &device);
+    ~CP2130Queue();
+
+    CP2130Queue(const CP2130Queue &) = delete;
+    CP2130Queue &operator =(const CP2130Queue &) = delete;
+
+    size_t pending() const;
+
+    std::future<Reply<bool>> controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, const std::vector<uint8_t> &dataOut);
+    std::future<Reply<std::vector<uint8_t>>> controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength);
+    std::future<Reply<uint16_t>> getGPIOs();
+    std::future<Reply<bool>> selectCS(uint8_t channel);
+    std::future<Reply<bool>> setGPIOs(uint16_t bmValues, uint16_t bmMask);
+    std::future<Reply<std::vector<uint8_t>>> spiRead(uint32_t bytesToRead);
+    std::future<Reply<bool>> spiWrite(const std::vector<uint8_t> &data);
+    std::future<Reply<std::vector<uint8_t>>> spiWriteRead(const std::vector<uint8_t> &data);
+
+    // Submits any operation, given as a callable object taking a "CP2130 &", an "int &errcnt" and a "std::string &errstr", and returning a value (see CP2130Operation)
+    template <typename F>
+    std::future<Reply<typename CP2130Operation<F>::Result>> submit(F function)
+    {
+        Operation<F> *operation = new Operation<F>(std::move(function));
+        std::future<Reply<typename CP2130Operation<F>::Result>> future = operation->operation.future();
+        push(operation);
+        return future;
+    }
+};
+
+#endif  // CP2130QUEUE_H
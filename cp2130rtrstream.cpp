@@ -0,0 +1,291 @@
+/* CP2130RTRStream class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "cp2130errorlog.h"
+#include "cp2130rtrstream.h"
+
+// Definitions
+const uint32_t RTR_CMD_LENGTH = 0xffffffc0;  // Length requested by each ReadWithRTR command when streaming continuously (the largest multiple of 64 that fits in 32 bits)
+
+// Private callback that is called by libusb when the ReadWithRTR command is sent
+void LIBUSB_CALL CP2130RTRStream::commandCallback(libusb_transfer *transfer)
+{
+    CP2130RTRStream *stream = static_cast<CP2130RTRStream *>(transfer->user_data);
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED && transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+        stream->fail(transfer->endpoint, CP2130::transferResult(transfer->status));  // Without a command, no data will ever arrive
+    }
+    --stream->inflight_;
+}
+
+// Private callback that is called by libusb whenever a bulk IN transfer completes
+void LIBUSB_CALL CP2130RTRStream::transferCallback(libusb_transfer *transfer)
+{
+    CP2130RTRStream *stream = static_cast<CP2130RTRStream *>(transfer->user_data);
+    if (transfer->actual_length > 0) {  // Data is delivered even if the transfer was cancelled, so that nothing received is lost
+        stream->deliver(transfer->buffer, static_cast<size_t>(transfer->actual_length));
+    }
+    if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
+        stream->stopping_ = true;
+    } else if (transfer->status != LIBUSB_TRANSFER_COMPLETED) {
+        stream->fail(transfer->endpoint, CP2130::transferResult(transfer->status));
+    }
+    if (stream->bytesToRead_ == 0 && !stream->stopping_ && stream->received_ >= stream->requested_) {  // When streaming continuously, a new command is issued as soon as the previous one is fulfilled
+        stream->submitCommand(RTR_CMD_LENGTH);
+    }
+    if (!stream->stopping_ && (stream->bytesToRead_ == 0 || stream->submitted_ < stream->bytesToRead_)) {
+        stream->submitTransfer(transfer);  // Resubmit the same transfer, so that the queue stays full
+    }
+    --stream->inflight_;
+}
+
+CP2130RTRStream::CP2130RTRStream(CP2130 &device, size_t blockSize, size_t depth, size_t capacity) :
+    device_(device),
+    blockSize_(std::max<size_t>(64, blockSize / 64 * 64)),  // The block size is rounded down to a multiple of 64, so that only the last packet of a command can be short
+    depth_(std::max<size_t>(1, depth)),
+    ring_(std::max<size_t>(1, capacity)),
+    head_(0),
+    tail_(0),
+    commandTransfer_(nullptr),
+    bytesToRead_(0),
+    requested_(0),
+    submitted_(0),
+    received_(0),
+    overruns_(0),
+    inflight_(0),
+    running_(false),
+    stopping_(false),
+    errcnt_(0)
+{
+}
+
+CP2130RTRStream::~CP2130RTRStream()
+{
+    int errcnt = 0;
+    std::string errstr;
+    stop(errcnt, errstr);  // The stream must be stopped before its transfers are freed
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+        libusb_free_transfer(transfers_[i]);
+    }
+    libusb_free_transfer(commandTransfer_);  // Passing a null pointer is harmless
+}
+
+// Returns the number of bytes that are waiting in the ring buffer
+size_t CP2130RTRStream::available() const
+{
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+}
+
+// Returns the number of bytes received since the stream was started, including the ones lost to overruns
+uint64_t CP2130RTRStream::bytesReceived() const
+{
+    return received_;
+}
+
+// Returns the capacity of the ring buffer, in bytes
+size_t CP2130RTRStream::capacity() const
+{
+    return ring_.size();
+}
+
+// Returns true if the stream is running
+bool CP2130RTRStream::isRunning() const
+{
+    return running_;
+}
+
+// Returns the number of blocks that were dropped because the ring buffer was full
+uint64_t CP2130RTRStream::overruns() const
+{
+    return overruns_;
+}
+
+// Private procedure used to hand a block of data to the callback, or to push it into the ring buffer
+// The ring buffer has a single producer (the event handling thread) and a single consumer (the caller of read()), so it needs no locks
+void CP2130RTRStream::deliver(const uint8_t *data, size_t length)
+{
+    received_ += length;
+    if (callback_) {
+        callback_(data, length);
+    } else {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t size = ring_.size();
+        if (size - (head - tail) < length) {  // Not enough room for the whole block
+            ++overruns_;
+        } else {
+            size_t index = head % size;
+            size_t first = std::min(length, size - index);  // Bytes that fit before wrapping around
+            std::memcpy(ring_.data() + index, data, first);
+            std::memcpy(ring_.data(), data + first, length - first);
+            head_.store(head + length, std::memory_order_release);
+        }
+    }
+}
+
+// Private procedure that stops the stream because of a failed transfer, which is reported later by stop()
+// The failure is formatted as CP2130::checkTransfer() would, but the device is left untouched, since this runs in the event handling thread
+void CP2130RTRStream::fail(uint8_t endpointAddr, int result)
+{
+    stopping_ = true;
+    ++errcnt_;
+    if (device_.errstrEnabled()) {
+        CP2130ErrorLog::Record record = {
+            endpointAddr < 0x80 ? CP2130ErrorLog::BULK_OUT : CP2130ErrorLog::BULK_IN,
+            result,
+            endpointAddr,
+            0x00, 0x00,  // Not applicable to bulk transfers
+            std::chrono::system_clock::now()
+        };
+        errstr_ += CP2130ErrorLog::format(record);
+    }
+}
+
+// Pops up to the given number of bytes from the ring buffer, returning the number of bytes actually read
+// This function does not block, and it is not used when a callback is set
+size_t CP2130RTRStream::read(uint8_t *data, size_t length)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t size = ring_.size();
+    length = std::min(length, head - tail);
+    size_t index = tail % size;
+    size_t first = std::min(length, size - index);
+    std::memcpy(data, ring_.data() + index, first);
+    std::memcpy(data + first, ring_.data(), length - first);
+    tail_.store(tail + length, std::memory_order_release);
+    return length;
+}
+
+// Private procedure that runs in the event handling thread, until every transfer is completed
+void CP2130RTRStream::run()
+{
+    while (inflight_ > 0) {
+        if (stopping_) {  // Cancelling is repeated until every transfer completes, in case a callback resubmitted one just before it noticed the request to stop
+            for (size_t i = 0; i < transfers_.size(); ++i) {
+                device_.cancelTransfer(transfers_[i]);  // Transfers that are no longer in flight are ignored
+            }
+            device_.cancelTransfer(commandTransfer_);
+        }
+        device_.handleBackgroundEvents(CP2130::EVENT_INTERVAL, nullptr, errcnt_, errstr_);
+    }
+    running_ = false;
+}
+
+// Sets a callback that receives every block of data as soon as it arrives, bypassing the ring buffer
+// The callback is called from the event handling thread, and it should not be changed while the stream is running
+void CP2130RTRStream::setCallback(const Callback &callback)
+{
+    callback_ = callback;
+}
+
+// Starts streaming, by issuing a ReadWithRTR command and keeping bulk IN transfers queued
+// If "bytesToRead" is zero, the stream continues until stop() is called, otherwise it ends once the given number of bytes is received
+void CP2130RTRStream::start(uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr)
+{
+    if (running_ || thread_.joinable()) {
+        ++errcnt;
+        errstr += "In start(): stream is already running.\n";  // Program logic error
+    } else if (!device_.isOpen()) {
+        ++errcnt;
+        errstr += "In start(): device is not open.\n";  // Program logic error
+    } else {
+        while (transfers_.size() < depth_) {  // Transfers and their buffers are allocated once, and reused if the stream is restarted
+            libusb_transfer *transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr) {
+                break;
+            }
+            transfers_.push_back(transfer);
+        }
+        if (commandTransfer_ == nullptr) {
+            commandTransfer_ = libusb_alloc_transfer(0);
+        }
+        if (transfers_.empty() || commandTransfer_ == nullptr) {
+            ++errcnt;
+            errstr += "In start(): could not allocate transfers.\n";
+        } else {
+            buffers_.resize(transfers_.size() * blockSize_);
+            head_ = 0;
+            tail_ = 0;
+            bytesToRead_ = bytesToRead;
+            requested_ = 0;
+            submitted_ = 0;
+            received_ = 0;
+            overruns_ = 0;
+            stopping_ = false;
+            running_ = true;
+            for (size_t i = 0; i < transfers_.size(); ++i) {  // Bulk IN transfers are queued before the command is issued, so that the first packet finds them waiting
+                libusb_fill_bulk_transfer(transfers_[i], nullptr, endpointInAddr, buffers_.data() + i * blockSize_, static_cast<int>(blockSize_), transferCallback, this, 0);  // No timeout, since the data arrives at the pace of the RTR signal
+                if (bytesToRead_ == 0 || submitted_ < bytesToRead_) {
+                    submitTransfer(transfers_[i]);
+                }
+            }
+            libusb_fill_bulk_transfer(commandTransfer_, nullptr, endpointOutAddr, commandBuffer_, static_cast<int>(sizeof(commandBuffer_)), commandCallback, this, CP2130::TR_TIMEOUT);
+            submitCommand(bytesToRead_ == 0 ? RTR_CMD_LENGTH : bytesToRead_);
+            thread_ = std::thread(&CP2130RTRStream::run, this);
+        }
+    }
+}
+
+// Stops streaming, by aborting the ReadWithRTR command using CP2130::stopRTR() and cancelling the remaining transfers
+// Any errors that occurred while streaming are also reported here
+void CP2130RTRStream::stop(int &errcnt, std::string &errstr)
+{
+    if (thread_.joinable()) {
+        if (running_) {
+            stopping_ = true;
+            device_.stopRTR(errcnt, errstr);
+        }
+        thread_.join();
+    }
+    errcnt += errcnt_;
+    errstr += errstr_;
+    errcnt_ = 0;
+    errstr_.clear();
+}
+
+// Private procedure used to issue a ReadWithRTR command
+void CP2130RTRStream::submitCommand(uint32_t length)
+{
+    CP2130::fillCommandHeader(commandBuffer_, CP2130::READWITHRTR, length);
+    int result = device_.submitBackgroundTransfer(commandTransfer_);
+    if (result == 0) {
+        requested_ += length;
+        ++inflight_;
+    } else {
+        fail(commandTransfer_->endpoint, result);
+    }
+}
+
+// Private procedure used to (re)submit a bulk IN transfer, limiting its length to what is still expected
+void CP2130RTRStream::submitTransfer(libusb_transfer *transfer)
+{
+    transfer->length = static_cast<int>(bytesToRead_ == 0 ? blockSize_ : std::min<uint64_t>(blockSize_, bytesToRead_ - submitted_));
+    int result = device_.submitBackgroundTransfer(transfer);
+    if (result == 0) {
+        submitted_ += static_cast<uint64_t>(transfer->length);
+        ++inflight_;
+    } else {
+        fail(transfer->endpoint, result);
+    }
+}
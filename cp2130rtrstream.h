@@ -0,0 +1,90 @@
+/* CP2130RTRStream class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130RTRSTREAM_H
+#define CP2130RTRSTREAM_H
+
+// Includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cp2130.h"
+
+// Streams data read via ReadWithRTR commands, keeping a number of bulk IN transfers queued so that the data arrives at the pace of the RTR signal
+// Data is handed to a callback or pushed into a ring buffer by a thread of its own, which never changes the state of the device, since transfers are submitted via CP2130::submitBackgroundTransfer()
+// Failures are collected by the stream instead, and reported by stop()
+class CP2130RTRStream
+{
+public:
+    typedef std::function<void(const uint8_t *data, size_t length)> Callback;  // Called from the event handling thread whenever a block of data arrives
+
+private:
+    CP2130 &device_;
+    size_t blockSize_, depth_;
+    std::vector<uint8_t> ring_;
+    std::atomic<size_t> head_, tail_;
+    std::vector<libusb_transfer *> transfers_;
+    std::vector<unsigned char> buffers_;
+    libusb_transfer *commandTransfer_;
+    unsigned char commandBuffer_[CP2130::CMD_HEADER_SIZE];
+    Callback callback_;
+    uint32_t bytesToRead_;
+    uint64_t requested_, submitted_;
+    std::atomic<uint64_t> received_, overruns_;
+    std::atomic<size_t> inflight_;
+    std::atomic<bool> running_, stopping_;
+    std::thread thread_;
+    int errcnt_;                  // Failures that stopped the stream, reported by stop()
+    std::string errstr_;
+
+    static void LIBUSB_CALL commandCallback(libusb_transfer *transfer);
+    static void LIBUSB_CALL transferCallback(libusb_transfer *transfer);
+
+    void deliver(const uint8_t *data, size_t length);
+    void fail(uint8_t endpointAddr, int result);
+    void run();
+    void submitCommand(uint32_t length);
+    void submitTransfer(libusb_transfer *transfer);
+
+public:
+    static const size_t BLOCK_SIZE_DEFAULT = 4096;                // Default size of each bulk IN transfer (must be a multiple of 64)
+    static const size_t DEPTH_DEFAULT = 4;                        // Default number of bulk IN transfers kept in flight
+    static const size_t CAPACITY_DEFAULT = 64 * BLOCK_SIZE_DEFAULT;  // Default ring buffer capacity, in bytes
+
+    CP2130RTRStream(CP2130 &device, size_t blockSize = BLOCK_SIZE_DEFAULT, size_t depth = DEPTH_DEFAULT, size_t capacity = CAPACITY_DEFAULT);
+    ~CP2130RTRStream();
+
+    size_t available() const;
+    uint64_t bytesReceived() const;
+    size_t capacity() const;
+    bool isRunning() const;
+    uint64_t overruns() const;
+
+    size_t read(uint8_t *data, size_t length);
+    void setCallback(const Callback &callback);
+    void start(uint32_t bytesToRead, uint8_t endpointInAddr, uint8_t endpointOutAddr, int &errcnt, std::string &errstr);
+    void stop(int &errcnt, std::string &errstr);
+};
+
+#endif  // CP2130RTRSTREAM_H
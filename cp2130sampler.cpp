@@ -0,0 +1,293 @@
+/* CP2130Sampler class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include "cp2130sampler.h"
+
+// Private callback function for the requests issued by the sampler, which is called from whichever thread is handling the events of the device
+// Since libusb only lets one thread handle events at a time, samples are always stored by a single thread
+void LIBUSB_CALL CP2130Sampler::callback(libusb_transfer *transfer)
+{
+    Slot *slot = static_cast<Slot *>(transfer->user_data);
+    CP2130Sampler *sampler = slot->sampler;
+    if (transfer->status == LIBUSB_TRANSFER_COMPLETED && transfer->actual_length == CP2130::GET_GPIO_VALUES_WLEN) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const unsigned char *controlBufferIn = transfer->buffer + LIBUSB_CONTROL_SETUP_SIZE;
+        uint16_t values = static_cast<uint16_t>(CP2130::BMGPIOS & (controlBufferIn[0] << 8 | controlBufferIn[1]));  // Big-endian conversion
+        uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - sampler->start_).count());
+        uint64_t index = sampler->count_.load(std::memory_order_relaxed);
+        uint16_t previous = index == 0 ? values : static_cast<uint16_t>(sampler->ring_[(index - 1) % CAPACITY].load(std::memory_order_relaxed));
+        sampler->ring_[index % CAPACITY].store(micros << 16 | values, std::memory_order_relaxed);
+        sampler->count_.store(index + 1);  // Sequentially consistent, so that either this sample is seen by a waiter, or the waiter is seen here
+        if ((index == 0 || values != previous) && sampler->waiters_.load() != 0) {  // Waiters are also woken by the first sample, which is their reference if they started waiting before it
+            std::lock_guard<std::mutex> lock(sampler->mutex_);
+            sampler->change_.notify_all();
+        }
+        if (sampler->running_) {  // The request is issued again right away, so that the number of requests in flight is kept
+            int result = sampler->device_.submitBackgroundTransfer(transfer);  // The device may be in use by another thread, so its state is left untouched
+            if (result != 0) {
+                --sampler->inflight_;
+                sampler->fail(result);
+            }
+        } else {
+            --sampler->inflight_;
+        }
+    } else {
+        --sampler->inflight_;
+        if (transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+            sampler->fail(CP2130::transferResult(transfer->status));  // A short transfer yields zero
+        }
+    }
+}
+
+// Private procedure that handles the events of the device, and runs in its own thread while sampling
+// Once sampling stops, the requests still in flight are cancelled, and their completion is awaited
+void CP2130Sampler::eventLoop()
+{
+    int errcnt = 0;
+    std::string errstr;
+    while (running_ && errcnt == 0) {
+        device_.handleBackgroundEvents(CP2130::EVENT_INTERVAL, nullptr, errcnt, errstr);
+    }
+    if (errcnt != 0) {  // If events could not be handled, sampling stops, and the failure is reported by stop()
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        errcnt_ += errcnt;
+        errstr_ += errstr;
+        change_.notify_all();
+    }
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        device_.cancelTransfer(slots_[i].transfer);  // Transfers that are no longer in flight are ignored
+    }
+    while (inflight_ > 0 && device_.isOpen()) {  // Every callback is awaited, even after a failure, so that no transfer is reused or freed while in flight
+        int evterrcnt = 0;
+        std::string evterrstr;
+        device_.handleBackgroundEvents(CP2130::EVENT_INTERVAL, nullptr, evterrcnt, evterrstr);
+    }
+}
+
+// Private procedure that stops the sampler because of a failed request, which is reported later by stop()
+// The device is not touched here, since this may run in a thread other than the one using it
+void CP2130Sampler::fail(int result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {  // Only the first failure is reported
+        running_ = false;
+        ++errcnt_;
+        if (device_.errstrEnabled()) {
+            CP2130ErrorLog::Record record = {
+                CP2130ErrorLog::CONTROL,
+                result,
+                0x00,  // Not applicable to control transfers
+                CP2130::GET,
+                CP2130::GET_GPIO_VALUES,
+                std::chrono::system_clock::now()
+            };
+            errstr_ += CP2130ErrorLog::format(record);
+        }
+    }
+    change_.notify_all();
+}
+
+// Private function that converts a ring buffer entry into a sample
+CP2130Sampler::Sample CP2130Sampler::sample(uint64_t entry) const
+{
+    Sample retsample;
+    retsample.timestamp = start_ + std::chrono::microseconds(entry >> 16);
+    retsample.values = static_cast<uint16_t>(entry);
+    return retsample;
+}
+
+// Creates a sampler for the given device, which must be open while start() is called
+CP2130Sampler::CP2130Sampler(CP2130 &device) :
+    device_(device),
+    count_(0),
+    inflight_(0),
+    waiters_(0),
+    running_(false),
+    errcnt_(0)
+{
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        ring_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+CP2130Sampler::~CP2130Sampler()
+{
+    running_ = false;
+    if (eventThread_.joinable()) {
+        eventThread_.join();
+    }
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        libusb_free_transfer(slots_[i].transfer);
+    }
+}
+
+// Copies up to the given number of the most recent samples, oldest first, returning the number of samples copied
+// This never blocks the sampler, and samples that are overwritten while being copied are left out
+size_t CP2130Sampler::copy(Sample *samples, size_t maxSamples) const
+{
+    uint64_t count = count_.load();
+    size_t nsamples = static_cast<size_t>(std::min<uint64_t>(std::min<uint64_t>(maxSamples, count), CAPACITY - 1));  // The entry being written next is never read
+    uint64_t first = count - nsamples;
+    for (size_t i = 0; i < nsamples; ++i) {
+        samples[i] = sample(ring_[(first + i) % CAPACITY].load(std::memory_order_relaxed));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t newCount = count_.load(std::memory_order_relaxed);
+    size_t stale = static_cast<size_t>(std::min<uint64_t>(nsamples, newCount + 1 > first + CAPACITY ? newCount + 1 - first - CAPACITY : 0));  // Entries whose index is not above "newCount - CAPACITY" may have been overwritten
+    std::copy(samples + stale, samples + nsamples, samples);
+    return nsamples - stale;
+}
+
+// Returns the total number of samples taken since sampling started
+uint64_t CP2130Sampler::count() const
+{
+    return count_.load();
+}
+
+// Returns true while sampling, or false otherwise (i.e., if the sampler was never started, was stopped, or stopped because a request failed)
+bool CP2130Sampler::isRunning() const
+{
+    return running_;
+}
+
+// Returns the most recent sample, or a sample with zeroed values and timestamp if none was taken yet
+CP2130Sampler::Sample CP2130Sampler::last() const
+{
+    Sample retsample = {std::chrono::steady_clock::time_point(), 0x0000};
+    uint64_t count = count_.load();
+    if (count > 0) {
+        retsample = sample(ring_[(count - 1) % CAPACITY].load(std::memory_order_relaxed));
+    }
+    return retsample;
+}
+
+// Starts sampling, keeping the given number of requests in flight (values are clamped between 1 and "DEPTH_MAX")
+// Samples from any previous run are discarded
+void CP2130Sampler::start(size_t depth, int &errcnt, std::string &errstr)
+{
+    if (running_) {
+        ++errcnt;
+        errstr += "In start(): the sampler is already running.\n";  // Program logic error
+    } else if (!device_.isOpen()) {
+        ++errcnt;
+        errstr += "In start(): device is not open.\n";  // Program logic error
+    } else {
+        if (eventThread_.joinable()) {  // The sampler may have stopped by itself
+            eventThread_.join();
+        }
+        depth = depth < 1 ? 1 : (depth > DEPTH_MAX ? DEPTH_MAX : depth);
+        while (slots_.size() < depth) {  // Transfers are allocated once and reused by subsequent runs
+            libusb_transfer *transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr) {  // If allocation fails, fewer requests are kept in flight
+                break;
+            }
+            Slot slot = {this, transfer, {}};
+            slots_.push_back(slot);
+        }
+        count_ = 0;
+        start_ = std::chrono::steady_clock::now();
+        errcnt_ = 0;
+        errstr_.clear();
+        running_ = true;
+        for (size_t i = 0; i < std::min(depth, slots_.size()); ++i) {
+            Slot &slot = slots_[i];
+            libusb_fill_control_setup(slot.buffer, CP2130::GET, CP2130::GET_GPIO_VALUES, 0x0000, 0x0000, CP2130::GET_GPIO_VALUES_WLEN);
+            libusb_fill_control_transfer(slot.transfer, nullptr, slot.buffer, callback, &slot, CP2130::TR_TIMEOUT);  // The device handle is set by CP2130::submitTransfer()
+            int preverrcnt = errcnt;
+            device_.submitTransfer(slot.transfer, errcnt, errstr);
+            if (errcnt != preverrcnt) {  // The failure is already reported by submitTransfer()
+                break;
+            }
+            ++inflight_;
+        }
+        if (inflight_ == 0) {
+            running_ = false;
+            if (slots_.empty()) {
+                ++errcnt;
+                errstr += "In start(): could not allocate transfers.\n";
+            }
+        } else {
+            eventThread_ = std::thread(&CP2130Sampler::eventLoop, this);
+        }
+    }
+}
+
+// Stops sampling, and reports the failure that stopped the sampler by itself, if that was the case
+// The samples taken are kept until the sampler is started again
+void CP2130Sampler::stop(int &errcnt, std::string &errstr)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        change_.notify_all();
+    }
+    if (eventThread_.joinable()) {
+        eventThread_.join();
+    }
+    errcnt += errcnt_;
+    errstr += errstr_;
+    errcnt_ = 0;
+    errstr_.clear();
+}
+
+// Waits until any of the pins in the given mask makes the given transition, or until the given timeout (in milliseconds) expires
+// Returns true if the transition happened, in which case the sample where it was seen is returned via "sample", if that is not a null pointer
+// Only samples taken after this function is called are considered, and the function returns early if sampling stops
+bool CP2130Sampler::waitForEdge(uint16_t bmMask, Edge edge, unsigned int timeout, Sample *sample)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiters_;
+    uint64_t index = count_.load();
+    bool havePrevious = index > 0;
+    uint16_t previous = havePrevious ? static_cast<uint16_t>(ring_[(index - 1) % CAPACITY].load(std::memory_order_relaxed)) : 0x0000;
+    bool found = false, expired = false;
+    while (true) {
+        uint64_t count = count_.load();
+        if (count - index >= CAPACITY) {  // Samples that were overwritten are skipped, so that only their net change is seen
+            index = count - CAPACITY + 1;
+        }
+        for (; index < count && !found; ++index) {
+            uint64_t entry = ring_[index % CAPACITY].load(std::memory_order_relaxed);
+            uint16_t values = static_cast<uint16_t>(entry);
+            if (havePrevious) {
+                uint16_t changed = static_cast<uint16_t>(bmMask & (values ^ previous));
+                uint16_t edges = edge == RISING ? changed & values : (edge == FALLING ? changed & ~values : changed);
+                if (edges != 0x0000) {
+                    found = true;
+                    if (sample != nullptr) {
+                        *sample = this->sample(entry);
+                    }
+                }
+            }
+            previous = values;
+            havePrevious = true;
+        }
+        if (found || expired || !running_) {
+            break;
+        }
+        expired = change_.wait_until(lock, deadline) == std::cv_status::timeout;  // One last scan is done after the timeout expires
+    }
+    --waiters_;
+    return found;
+}
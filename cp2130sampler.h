@@ -0,0 +1,102 @@
+/* CP2130Sampler class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130SAMPLER_H
+#define CP2130SAMPLER_H
+
+// Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Background sampler of the GPIO pins of a CP2130, which keeps several Get_GPIO_Values requests in flight and stores timestamped samples in a ring buffer
+// Consumers can read the most recent samples at any time without locking, or block on waitForEdge() until a pin changes, instead of polling getGPIOs()
+// The device can still be used while sampling, since its operations take its event lock while their own callbacks are pending (see CP2130::lockEvents()), and the sampler thread stops handling events meanwhile
+// Note that the requests of the sampler are then completed by the thread using the device, so samples keep being taken
+// The sampler never changes the state of the device from its own thread, since requests are issued again using CP2130::submitBackgroundTransfer(), but the device must not be closed while sampling
+class CP2130Sampler
+{
+public:
+    enum Edge {
+        RISING,   // Transition from low to high
+        FALLING,  // Transition from high to low
+        BOTH      // Either transition
+    };
+
+    struct Sample {
+        std::chrono::steady_clock::time_point timestamp;  // Time at which the sample was received
+        uint16_t values;                                  // GPIO values bitmap (see CP2130::getGPIOs())
+    };
+
+    static const size_t CAPACITY = 4096;     // Number of samples kept, after which the oldest ones are overwritten
+    static const size_t DEPTH_DEFAULT = 4;   // Default number of requests kept in flight
+    static const size_t DEPTH_MAX = 16;      // Maximum number of requests kept in flight
+
+private:
+    struct Slot {
+        CP2130Sampler *sampler;     // Sampler to which the transfer belongs
+        libusb_transfer *transfer;  // Transfer, which is resubmitted as soon as it completes
+        unsigned char buffer[LIBUSB_CONTROL_SETUP_SIZE + CP2130::GET_GPIO_VALUES_WLEN];
+    };
+
+    CP2130 &device_;
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> ring_[CAPACITY];  // Each entry holds the time since "start_" in microseconds (upper 48 bits) and the GPIO values bitmap (lower 16 bits)
+    std::atomic<uint64_t> count_;           // Total number of samples taken
+    std::atomic<size_t> inflight_, waiters_;  // Number of transfers in flight, and number of threads in waitForEdge()
+    std::atomic<bool> running_;
+    std::chrono::steady_clock::time_point start_;
+    std::thread eventThread_;
+    std::mutex mutex_;
+    std::condition_variable change_;
+    int errcnt_;                            // Failures that stopped the sampler, reported by stop()
+    std::string errstr_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    void eventLoop();
+    void fail(int result);
+    Sample sample(uint64_t entry) const;
+
+public:
+    explicit CP2130Sampler(CP2130 &device);
+    ~CP2130Sampler();
+
+    CP2130Sampler(const CP2130Sampler &) = delete;
+    CP2130Sampler &operator =(const CP2130Sampler &) = delete;
+
+    size_t copy(Sample *samples, size_t maxSamples) const;
+    uint64_t count() const;
+    bool isRunning() const;
+    Sample last() const;
+
+    void start(size_t depth, int &errcnt, std::string &errstr);
+    void stop(int &errcnt, std::string &errstr);
+    bool waitForEdge(uint16_t bmMask, Edge edge, unsigned int timeout, Sample *sample = nullptr);
+};
+
+#endif  // CP2130SAMPLER_H
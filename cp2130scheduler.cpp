@@ -0,0 +1,232 @@
+/* CP2130Scheduler class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include "cp2130scheduler.h"
+
+CP2130Scheduler::Job::Job(uint8_t channel, int priority) :
+    channel(channel),
+    priority(priority),
+    submitted(Clock::now()),
+    bypassed(0)
+{
+}
+
+CP2130Scheduler::Job::~Job()
+{
+}
+
+// Private function that removes the job that should run next from the list of pending jobs, and returns it
+// The job with the highest priority is chosen, preferring the selected channel and then the oldest job among equals, unless any job reached either limit, in which case the oldest such job is chosen instead
+// Must be called with the mutex locked
+CP2130Scheduler::Job *CP2130Scheduler::pick(Clock::time_point now)
+{
+    size_t index = 0;
+    if (maxBypass_ != 0 && maxDelay_ != 0) {  // Otherwise, jobs simply run in order of arrival
+        for (size_t i = 1; i < jobs_.size(); ++i) {
+            const Job *candidate = jobs_[i], *best = jobs_[index];
+            if (candidate->priority > best->priority || (candidate->priority == best->priority && candidate->channel == selected_ && best->channel != selected_)) {
+                index = i;
+            }
+        }
+        for (size_t i = 0; i < jobs_.size(); ++i) {
+            if (jobs_[i]->bypassed >= maxBypass_ || now - jobs_[i]->submitted >= std::chrono::microseconds(maxDelay_)) {
+                if (i != index) {  // Only counted if the job would not have been chosen anyway
+                    index = i;
+                    ++stats_.overdue;
+                }
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < index; ++i) {  // Every older job was passed over
+        ++jobs_[i]->bypassed;
+    }
+    if (index != 0) {
+        ++stats_.reorders;
+    }
+    Job *job = jobs_[index];
+    jobs_.erase(jobs_.begin() + static_cast<std::ptrdiff_t>(index));
+    return job;
+}
+
+// Private procedure that submits the given job, and wakes up the worker
+void CP2130Scheduler::push(Job *job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(job);
+    wakeup_.notify_one();
+}
+
+// Private procedure that runs the pending jobs in the order chosen by pick(), and which runs in its own thread
+// The channel of each job is configured if a configuration is pending for it, and selected if it is not the one that is already selected
+void CP2130Scheduler::work()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_ || !jobs_.empty()) {
+        if (jobs_.empty()) {
+            wakeup_.wait(lock);
+        } else {
+            Job *job = pick(Clock::now());
+            uint8_t channel = job->channel;
+            bool configure = channel < 11 && configs_[channel].pending;  // Invalid channels are reported by selectCS()
+            ChannelConfig config = configure ? configs_[channel] : ChannelConfig();
+            if (configure) {
+                configs_[channel].pending = false;
+            }
+            lock.unlock();
+            int errcnt = 0;
+            std::string errstr;
+            if (configure) {
+                device_.configureSPIMode(channel, config.mode, errcnt, errstr);
+                device_.configureSPIDelays(channel, config.delays, errcnt, errstr);
+            }
+            bool switched = errcnt == 0 && channel != selected_;
+            if (switched) {
+                device_.selectCS(channel, errcnt, errstr);
+                selected_ = errcnt == 0 ? channel : NO_CHANNEL;  // If selecting the channel failed, it is selected again by the next job
+            }
+            lock.lock();  // The statistics are updated before the reply is set, so that they already account for the job once its future is ready
+            ++stats_.transactions;
+            if (configure) {
+                ++stats_.configurations;
+                if (errcnt != 0 && !configs_[channel].pending) {  // The configuration is retried by the next job on the same channel, unless a newer one was given meanwhile
+                    configs_[channel].pending = true;
+                }
+            }
+            if (switched) {
+                ++stats_.csSwitches;
+            }
+            lock.unlock();
+            job->run(device_, errcnt, errstr);
+            delete job;
+            lock.lock();
+        }
+    }
+}
+
+// Creates a scheduler for the given device, which must be open and must outlive the scheduler
+CP2130Scheduler::CP2130Scheduler(CP2130 &device) :
+    device_(device),
+    configs_(),
+    maxBypass_(MAX_BYPASS_DEFAULT),
+    maxDelay_(MAX_DELAY_DEFAULT),
+    selected_(NO_CHANNEL),
+    stopping_(false),
+    stats_()
+{
+    worker_ = std::thread(&CP2130Scheduler::work, this);
+}
+
+CP2130Scheduler::~CP2130Scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        wakeup_.notify_one();
+    }
+    worker_.join();  // Pending jobs are run first
+}
+
+// Returns the number of times a transaction can be passed over by later ones before it runs ahead of any other
+size_t CP2130Scheduler::maxBypass() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxBypass_;
+}
+
+// Returns the time a transaction can wait before it runs ahead of any other, in microseconds
+unsigned int CP2130Scheduler::maxDelay() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxDelay_;
+}
+
+// Returns the number of transactions that were submitted but have not started yet
+size_t CP2130Scheduler::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+// Returns the scheduling statistics
+CP2130Scheduler::Stats CP2130Scheduler::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Sets the SPI mode and delays of the given channel, which are applied before the next transaction on that channel runs (see CP2130::configureSPIMode() and CP2130::configureSPIDelays())
+// Since the CP2130 keeps them for each channel, they are not applied again when the channel is selected later on, and invalid channels are ignored
+void CP2130Scheduler::configureChannel(uint8_t channel, const CP2130::SPIMode &mode, const CP2130::SPIDelays &delays)
+{
+    if (channel < 11) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        configs_[channel].mode = mode;
+        configs_[channel].delays = delays;
+        configs_[channel].pending = true;
+    }
+}
+
+// Resets the scheduling statistics
+void CP2130Scheduler::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats();
+}
+
+// Sets the number of times a transaction can be passed over by later ones before it runs ahead of any other (zero disables reordering)
+void CP2130Scheduler::setMaxBypass(size_t maxBypass)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxBypass_ = maxBypass;
+}
+
+// Sets the time a transaction can wait before it runs ahead of any other, in microseconds (zero disables reordering)
+void CP2130Scheduler::setMaxDelay(unsigned int maxDelay)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxDelay_ = maxDelay;
+}
+
+// Schedules an SPI read on the given channel (see CP2130::spiRead())
+std::future<CP2130Scheduler::Reply<std::vector<uint8_t>>> CP2130Scheduler::spiRead(uint8_t channel, uint32_t bytesToRead, int priority)
+{
+    return submit(channel, priority, [=](CP2130 &device, int &errcnt, std::string &errstr) {
+        return device.spiRead(bytesToRead, errcnt, errstr);
+    });
+}
+
+// Schedules an SPI write on the given channel (see CP2130::spiWrite())
+std::future<CP2130Scheduler::Reply<bool>> CP2130Scheduler::spiWrite(uint8_t channel, const std::vector<uint8_t> &data, int priority)
+{
+    return submit(channel, priority, [=](CP2130 &device, int &errcnt, std::string &errstr) {
+        device.spiWrite(data, errcnt, errstr);
+        return errcnt == 0;
+    });
+}
+
+// Schedules an SPI write and read on the given channel (see CP2130::spiWriteRead())
+std::future<CP2130Scheduler::Reply<std::vector<uint8_t>>> CP2130Scheduler::spiWriteRead(uint8_t channel, const std::vector<uint8_t> &data, int priority)
+{
+    return submit(channel, priority, [=](CP2130 &device, int &errcnt, std::string &errstr) {
+        return device.spiWriteRead(data, errcnt, errstr);
+    });
+}
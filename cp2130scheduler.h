@@ -0,0 +1,147 @@
+/* CP2130Scheduler class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130SCHEDULER_H
+#define CP2130SCHEDULER_H
+
+// Includes
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cp2130.h"
+#include "cp2130operation.h"
+
+// Scheduler of SPI transactions that lets peripherals on different chip select channels share the same CP2130
+// Each transaction is tagged with a channel and a priority, and a worker thread runs them one at a time, choosing the next one by priority and, among equals, preferring the channel that is already selected, so that selectCS() is only issued when the channel changes
+// Reordering is bounded: a transaction that was passed over "maxBypass" times, or that has waited for "maxDelay" microseconds, runs before any other, and setting either limit to zero restores the order of arrival
+// The SPI mode and delays of each channel are kept by the CP2130 itself, so they are only configured once per channel via configureChannel(), instead of before every transaction
+// Since the worker keeps track of the channel that is selected, the device must not be used directly while the scheduler exists
+class CP2130Scheduler
+{
+public:
+    template <typename T>
+    using Reply = CP2130Reply<T>;  // The errors that occurred while selecting or configuring the channel of a transaction are included in its reply
+
+    struct Stats {
+        uint64_t transactions;    // Number of transactions run
+        uint64_t csSwitches;      // Number of times a different channel was selected
+        uint64_t configurations;  // Number of times a channel was configured
+        uint64_t reorders;        // Number of transactions run ahead of an older pending one
+        uint64_t overdue;         // Number of transactions that were run because they reached "maxBypass" or "maxDelay"
+    };
+
+    static const size_t MAX_BYPASS_DEFAULT = 16;          // Default number of times a transaction can be passed over by later ones
+    static const unsigned int MAX_DELAY_DEFAULT = 10000;  // Default time a transaction can wait before it runs ahead of any other, in microseconds [10ms]
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Job {
+        uint8_t channel;
+        int priority;
+        Clock::time_point submitted;
+        size_t bypassed;  // Number of times the job was passed over by a later one
+
+        Job(uint8_t channel, int priority);
+        virtual ~Job();
+
+        virtual void run(CP2130 &device, int errcnt, const std::string &errstr) = 0;  // Runs the job, unless "errcnt" is not zero, and sets its reply
+    };
+
+    template <typename F>
+    struct Operation : Job {
+        CP2130Operation<F> operation;
+
+        Operation(uint8_t channel, int priority, F &&f) :
+            Job(channel, priority),
+            operation(std::move(f))
+        {
+        }
+
+        void run(CP2130 &device, int errcnt, const std::string &errstr)
+        {
+            operation.run(device, errcnt, errstr);
+        }
+    };
+
+    struct ChannelConfig {
+        CP2130::SPIMode mode;
+        CP2130::SPIDelays delays;
+        bool pending;  // Set when the configuration was given but not yet applied
+    };
+
+    static const uint8_t NO_CHANNEL = 0xff;
+
+    CP2130 &device_;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::vector<Job *> jobs_;  // Pending jobs, in order of arrival
+    ChannelConfig configs_[11];
+    size_t maxBypass_;
+    unsigned int maxDelay_;
+    uint8_t selected_;  // Channel currently selected, only used by the worker
+    bool stopping_;
+    Stats stats_;
+    std::thread worker_;
+
+    Job *pick(Clock::time_point now);
+    void push(Job *job);
+    void work();
+
+public:
+    explicit CP2130Scheduler(CP2130 &device);
+    ~CP2130Scheduler();
+
+    CP2130Scheduler(const CP2130Scheduler &) = delete;
+    CP2130Scheduler &operator =(const CP2130Scheduler &) = delete;
+
+    size_t maxBypass() const;
+    unsigned int maxDelay() const;
+    size_t pending() const;
+    Stats stats() const;
+
+    void configureChannel(uint8_t channel, const CP2130::SPIMode &mode, const CP2130::SPIDelays &delays);
+    void resetStats();
+    void setMaxBypass(size_t maxBypass);
+    void setMaxDelay(unsigned int maxDelay);
+    std::future<Reply<std::vector<uint8_t>>> spiRead(uint8_t channel, uint32_t bytesToRead, int priority = 0);
+    std::future<Reply<bool>> spiWrite(uint8_t channel, const std::vector<uint8_t> &data, int priority = 0);
+    std::future<Reply<std::vector<uint8_t>>> spiWriteRead(uint8_t channel, const std::vector<uint8_t> &data, int priority = 0);
+
+    // Submits any transaction on the given channel, given as a callable object taking a "CP2130 &", an "int &errcnt" and a "std::string &errstr", and returning a value (see CP2130Operation)
+    // The channel is selected and, if needed, configured before the callable object is called, and transactions with a higher priority value run first
+    template <typename F>
+    std::future<Reply<typename CP2130Operation<F>::Result>> submit(uint8_t channel, int priority, F function)
+    {
+        Operation<F> *operation = new Operation<F>(channel, priority, std::move(function));
+        std::future<Reply<typename CP2130Operation<F>::Result>> future = operation->operation.future();
+        push(operation);
+        return future;
+    }
+};
+
+#endif  // CP2130SCHEDULER_H
@@ -0,0 +1,844 @@
+/* CP2130Simulator class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "cp2130simulator.h"
+
+// Definitions
+const size_t GEN_CHUNK = 4096;       // Maximum number of bytes exchanged with the slave at once, during Read and ReadWithRTR commands
+const size_t PACKET_SIZE = 64;       // Maximum packet size of the bulk endpoints
+const uint8_t VERSION_MAJ = 0x01;    // Major read-only version reported by the model
+const uint8_t VERSION_MIN = 0x10;    // Minor read-only version reported by the model
+const uint16_t GPIO_BITMAPS[11] = {  // Bitmap of each GPIO pin, indexed by pin number
+    CP2130::BMGPIO0, CP2130::BMGPIO1, CP2130::BMGPIO2, CP2130::BMGPIO3, CP2130::BMGPIO4, CP2130::BMGPIO5,
+    CP2130::BMGPIO6, CP2130::BMGPIO7, CP2130::BMGPIO8, CP2130::BMGPIO9, CP2130::BMGPIO10
+};
+
+struct OTPField {
+    uint8_t getRequest;  // Request that reads the field (the request that writes it is the next one)
+    size_t index;        // Index of the field in the OTP ROM
+    size_t size;         // Size of the field
+    uint16_t lockMask;   // Lock bit that protects the field
+};
+
+const OTPField OTP_FIELDS[] = {  // Fields that are read and written as a whole, using a single request
+    {CP2130::GET_MANUFACTURING_STRING_1, CP2130::PROMIDX_MANUFACTURING_STRING_1, CP2130::PROMSZE_MANUFACTURING_STRING_1, 0x0020},
+    {CP2130::GET_MANUFACTURING_STRING_2, CP2130::PROMIDX_MANUFACTURING_STRING_2, CP2130::PROMSZE_MANUFACTURING_STRING_2, 0x0040},
+    {CP2130::GET_PRODUCT_STRING_1, CP2130::PROMIDX_PRODUCT_STRING_1, CP2130::PROMSZE_PRODUCT_STRING_1, 0x0100},
+    {CP2130::GET_PRODUCT_STRING_2, CP2130::PROMIDX_PRODUCT_STRING_2, CP2130::PROMSZE_PRODUCT_STRING_2, 0x0200},
+    {CP2130::GET_SERIAL_STRING, CP2130::PROMIDX_SERIAL_STRING, CP2130::PROMSZE_SERIAL_STRING, CP2130::LWSER},
+    {CP2130::GET_PIN_CONFIG, CP2130::PROMIDX_PIN_CONFIG, CP2130::PROMSZE_PIN_CONFIG, CP2130::LWPINCFG}
+};
+
+CP2130Simulator::Slave::~Slave()
+{
+}
+
+// Called when a transfer command starts (by default, does nothing)
+void CP2130Simulator::Slave::begin(uint8_t)
+{
+}
+
+// Called when a transfer command ends (by default, does nothing)
+void CP2130Simulator::Slave::end(uint8_t)
+{
+}
+
+// Returns the state of the RTR signal (by default, the slave is always ready)
+bool CP2130Simulator::Slave::rtr(uint8_t)
+{
+    return true;
+}
+
+CP2130Simulator::CP2130Simulator() :
+    slave_(nullptr),
+    latency_(0),
+    bandwidth_(0),
+    connected_(true),
+    headerLength_(0),
+    command_(0x00),
+    channel_(NO_CHANNEL),
+    outRemaining_(0),
+    commandLength_(0),
+    readLength_(0),
+    readRemaining_(0),
+    rtrActive_(false),
+    scratch_(GEN_CHUNK),
+    inOffset_(0),
+    inPushed_(0),
+    inPopped_(0),
+    busFree_(Clock::now()),
+    busLock_(nullptr)
+{
+    std::memset(prom_, 0xff, sizeof(prom_));  // Unprogrammed bytes read as 0xff
+    const uint8_t usbConfig[] = {
+        0xc4, 0x10,          // VID 0x10c4 (little-endian)
+        0xa0, 0x87,          // PID 0x87a0 (little-endian)
+        0x32,                // Maximum consumption current of 100mA
+        CP2130::PMBUSREGEN,  // Bus-powered, with the voltage regulator enabled
+        0x01, 0x00,          // Release version 1.0
+        CP2130::PRIOREAD     // High priority read
+    };
+    std::memcpy(&prom_[CP2130::PROMIDX_VID], usbConfig, sizeof(usbConfig));
+    writeString(CP2130::PROMIDX_MANUFACTURING_STRING_1, CP2130::PROMSZE_MANUFACTURING_STRING_1 + CP2130::PROMSZE_MANUFACTURING_STRING_2, u"Silicon Laboratories");
+    writeString(CP2130::PROMIDX_PRODUCT_STRING_1, CP2130::PROMSZE_PRODUCT_STRING_1 + CP2130::PROMSZE_PRODUCT_STRING_2, u"CP2130 USB-to-SPI Bridge");
+    writeString(CP2130::PROMIDX_SERIAL_STRING, CP2130::PROMSZE_SERIAL_STRING, u"00000001");
+    const uint8_t pinConfig[CP2130::PROMSZE_PIN_CONFIG] = {
+        CP2130::PCCS, CP2130::PCCS, CP2130::PCCS, CP2130::PCCS, CP2130::PCIN, CP2130::PCCS,  // GPIO.0 to GPIO.5
+        CP2130::PCCS, CP2130::PCCS, CP2130::PCCS, CP2130::PCCS, CP2130::PCCS,                // GPIO.6 to GPIO.10
+        0x7f, 0xff,                                                                          // Suspend pin level bitmap
+        0x00, 0x00,                                                                          // Suspend pin mode bitmap
+        0x00, 0x00,                                                                          // Wakeup pin mask bitmap
+        0x00, 0x00,                                                                          // Wakeup pin match bitmap
+        0x00                                                                                 // Clock divider
+    };
+    std::memcpy(&prom_[CP2130::PROMIDX_PIN_CONFIG], pinConfig, sizeof(pinConfig));
+    resetVolatile();
+}
+
+CP2130Simulator::~CP2130Simulator()
+{
+}
+
+// Returns the bandwidth of the simulated bus, in bytes per second (zero means unlimited)
+unsigned long CP2130Simulator::bandwidth() const
+{
+    return bandwidth_;
+}
+
+// Returns true if the simulated device is connected
+bool CP2130Simulator::isConnected() const
+{
+    return connected_;
+}
+
+// Returns the latency of each simulated transfer, in microseconds
+unsigned int CP2130Simulator::latency() const
+{
+    return latency_;
+}
+
+// Private function that returns the channel whose chip select is enabled (the lowest one, if there are several), or "NO_CHANNEL" if none is
+uint8_t CP2130Simulator::activeChannel() const
+{
+    uint8_t channel = NO_CHANNEL;
+    for (uint8_t i = 0; i < 11; ++i) {
+        if ((0x0001 << i & csEnabled_) != 0x0000) {
+            channel = i;
+            break;
+        }
+    }
+    return channel;
+}
+
+// Private procedure that waits until no other thread is processing bulk or control traffic, and then claims the bus for the calling thread
+// While the bus is claimed, the given lock is unlocked whenever a slave callback is called, so that the slave can call back into the simulated device
+void CP2130Simulator::claimBus(std::unique_lock<std::mutex> &lock)
+{
+    wakeup_.wait(lock, [this] { return busOwner_ == std::thread::id(); });
+    busOwner_ = std::this_thread::get_id();
+    busLock_ = &lock;
+}
+
+// Private function that processes a control request, returning the number of bytes in the data stage, or "LIBUSB_ERROR_PIPE" [-9] if the request is stalled
+// Note that the bus must be claimed beforehand
+int CP2130Simulator::control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength)
+{
+    uint16_t asserted = manualCSAsserted();
+    int result = wLength;
+    uint16_t lockWord = static_cast<uint16_t>(prom_[CP2130::PROMIDX_LOCK_BYTE + 1] << 8 | prom_[CP2130::PROMIDX_LOCK_BYTE]);
+    bool get = bmRequestType == CP2130::GET;
+    if (!get && bmRequestType != CP2130::SET) {
+        result = LIBUSB_ERROR_PIPE;
+    } else if (get != (bRequest % 2 == 0) && bRequest != CP2130::GET_READONLY_VERSION && bRequest != CP2130::RESET_DEVICE) {  // Get requests have even codes, and set requests have odd codes, with two exceptions
+        result = LIBUSB_ERROR_PIPE;
+    } else if (bRequest == CP2130::RESET_DEVICE && !get && wLength == CP2130::RESET_DEVICE_WLEN) {
+        resetVolatile();
+    } else if (bRequest == CP2130::GET_READONLY_VERSION && get && wLength == CP2130::GET_READONLY_VERSION_WLEN) {
+        data[0] = VERSION_MAJ;
+        data[1] = VERSION_MIN;
+    } else if (bRequest == CP2130::GET_GPIO_VALUES && wLength == CP2130::GET_GPIO_VALUES_WLEN) {
+        uint16_t values = 0x0000;
+        for (size_t i = 0; i < 11; ++i) {
+            values = static_cast<uint16_t>(values | (GPIO_BITMAPS[i] & (gpioModes_[i] == CP2130::PCIN ? inputs_ : gpioValues_)));  // Inputs follow setInputs(), while every other pin reads back its own level
+        }
+        data[0] = static_cast<uint8_t>(values >> 8);
+        data[1] = static_cast<uint8_t>(values);
+    } else if (bRequest == CP2130::SET_GPIO_VALUES && wLength == CP2130::SET_GPIO_VALUES_WLEN) {
+        uint16_t values = static_cast<uint16_t>(data[0] << 8 | data[1]);
+        uint16_t mask = static_cast<uint16_t>(CP2130::BMGPIOS & (data[2] << 8 | data[3]));
+        gpioValues_ = static_cast<uint16_t>((gpioValues_ & ~mask) | (values & mask));
+    } else if (bRequest == CP2130::GET_GPIO_MODE_AND_LEVEL && wLength == CP2130::GET_GPIO_MODE_AND_LEVEL_WLEN) {
+        uint16_t outputs = 0x0000;
+        for (size_t i = 0; i < 11; ++i) {
+            if (gpioModes_[i] == CP2130::PCOUTOD || gpioModes_[i] == CP2130::PCOUTPP) {
+                outputs = static_cast<uint16_t>(outputs | GPIO_BITMAPS[i]);
+            }
+        }
+        data[0] = static_cast<uint8_t>(outputs >> 8);  // Output mode bitmap
+        data[1] = static_cast<uint8_t>(outputs);
+        data[2] = static_cast<uint8_t>(gpioValues_ >> 8);  // Level bitmap
+        data[3] = static_cast<uint8_t>(gpioValues_);
+    } else if (bRequest == CP2130::SET_GPIO_MODE_AND_LEVEL && wLength == CP2130::SET_GPIO_MODE_AND_LEVEL_WLEN && data[0] <= 10) {
+        gpioModes_[data[0]] = data[1];
+        gpioValues_ = static_cast<uint16_t>(data[2] == 0x00 ? gpioValues_ & ~GPIO_BITMAPS[data[0]] : gpioValues_ | GPIO_BITMAPS[data[0]]);
+    } else if (bRequest == CP2130::GET_GPIO_CHIP_SELECT && wLength == CP2130::GET_GPIO_CHIP_SELECT_WLEN) {
+        uint16_t pins = 0x0000;
+        for (size_t i = 0; i < 11; ++i) {
+            if ((0x0001 << i & csEnabled_) != 0x0000) {
+                pins = static_cast<uint16_t>(pins | GPIO_BITMAPS[i]);
+            }
+        }
+        data[0] = static_cast<uint8_t>(csEnabled_ >> 8);  // Channel chip select enable bitmap
+        data[1] = static_cast<uint8_t>(csEnabled_);
+        data[2] = static_cast<uint8_t>(pins >> 8);  // Pin chip select enable bitmap
+        data[3] = static_cast<uint8_t>(pins);
+    } else if (bRequest == CP2130::SET_GPIO_CHIP_SELECT && wLength == CP2130::SET_GPIO_CHIP_SELECT_WLEN && data[0] <= 10 && data[1] <= 0x02) {
+        uint16_t bitmap = static_cast<uint16_t>(0x0001 << data[0]);
+        csEnabled_ = static_cast<uint16_t>(data[1] == 0x00 ? csEnabled_ & ~bitmap : (data[1] == 0x01 ? csEnabled_ | bitmap : bitmap));
+    } else if (bRequest == CP2130::GET_SPI_WORD && wLength == CP2130::GET_SPI_WORD_WLEN) {
+        std::memcpy(data, spiWords_, sizeof(spiWords_));
+    } else if (bRequest == CP2130::SET_SPI_WORD && wLength == CP2130::SET_SPI_WORD_WLEN && data[0] <= 10) {
+        spiWords_[data[0]] = data[1];
+    } else if (bRequest == CP2130::GET_SPI_DELAY && wLength == CP2130::GET_SPI_DELAY_WLEN && wIndex <= 10) {
+        data[0] = static_cast<uint8_t>(wIndex);
+        std::memcpy(&data[1], spiDelays_[wIndex], sizeof(spiDelays_[wIndex]));
+    } else if (bRequest == CP2130::SET_SPI_DELAY && wLength == CP2130::SET_SPI_DELAY_WLEN && data[0] <= 10) {
+        std::memcpy(spiDelays_[data[0]], &data[1], sizeof(spiDelays_[data[0]]));
+    } else if (bRequest == CP2130::GET_FULL_THRESHOLD && wLength == CP2130::GET_FULL_THRESHOLD_WLEN) {
+        data[0] = fifoThreshold_;
+    } else if (bRequest == CP2130::SET_FULL_THRESHOLD && wLength == CP2130::SET_FULL_THRESHOLD_WLEN) {
+        fifoThreshold_ = data[0];
+    } else if (bRequest == CP2130::GET_RTR_STATE && wLength == CP2130::GET_RTR_STATE_WLEN) {
+        data[0] = rtrActive_ ? 0x01 : 0x00;
+    } else if (bRequest == CP2130::SET_RTR_STOP && wLength == CP2130::SET_RTR_STOP_WLEN) {
+        if (data[0] == 0x01 && rtrActive_) {  // Aborts the current ReadWithRTR command, discarding the data not yet read from the slave
+            readRemaining_ = 0;
+            finishRead();
+        }
+    } else if (bRequest == CP2130::GET_EVENT_COUNTER && wLength == CP2130::GET_EVENT_COUNTER_WLEN) {
+        data[0] = static_cast<uint8_t>((eventOverflow_ ? 0x80 : 0x00) | eventMode_);
+        data[1] = static_cast<uint8_t>(eventValue_ >> 8);
+        data[2] = static_cast<uint8_t>(eventValue_);
+    } else if (bRequest == CP2130::SET_EVENT_COUNTER && wLength == CP2130::SET_EVENT_COUNTER_WLEN) {
+        eventMode_ = static_cast<uint8_t>(0x07 & data[0]);
+        eventValue_ = static_cast<uint16_t>(data[1] << 8 | data[2]);
+        eventOverflow_ = false;
+    } else if (bRequest == CP2130::GET_CLOCK_DIVIDER && wLength == CP2130::GET_CLOCK_DIVIDER_WLEN) {
+        data[0] = clockDivider_;
+    } else if (bRequest == CP2130::SET_CLOCK_DIVIDER && wLength == CP2130::SET_CLOCK_DIVIDER_WLEN) {
+        clockDivider_ = data[0];
+    } else if (bRequest >= CP2130::GET_USB_CONFIG && !get && wValue != CP2130::PROM_WRITE_KEY) {  // Every OTP ROM write requires the write key
+        result = LIBUSB_ERROR_PIPE;
+    } else if (bRequest == CP2130::GET_USB_CONFIG && wLength == CP2130::GET_USB_CONFIG_WLEN) {
+        std::memcpy(data, &prom_[CP2130::PROMIDX_VID], CP2130::GET_USB_CONFIG_WLEN);  // The layout of the data stage matches the one of the OTP ROM
+    } else if (bRequest == CP2130::SET_USB_CONFIG && wLength == CP2130::SET_USB_CONFIG_WLEN) {
+        const uint8_t masks[CP2130::SET_USB_CONFIG_WLEN - 1] = {  // Lock bit and write mask bit that apply to each byte
+            CP2130::LWVID, CP2130::LWVID, CP2130::LWPID, CP2130::LWPID, CP2130::LWMAXPOW, CP2130::LWPOWMODE, CP2130::LWREL, CP2130::LWREL, CP2130::LWTRFPRIO
+        };
+        if ((data[9] & ~lockWord & CP2130::LWUSBCFG) != 0x0000) {  // Locked fields cannot be written
+            result = LIBUSB_ERROR_PIPE;
+        } else {
+            for (size_t i = 0; i < sizeof(masks); ++i) {
+                if ((masks[i] & data[9]) != 0x00) {
+                    prom_[CP2130::PROMIDX_VID + i] = data[i];
+                }
+            }
+        }
+    } else if (bRequest == CP2130::GET_LOCK_BYTE && wLength == CP2130::GET_LOCK_BYTE_WLEN) {
+        data[0] = prom_[CP2130::PROMIDX_LOCK_BYTE];
+        data[1] = prom_[CP2130::PROMIDX_LOCK_BYTE + 1];
+    } else if (bRequest == CP2130::SET_LOCK_BYTE && wLength == CP2130::SET_LOCK_BYTE_WLEN) {
+        prom_[CP2130::PROMIDX_LOCK_BYTE] &= data[0];  // Lock bits can be cleared, but never set again
+        prom_[CP2130::PROMIDX_LOCK_BYTE + 1] &= data[1];
+    } else if (bRequest == CP2130::GET_PROM_CONFIG && wLength == CP2130::GET_PROM_CONFIG_WLEN && wIndex < CP2130::PROM_BLOCKS) {
+        std::memcpy(data, &prom_[CP2130::PROM_BLOCK_SIZE * wIndex], CP2130::PROM_BLOCK_SIZE);
+    } else if (bRequest == CP2130::SET_PROM_CONFIG && wLength == CP2130::SET_PROM_CONFIG_WLEN && wIndex < CP2130::PROM_BLOCKS && (CP2130::LWALL & lockWord) != 0x0000) {
+        std::memcpy(&prom_[CP2130::PROM_BLOCK_SIZE * wIndex], data, CP2130::PROM_BLOCK_SIZE);
+    } else {
+        result = LIBUSB_ERROR_PIPE;
+        for (size_t i = 0; i < sizeof(OTP_FIELDS) / sizeof(OTP_FIELDS[0]); ++i) {
+            const OTPField &field = OTP_FIELDS[i];
+            size_t tableSize = field.getRequest == CP2130::GET_PIN_CONFIG ? CP2130::GET_PIN_CONFIG_WLEN : CP2130::GET_SERIAL_STRING_WLEN;  // Descriptor tables are padded with zeros
+            if (bRequest == field.getRequest + (get ? 0 : 1) && wLength == tableSize) {
+                if (get) {
+                    std::memset(data, 0x00, tableSize);
+                    std::memcpy(data, &prom_[field.index], field.size);
+                    result = wLength;
+                } else if ((field.lockMask & lockWord) != 0x0000) {
+                    std::memcpy(&prom_[field.index], data, field.size);
+                    result = wLength;
+                }
+                break;
+            }
+        }
+    }
+    uint16_t changed = static_cast<uint16_t>(asserted ^ manualCSAsserted());
+    for (uint8_t i = 0; i < 11; ++i) {  // Chip selects driven as GPIO outputs follow the level of their pins
+        if ((0x0001 << i & changed) != 0x0000) {
+            if ((0x0001 << i & asserted) != 0x0000) {
+                slaveEnd(i);
+            } else {
+                slaveBegin(i);
+            }
+        }
+    }
+    return result;
+}
+
+// Private procedure used to exchange data with the slave during Read and ReadWithRTR commands, until at least "length" bytes are available to bulk IN transfers
+// During ReadWithRTR commands, no data is exchanged while the slave reports that it is not ready
+void CP2130Simulator::fill(size_t length)
+{
+    while (inData_.size() - inOffset_ < length && readRemaining_ > 0 && (!rtrActive_ || slaveRTR(channel_))) {
+        size_t chunk = std::min<size_t>(std::min<size_t>(GEN_CHUNK, readRemaining_), length - (inData_.size() - inOffset_));
+        std::vector<uint8_t> mosi(chunk, 0x00);
+        spiTransfer(mosi.data(), scratch_.data(), chunk);
+        readRemaining_ -= static_cast<uint32_t>(chunk);
+        pushIn(scratch_.data(), chunk, readRemaining_ == 0 && readLength_ % PACKET_SIZE != 0);
+        if (readRemaining_ == 0) {
+            finishRead();
+        }
+    }
+}
+
+// Private procedure used to end a Read or ReadWithRTR command, after which any commands that arrived in the meantime are processed
+void CP2130Simulator::finishRead()
+{
+    if (!manualCS(channel_)) {
+        slaveEnd(channel_);
+    }
+    rtrActive_ = false;
+    std::vector<uint8_t> deferred;
+    deferred.swap(deferred_);
+    processOut(deferred.data(), deferred.size());
+}
+
+// Private function that returns the address of the bulk IN endpoint, which depends on the transfer priority
+uint8_t CP2130Simulator::inAddr() const
+{
+    return prom_[CP2130::PROMIDX_TRANSFER_PRIORITY] == CP2130::PRIOWRITE ? 0x82 : 0x81;
+}
+
+// Private function that returns true if the chip select pin of the given channel is configured as a GPIO output, in which case it follows the level of the pin instead of the transfer commands
+bool CP2130Simulator::manualCS(uint8_t channel) const
+{
+    return channel != NO_CHANNEL && (gpioModes_[channel] == CP2130::PCOUTOD || gpioModes_[channel] == CP2130::PCOUTPP);
+}
+
+// Private function that returns the bitmap of the channels whose chip select pin is configured as a GPIO output and driven low
+uint16_t CP2130Simulator::manualCSAsserted() const
+{
+    uint16_t asserted = 0x0000;
+    for (uint8_t i = 0; i < 11; ++i) {
+        if (manualCS(i) && (GPIO_BITMAPS[i] & gpioValues_) == 0x0000) {
+            asserted = static_cast<uint16_t>(asserted | 0x0001 << i);
+        }
+    }
+    return asserted;
+}
+
+// Private function that completes the transfer that is due at the given time, returning it, or that returns a null pointer and sets "when" to the time of the next completion
+// Transfers of the same kind complete in order, and each one occupies the bus for a time that depends on its length and on the bandwidth
+// Bulk IN transfers that wait for data time out as they would in libusb, unless their timeout is zero
+// Note that the bus must be claimed beforehand
+libusb_transfer *CP2130Simulator::nextTransfer(Clock::time_point now, Clock::time_point &when)
+{
+    libusb_transfer *transfer = nullptr;
+    when = Clock::time_point::max();
+    if (!cancelled_.empty()) {
+        transfer = cancelled_.front();
+        cancelled_.pop_front();
+    } else if (!connected_ && !pending_.empty()) {
+        transfer = pending_.front().transfer;
+        pending_.pop_front();
+        transfer->status = LIBUSB_TRANSFER_NO_DEVICE;
+        transfer->actual_length = 0;
+    } else {
+        for (size_t i = 0; i < pending_.size(); ++i) {  // Data is read from the slave before the pending transfers are examined, since the mutex is unlocked meanwhile
+            libusb_transfer *t = pending_[i].transfer;
+            if (t->type != LIBUSB_TRANSFER_TYPE_CONTROL && (t->endpoint & 0x80) != 0x00) {
+                if (t->endpoint == inAddr()) {
+                    fill(static_cast<size_t>(t->length));
+                }
+                break;
+            }
+        }
+        size_t candidate = pending_.size();
+        bool seenControl = false, seenOut = false, seenIn = false;
+        for (size_t i = 0; i < pending_.size(); ++i) {  // Only the oldest transfer of each kind can complete next
+            libusb_transfer *t = pending_[i].transfer;
+            bool isControl = t->type == LIBUSB_TRANSFER_TYPE_CONTROL;
+            bool isIn = !isControl && (t->endpoint & 0x80) != 0x00;
+            if ((isControl && seenControl) || (!isControl && isIn && seenIn) || (!isControl && !isIn && seenOut)) {
+                continue;
+            }
+            seenControl = seenControl || isControl;
+            seenIn = seenIn || isIn;
+            seenOut = seenOut || (!isControl && !isIn);
+            Clock::time_point due;
+            if (isControl) {
+                due = std::max(pending_[i].submitted + std::chrono::microseconds(latency_), busFree_) + transferTime(static_cast<size_t>(t->length));
+            } else if (t->endpoint != (isIn ? inAddr() : outAddr())) {
+                due = now;  // Transfers to a nonexistent endpoint stall immediately
+            } else if (isIn) {
+                size_t available = inData_.size() - inOffset_;
+                size_t limit = static_cast<size_t>(t->length);
+                if (!boundaries_.empty()) {
+                    limit = std::min<size_t>(limit, static_cast<size_t>(boundaries_.front() - inPopped_));
+                }
+                if (available >= limit) {
+                    due = std::max(pending_[i].submitted + std::chrono::microseconds(latency_), busFree_) + transferTime(limit);
+                } else if (t->timeout != 0) {  // Waits for data until the timeout expires
+                    due = pending_[i].submitted + std::chrono::milliseconds(t->timeout);
+                } else {  // Waits for data indefinitely
+                    continue;
+                }
+            } else {
+                due = std::max(pending_[i].submitted + std::chrono::microseconds(latency_), busFree_) + transferTime(static_cast<size_t>(t->length));
+            }
+            if (due < when) {
+                when = due;
+                candidate = i;
+            }
+        }
+        if (candidate < pending_.size() && when <= now) {
+            transfer = pending_[candidate].transfer;
+            pending_.erase(pending_.begin() + static_cast<std::ptrdiff_t>(candidate));
+            busFree_ = std::max(busFree_, when);
+            when = Clock::time_point::max();
+            if (transfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+                const unsigned char *setup = transfer->buffer;  // Setup packet (fields are little-endian)
+                int result = control(setup[0], setup[1], static_cast<uint16_t>(setup[3] << 8 | setup[2]), static_cast<uint16_t>(setup[5] << 8 | setup[4]), transfer->buffer + LIBUSB_CONTROL_SETUP_SIZE, static_cast<uint16_t>(setup[7] << 8 | setup[6]));
+                transfer->status = result < 0 ? LIBUSB_TRANSFER_STALL : LIBUSB_TRANSFER_COMPLETED;
+                transfer->actual_length = result < 0 ? 0 : result;
+            } else if (transfer->endpoint != ((transfer->endpoint & 0x80) != 0x00 ? inAddr() : outAddr())) {
+                transfer->status = LIBUSB_TRANSFER_STALL;
+                transfer->actual_length = 0;
+            } else if ((transfer->endpoint & 0x80) != 0x00) {
+                transfer->actual_length = static_cast<int>(popIn(transfer->buffer, static_cast<size_t>(transfer->length), false));
+                transfer->status = LIBUSB_TRANSFER_COMPLETED;
+                if (transfer->actual_length == 0 && transfer->length > 0) {  // The transfer timed out, so whatever is there is taken
+                    transfer->actual_length = static_cast<int>(popIn(transfer->buffer, static_cast<size_t>(transfer->length), true));
+                    transfer->status = LIBUSB_TRANSFER_TIMED_OUT;
+                }
+            } else {
+                processOut(transfer->buffer, static_cast<size_t>(transfer->length));
+                transfer->actual_length = transfer->length;
+                transfer->status = LIBUSB_TRANSFER_COMPLETED;
+            }
+        }
+    }
+    return transfer;
+}
+
+// Private function that returns the address of the bulk OUT endpoint, which depends on the transfer priority
+uint8_t CP2130Simulator::outAddr() const
+{
+    return prom_[CP2130::PROMIDX_TRANSFER_PRIORITY] == CP2130::PRIOWRITE ? 0x01 : 0x02;
+}
+
+// Private function that moves up to "length" bytes of available data into the given buffer, stopping early at the end of a short packet, as a bulk IN transfer would
+// If "partial" is false, nothing is moved unless the transfer can be fulfilled
+size_t CP2130Simulator::popIn(unsigned char *data, size_t length, bool partial)
+{
+    fill(length);
+    size_t available = inData_.size() - inOffset_;
+    size_t limit = length;
+    if (!boundaries_.empty()) {
+        limit = std::min<size_t>(limit, static_cast<size_t>(boundaries_.front() - inPopped_));
+    }
+    size_t count = available < limit && !partial ? 0 : std::min(available, limit);
+    std::memcpy(data, inData_.data() + inOffset_, count);
+    inOffset_ += count;
+    inPopped_ += count;
+    while (!boundaries_.empty() && boundaries_.front() <= inPopped_) {
+        boundaries_.pop_front();
+    }
+    if (inOffset_ == inData_.size()) {  // The buffer is reused once empty
+        inData_.clear();
+        inOffset_ = 0;
+    }
+    return count;
+}
+
+// Private procedure that processes the data received by the bulk OUT endpoint, which consists of command headers, each followed by its payload (if any)
+void CP2130Simulator::processOut(const unsigned char *data, size_t length)
+{
+    size_t i = 0;
+    while (i < length) {
+        if (readRemaining_ > 0) {  // Commands that arrive during a Read or ReadWithRTR command are only processed after it ends
+            deferred_.insert(deferred_.end(), data + i, data + length);
+            break;
+        } else if (outRemaining_ == 0) {
+            header_[headerLength_++] = data[i++];
+            if (headerLength_ == CP2130::CMD_HEADER_SIZE) {
+                headerLength_ = 0;
+                startCommand(header_[2], static_cast<uint32_t>(header_[7] << 24 | header_[6] << 16 | header_[5] << 8 | header_[4]));  // Length is little-endian
+            }
+        } else {
+            size_t chunk = std::min<size_t>(length - i, outRemaining_);
+            std::vector<uint8_t> miso(chunk);
+            spiTransfer(data + i, miso.data(), chunk);
+            outRemaining_ -= static_cast<uint32_t>(chunk);
+            i += chunk;
+            if (command_ == CP2130::WRITEREAD) {
+                pushIn(miso.data(), chunk, outRemaining_ == 0 && commandLength_ % PACKET_SIZE != 0);
+            }
+            if (outRemaining_ == 0 && !manualCS(channel_)) {
+                slaveEnd(channel_);
+            }
+        }
+    }
+}
+
+// Private procedure that makes data available to bulk IN transfers
+// If "shortEnd" is true, the data ends with a short packet, which terminates any bulk IN transfer that reaches it
+void CP2130Simulator::pushIn(const uint8_t *data, size_t length, bool shortEnd)
+{
+    inData_.insert(inData_.end(), data, data + length);
+    inPushed_ += length;
+    if (shortEnd) {
+        boundaries_.push_back(inPushed_);
+    }
+}
+
+// Private procedure that releases the bus, waking up any thread that waits for it or for data
+void CP2130Simulator::releaseBus()
+{
+    busOwner_ = std::thread::id();
+    busLock_ = nullptr;
+    wakeup_.notify_all();
+}
+
+// Private procedure that restores the volatile state, as a power-on or a reset would
+void CP2130Simulator::resetVolatile()
+{
+    std::memcpy(gpioModes_, &prom_[CP2130::PROMIDX_PIN_CONFIG], sizeof(gpioModes_));
+    std::memset(spiWords_, 0x00, sizeof(spiWords_));
+    std::memset(spiDelays_, 0x00, sizeof(spiDelays_));
+    gpioValues_ = CP2130::BMGPIOS;
+    inputs_ = CP2130::BMGPIOS;
+    csEnabled_ = 0x0000;
+    fifoThreshold_ = 0x80;
+    clockDivider_ = prom_[CP2130::PROMIDX_PIN_CONFIG + CP2130::PROMSZE_PIN_CONFIG - 1];
+    eventMode_ = static_cast<uint8_t>(0x07 & gpioModes_[4]);
+    eventValue_ = 0x0000;
+    eventOverflow_ = false;
+    headerLength_ = 0;
+    outRemaining_ = 0;
+    readRemaining_ = 0;
+    rtrActive_ = false;
+    inData_.clear();
+    deferred_.clear();
+    inOffset_ = 0;
+    inPopped_ = inPushed_;
+    boundaries_.clear();
+}
+
+// Private procedure that calls the begin() callback of the slave, if any, with the mutex unlocked
+void CP2130Simulator::slaveBegin(uint8_t channel)
+{
+    Slave *slave = slave_;
+    if (slave != nullptr) {
+        busLock_->unlock();
+        slave->begin(channel);
+        busLock_->lock();
+    }
+}
+
+// Private procedure that calls the end() callback of the slave, if any, with the mutex unlocked
+void CP2130Simulator::slaveEnd(uint8_t channel)
+{
+    Slave *slave = slave_;
+    if (slave != nullptr) {
+        busLock_->unlock();
+        slave->end(channel);
+        busLock_->lock();
+    }
+}
+
+// Private function that returns the state of the RTR signal of the slave, calling its rtr() callback with the mutex unlocked, or true if no slave is set
+bool CP2130Simulator::slaveRTR(uint8_t channel)
+{
+    Slave *slave = slave_;
+    bool ready = true;
+    if (slave != nullptr) {
+        busLock_->unlock();
+        ready = slave->rtr(channel);
+        busLock_->lock();
+    }
+    return ready;
+}
+
+// Private procedure used to exchange data with the slave, or to loop it back if no slave is set
+// As with every other slave callback, the mutex is unlocked during the exchange
+void CP2130Simulator::spiTransfer(const uint8_t *mosi, uint8_t *miso, size_t length)
+{
+    Slave *slave = slave_;
+    if (slave == nullptr) {
+        std::memcpy(miso, mosi, length);
+    } else {
+        busLock_->unlock();
+        slave->transfer(channel_, mosi, miso, length);
+        busLock_->lock();
+    }
+}
+
+// Private procedure used to start a transfer command
+void CP2130Simulator::startCommand(uint8_t command, uint32_t length)
+{
+    command_ = command;
+    commandLength_ = length;
+    if (length > 0 && command <= CP2130::READWITHRTR && command != 0x03) {  // Unknown commands are ignored
+        channel_ = activeChannel();
+        if (!manualCS(channel_)) {  // A chip select driven as a GPIO output is left as it is
+            slaveBegin(channel_);
+        }
+        if (command == CP2130::READ || command == CP2130::READWITHRTR) {
+            readLength_ = length;
+            readRemaining_ = length;
+            rtrActive_ = command == CP2130::READWITHRTR;
+        } else {
+            outRemaining_ = length;
+        }
+    }
+}
+
+// Private function that returns the time the bus is occupied by a transfer of the given length
+CP2130Simulator::Clock::duration CP2130Simulator::transferTime(size_t length) const
+{
+    return bandwidth_ == 0 ? Clock::duration::zero() : std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(static_cast<long long>(length * 1000000000.0 / bandwidth_)));
+}
+
+// Private procedure used to write a string descriptor to the OTP ROM, spanning as many contiguous fields as needed
+void CP2130Simulator::writeString(size_t index, size_t size, const std::u16string &descriptor)
+{
+    size_t length = std::min(2 * descriptor.size() + 2, size);
+    prom_[index] = static_cast<uint8_t>(length);  // USB string descriptor length
+    prom_[index + 1] = 0x03;                      // USB string descriptor constant
+    for (size_t i = 2; i < size; ++i) {
+        prom_[index + i] = i < length ? static_cast<uint8_t>(descriptor[(i - 2) / 2] >> (i % 2 == 0 ? 0 : 8)) : 0x00;  // UTF-16LE
+    }
+}
+
+// Equivalent to libusb_bulk_transfer(), but the simulated device is used instead
+// Bulk IN transfers wait for data, for up to the given timeout (zero means unlimited), only if the available data does not suffice
+int CP2130Simulator::bulkTransfer(uint8_t endpointAddr, unsigned char *data, int length, int *transferred, unsigned int timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    int result = 0, count = 0;
+    if (!connected_) {
+        result = LIBUSB_ERROR_NO_DEVICE;
+    } else if (endpointAddr != inAddr() && endpointAddr != outAddr()) {
+        result = LIBUSB_ERROR_PIPE;
+    } else {
+        Clock::time_point due = std::max(Clock::now() + std::chrono::microseconds(latency_), busFree_) + transferTime(static_cast<size_t>(length));
+        busFree_ = due;
+        lock.unlock();
+        std::this_thread::sleep_until(due);
+        lock.lock();
+        claimBus(lock);
+        if ((endpointAddr & 0x80) == 0x00) {
+            processOut(data, static_cast<size_t>(length));
+            count = length;
+        } else {
+            count = static_cast<int>(popIn(data, static_cast<size_t>(length), false));
+            Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+            while (count == 0 && length > 0 && connected_ && (timeout == 0 || Clock::now() < deadline)) {  // Nothing is moved unless the transfer can be fulfilled, so data is waited for, with the bus released meanwhile
+                releaseBus();
+                if (rtrActive_) {  // The RTR signal of the slave is polled, since it may change at any time
+                    wakeup_.wait_for(lock, std::chrono::milliseconds(1));
+                } else if (timeout == 0) {
+                    wakeup_.wait(lock);
+                } else {
+                    wakeup_.wait_until(lock, deadline);
+                }
+                claimBus(lock);
+                count = static_cast<int>(popIn(data, static_cast<size_t>(length), false));
+            }
+            if (count == 0 && length > 0) {  // Whatever is there is taken once the timeout expires
+                count = static_cast<int>(popIn(data, static_cast<size_t>(length), true));
+                result = connected_ ? LIBUSB_ERROR_TIMEOUT : LIBUSB_ERROR_NO_DEVICE;
+            }
+        }
+        releaseBus();  // Asynchronous transfers may be waiting for data
+    }
+    if (transferred != nullptr) {
+        *transferred = count;
+    }
+    return result;
+}
+
+// Equivalent to libusb_cancel_transfer(), for transfers submitted to the simulated device
+int CP2130Simulator::cancelTransfer(libusb_transfer *transfer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int result = LIBUSB_ERROR_NOT_FOUND;
+    for (std::deque<Pending>::iterator it = pending_.begin(); it != pending_.end(); ++it) {
+        if (it->transfer == transfer) {
+            pending_.erase(it);
+            transfer->status = LIBUSB_TRANSFER_CANCELLED;
+            transfer->actual_length = 0;
+            cancelled_.push_back(transfer);  // The callback is called later, by handleEvents()
+            wakeup_.notify_all();
+            result = 0;
+            break;
+        }
+    }
+    return result;
+}
+
+// Reconnects the simulated device, which then behaves as if it was powered on
+void CP2130Simulator::connect()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!connected_) {
+        claimBus(lock);
+        resetVolatile();
+        connected_ = true;
+        releaseBus();
+    }
+}
+
+// Equivalent to libusb_control_transfer(), but the simulated device is used instead
+int CP2130Simulator::controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength, unsigned int)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    int result;
+    if (!connected_) {
+        result = LIBUSB_ERROR_NO_DEVICE;
+    } else {
+        Clock::time_point due = std::max(Clock::now() + std::chrono::microseconds(latency_), busFree_) + transferTime(wLength);
+        busFree_ = due;
+        lock.unlock();
+        std::this_thread::sleep_until(due);
+        lock.lock();
+        claimBus(lock);
+        result = control(bmRequestType, bRequest, wValue, wIndex, data, wLength);
+        releaseBus();
+    }
+    return result;
+}
+
+// Counts the given number of events, as if they were detected on the GPIO.4/EVTCNTR pin
+// The event counter overflows as a real one would, but the pin mode is not taken into account
+void CP2130Simulator::countEvents(uint16_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    eventOverflow_ = eventOverflow_ || eventValue_ + count > 0xffff;
+    eventValue_ = static_cast<uint16_t>(eventValue_ + count);
+}
+
+// Disconnects the simulated device, so that every subsequent transfer fails with "LIBUSB_ERROR_NO_DEVICE" [-4]
+void CP2130Simulator::disconnect()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    connected_ = false;
+    wakeup_.notify_all();
+}
+
+// Equivalent to libusb_handle_events_timeout_completed(), for transfers submitted to the simulated device
+// Callbacks are called from the calling thread, and may submit or cancel transfers
+int CP2130Simulator::handleEvents(timeval *tv, int *completed)
+{
+    std::lock_guard<std::mutex> eventLock(eventMutex_);  // Only one thread handles events at a time, as in libusb
+    Clock::time_point deadline = tv == nullptr ? Clock::now() + std::chrono::seconds(60) : Clock::now() + std::chrono::seconds(tv->tv_sec) + std::chrono::microseconds(tv->tv_usec);
+    bool handled = false;
+    while (completed == nullptr || *completed == 0) {
+        libusb_transfer *transfer;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            Clock::time_point now = Clock::now(), when;
+            claimBus(lock);
+            transfer = nextTransfer(now, when);
+            releaseBus();
+            if (transfer == nullptr) {
+                if (rtrActive_) {  // The RTR signal of the slave is polled, since it may change at any time
+                    when = std::min(when, now + std::chrono::milliseconds(1));
+                }
+                if ((handled && completed == nullptr) || now >= deadline) {
+                    break;
+                }
+                wakeup_.wait_until(lock, std::min(when, deadline));
+                continue;
+            }
+        }
+        transfer->callback(transfer);  // The mutex is not locked here
+        handled = true;
+    }
+    return 0;
+}
+
+// Sets the bandwidth of the simulated bus, in bytes per second (zero means unlimited)
+void CP2130Simulator::setBandwidth(unsigned long bandwidth)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    bandwidth_ = bandwidth;
+}
+
+// Sets the levels seen on the pins configured as inputs, in bitmap format (see the values applicable to getGPIOs()/setGPIOs())
+void CP2130Simulator::setInputs(uint16_t bmInputs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    inputs_ = static_cast<uint16_t>(CP2130::BMGPIOS & bmInputs);
+}
+
+// Sets the latency of each simulated transfer, in microseconds
+// Transfers that are in flight at the same time have overlapping latencies, as they would on a real bus
+void CP2130Simulator::setLatency(unsigned int latency)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_ = latency;
+}
+
+// Sets the slave that is connected to the SPI bus, or restores the default loopback (MISO follows MOSI) if a null pointer is passed
+// Any callback in progress on another thread is waited for, so the previous slave can be destroyed as soon as it is replaced
+// The slave must outlive the simulated device, or at least remain valid until replaced
+void CP2130Simulator::setSlave(Slave *slave)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (busOwner_ != std::this_thread::get_id()) {  // A slave may replace itself from within a callback
+        wakeup_.wait(lock, [this] { return busOwner_ == std::thread::id(); });
+    }
+    slave_ = slave;
+}
+
+// Equivalent to libusb_submit_transfer(), but the transfer is submitted to the simulated device
+int CP2130Simulator::submitTransfer(libusb_transfer *transfer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int result = 0;
+    if (!connected_) {
+        result = LIBUSB_ERROR_NO_DEVICE;
+    } else if (transfer->type != LIBUSB_TRANSFER_TYPE_BULK && transfer->type != LIBUSB_TRANSFER_TYPE_CONTROL) {
+        result = LIBUSB_ERROR_NOT_SUPPORTED;
+    } else {
+        Pending pending;
+        pending.transfer = transfer;
+        pending.submitted = Clock::now();
+        pending_.push_back(pending);
+        wakeup_.notify_all();
+    }
+    return result;
+}
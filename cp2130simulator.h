@@ -0,0 +1,136 @@
+/* CP2130Simulator class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130SIMULATOR_H
+#define CP2130SIMULATOR_H
+
+// Includes
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cp2130.h"
+#include "cp2130transport.h"
+
+// In-process model of a CP2130, to be used with CP2130::open(CP2130Transport &)
+// Both the control request table and the bulk command protocol are implemented, and SPI traffic is handed to a pluggable slave
+// Slave callbacks are called with the simulated device unlocked, so a slave may call setInputs(), countEvents() and the like, but not connect() or any transfer function, since those wait for the callback to return
+class CP2130Simulator : public CP2130Transport
+{
+public:
+    class Slave
+    {
+    public:
+        virtual ~Slave();
+
+        virtual void begin(uint8_t channel);                                                            // Called when a transfer command starts, with the chip select asserted, or when a chip select pin used as a GPIO output is driven low
+        virtual void end(uint8_t channel);                                                              // Called when a transfer command ends, with the chip select deasserted, or when a chip select pin used as a GPIO output is driven high
+        virtual bool rtr(uint8_t channel);                                                              // Returns the state of the RTR signal, which is only sampled during ReadWithRTR commands
+        virtual void transfer(uint8_t channel, const uint8_t *mosi, uint8_t *miso, size_t length) = 0;  // Exchanges "length" bytes
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Pending {
+        libusb_transfer *transfer;    // Submitted transfer
+        Clock::time_point submitted;  // Time of submission
+    };
+
+    std::mutex mutex_, eventMutex_;
+    std::condition_variable wakeup_;
+    Slave *slave_;
+    unsigned int latency_;
+    unsigned long bandwidth_;
+    bool connected_;
+    uint8_t prom_[CP2130::PROM_SIZE];
+    uint8_t gpioModes_[11], spiWords_[11], spiDelays_[11][7];
+    uint16_t gpioValues_, inputs_, csEnabled_;
+    uint8_t fifoThreshold_, clockDivider_, eventMode_;
+    uint16_t eventValue_;
+    bool eventOverflow_;
+    uint8_t header_[CP2130::CMD_HEADER_SIZE];
+    size_t headerLength_;
+    uint8_t command_, channel_;
+    uint32_t outRemaining_, commandLength_, readLength_, readRemaining_;
+    bool rtrActive_;
+    std::vector<uint8_t> inData_, deferred_, scratch_;
+    size_t inOffset_;
+    uint64_t inPushed_, inPopped_;
+    std::deque<uint64_t> boundaries_;
+    std::deque<Pending> pending_;
+    std::deque<libusb_transfer *> cancelled_;
+    Clock::time_point busFree_;
+    std::thread::id busOwner_;               // Thread that has claimed the bus, if any
+    std::unique_lock<std::mutex> *busLock_;  // Lock held by that thread, which is unlocked during slave callbacks
+
+    uint8_t activeChannel() const;
+    void claimBus(std::unique_lock<std::mutex> &lock);
+    int control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength);
+    void fill(size_t length);
+    void finishRead();
+    uint8_t inAddr() const;
+    bool manualCS(uint8_t channel) const;
+    uint16_t manualCSAsserted() const;
+    libusb_transfer *nextTransfer(Clock::time_point now, Clock::time_point &when);
+    uint8_t outAddr() const;
+    size_t popIn(unsigned char *data, size_t length, bool partial);
+    void processOut(const unsigned char *data, size_t length);
+    void pushIn(const uint8_t *data, size_t length, bool shortEnd);
+    void releaseBus();
+    void resetVolatile();
+    void slaveBegin(uint8_t channel);
+    void slaveEnd(uint8_t channel);
+    bool slaveRTR(uint8_t channel);
+    void spiTransfer(const uint8_t *mosi, uint8_t *miso, size_t length);
+    void startCommand(uint8_t command, uint32_t length);
+    Clock::duration transferTime(size_t length) const;
+    void writeString(size_t index, size_t size, const std::u16string &descriptor);
+
+public:
+    static const uint8_t NO_CHANNEL = 0xff;  // Channel passed to the slave when no chip select is enabled
+
+    CP2130Simulator();
+    ~CP2130Simulator();
+
+    unsigned long bandwidth() const;
+    bool isConnected() const;
+    unsigned int latency() const;
+
+    int bulkTransfer(uint8_t endpointAddr, unsigned char *data, int length, int *transferred, unsigned int timeout);
+    int cancelTransfer(libusb_transfer *transfer);
+    void connect();
+    int controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength, unsigned int timeout);
+    void countEvents(uint16_t count);
+    void disconnect();
+    int handleEvents(timeval *tv, int *completed);
+    void setBandwidth(unsigned long bandwidth);
+    void setInputs(uint16_t bmInputs);
+    void setLatency(unsigned int latency);
+    void setSlave(Slave *slave);
+    int submitTransfer(libusb_transfer *transfer);
+};
+
+#endif  // CP2130SIMULATOR_H
@@ -0,0 +1,386 @@
+/* CP2130Snapshot class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <cstring>
+#include "cp2130snapshot.h"
+
+// Definitions
+const size_t SLOT_SIZE = LIBUSB_CONTROL_SETUP_SIZE + 0x40;  // Size of the slot of each request, which fits its setup packet and the longest data stage
+
+// Layout of a serialized device state, in which the descriptors are the only fields of variable size
+const unsigned char FORMAT_MAGIC[6] = {'C', 'P', '2', '1', '3', '0'};
+const uint8_t FORMAT_VERSION = 0x01;
+const size_t HEADER_SIZE = sizeof(FORMAT_MAGIC) + 1;
+const size_t DESC_OFFSET = HEADER_SIZE + CP2130::GET_USB_CONFIG_WLEN + CP2130::GET_PIN_CONFIG_WLEN + CP2130::PROM_SIZE;
+const size_t TAIL_SIZE = CP2130::GET_LOCK_BYTE_WLEN + CP2130::GET_SPI_WORD_WLEN + 11 * (CP2130::GET_SPI_DELAY_WLEN - 1) + 2 + CP2130::GET_CLOCK_DIVIDER_WLEN + CP2130::GET_FULL_THRESHOLD_WLEN + CP2130::GET_EVENT_COUNTER_WLEN;
+
+// Index of the first request of each kind within a capture
+const size_t RQ_USB_CONFIG = 0;
+const size_t RQ_PIN_CONFIG = 1;
+const size_t RQ_PROM_CONFIG = 2;      // Followed by the requests for the remaining seven blocks
+const size_t RQ_MANUFACTURER = 10;    // Followed by the request for the second table
+const size_t RQ_PRODUCT = 12;         // Followed by the request for the second table
+const size_t RQ_SERIAL = 14;
+const size_t RQ_LOCK_BYTE = 15;
+const size_t RQ_SPI_WORD = 16;
+const size_t RQ_SPI_DELAY = 17;       // Followed by the requests for the remaining ten channels
+const size_t RQ_CHIP_SELECT = 28;
+const size_t RQ_CLOCK_DIVIDER = 29;
+const size_t RQ_FULL_THRESHOLD = 30;
+const size_t RQ_EVENT_COUNTER = 31;
+
+// "Equal to" operator for DeviceState
+bool CP2130Snapshot::DeviceState::operator ==(const CP2130Snapshot::DeviceState &other) const
+{
+    bool equal = usbConfig == other.usbConfig && pinConfig == other.pinConfig && promConfig == other.promConfig && manufacturer == other.manufacturer && product == other.product && serial == other.serial && lockWord == other.lockWord && cs == other.cs && clockDivider == other.clockDivider && fifoThreshold == other.fifoThreshold && eventCounter == other.eventCounter;
+    for (size_t i = 0; i < 11 && equal; ++i) {
+        equal = spiModes[i] == other.spiModes[i] && spiDelays[i] == other.spiDelays[i];
+    }
+    return equal;
+}
+
+// "Not equal to" operator for DeviceState
+bool CP2130Snapshot::DeviceState::operator !=(const CP2130Snapshot::DeviceState &other) const
+{
+    return !(operator ==(other));
+}
+
+// Private callback function for the requests issued by capture(), which is called from within CP2130::handleEvents()
+void LIBUSB_CALL CP2130Snapshot::callback(libusb_transfer *transfer)
+{
+    CP2130Snapshot *snapshot = static_cast<CP2130Snapshot *>(transfer->user_data);
+    if (--snapshot->remaining_ == 0) {
+        snapshot->completed_ = 1;
+    }
+}
+
+// Private procedure that prepares the request in the given slot, so that it can be submitted
+void CP2130Snapshot::fillRequest(size_t index, uint8_t bRequest, uint16_t wIndex, uint16_t wLength)
+{
+    unsigned char *slot = &buffer_[index * SLOT_SIZE];
+    libusb_fill_control_setup(slot, CP2130::GET, bRequest, 0x0000, wIndex, wLength);
+    libusb_fill_control_transfer(transfers_[index], nullptr, slot, callback, this, CP2130::TR_TIMEOUT);  // The device handle is set by CP2130::submitTransfer()
+}
+
+// Private function that returns the data stage of the request in the given slot
+const unsigned char *CP2130Snapshot::response(size_t index) const
+{
+    return &buffer_[index * SLOT_SIZE + LIBUSB_CONTROL_SETUP_SIZE];
+}
+
+// Creates a snapshot facility for the given device, which must be open and must outlive the object
+CP2130Snapshot::CP2130Snapshot(CP2130 &device) :
+    device_(device),
+    buffer_(NREQUESTS * SLOT_SIZE),
+    remaining_(0),
+    completed_(0)
+{
+}
+
+CP2130Snapshot::~CP2130Snapshot()
+{
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+        libusb_free_transfer(transfers_[i]);
+    }
+}
+
+// Captures the current state of the device, using a single batch of concurrent requests
+// The state is only valid if no errors occur, and otherwise a zeroed state is returned
+CP2130Snapshot::DeviceState CP2130Snapshot::capture(int &errcnt, std::string &errstr)
+{
+    DeviceState state = DeviceState();
+    while (transfers_.size() < NREQUESTS) {  // Transfers are allocated once and reused by subsequent captures
+        libusb_transfer *transfer = libusb_alloc_transfer(0);
+        if (transfer == nullptr) {
+            break;
+        }
+        transfers_.push_back(transfer);
+    }
+    if (transfers_.size() < NREQUESTS) {
+        ++errcnt;
+        errstr += "Could not allocate transfers.\n";
+    } else {
+        fillRequest(RQ_USB_CONFIG, CP2130::GET_USB_CONFIG, 0x0000, CP2130::GET_USB_CONFIG_WLEN);
+        fillRequest(RQ_PIN_CONFIG, CP2130::GET_PIN_CONFIG, 0x0000, CP2130::GET_PIN_CONFIG_WLEN);
+        for (size_t i = 0; i < CP2130::PROM_BLOCKS; ++i) {
+            fillRequest(RQ_PROM_CONFIG + i, CP2130::GET_PROM_CONFIG, static_cast<uint16_t>(i), CP2130::GET_PROM_CONFIG_WLEN);
+        }
+        fillRequest(RQ_MANUFACTURER, CP2130::GET_MANUFACTURING_STRING_1, 0x0000, CP2130::GET_MANUFACTURING_STRING_1_WLEN);  // Unlike CP2130::getDescGeneric(), both tables are always requested, since that costs nothing here
+        fillRequest(RQ_MANUFACTURER + 1, CP2130::GET_MANUFACTURING_STRING_2, 0x0000, CP2130::GET_MANUFACTURING_STRING_2_WLEN);
+        fillRequest(RQ_PRODUCT, CP2130::GET_PRODUCT_STRING_1, 0x0000, CP2130::GET_PRODUCT_STRING_1_WLEN);
+        fillRequest(RQ_PRODUCT + 1, CP2130::GET_PRODUCT_STRING_2, 0x0000, CP2130::GET_PRODUCT_STRING_2_WLEN);
+        fillRequest(RQ_SERIAL, CP2130::GET_SERIAL_STRING, 0x0000, CP2130::GET_SERIAL_STRING_WLEN);
+        fillRequest(RQ_LOCK_BYTE, CP2130::GET_LOCK_BYTE, 0x0000, CP2130::GET_LOCK_BYTE_WLEN);
+        fillRequest(RQ_SPI_WORD, CP2130::GET_SPI_WORD, 0x0000, CP2130::GET_SPI_WORD_WLEN);  // A single request returns the SPI modes of all channels
+        for (uint16_t i = 0; i < 11; ++i) {
+            fillRequest(RQ_SPI_DELAY + i, CP2130::GET_SPI_DELAY, i, CP2130::GET_SPI_DELAY_WLEN);
+        }
+        fillRequest(RQ_CHIP_SELECT, CP2130::GET_GPIO_CHIP_SELECT, 0x0000, CP2130::GET_GPIO_CHIP_SELECT_WLEN);
+        fillRequest(RQ_CLOCK_DIVIDER, CP2130::GET_CLOCK_DIVIDER, 0x0000, CP2130::GET_CLOCK_DIVIDER_WLEN);
+        fillRequest(RQ_FULL_THRESHOLD, CP2130::GET_FULL_THRESHOLD, 0x0000, CP2130::GET_FULL_THRESHOLD_WLEN);
+        fillRequest(RQ_EVENT_COUNTER, CP2130::GET_EVENT_COUNTER, 0x0000, CP2130::GET_EVENT_COUNTER_WLEN);
+        device_.lockEvents();  // The callback changes the state read below, so it must not be called by a background thread meanwhile
+        remaining_ = 0;
+        completed_ = 0;
+        size_t nsubmitted = 0;
+        int preverrcnt = errcnt;
+        while (nsubmitted < NREQUESTS && errcnt == preverrcnt) {  // Every request is submitted before any response is awaited
+            device_.submitTransfer(transfers_[nsubmitted], errcnt, errstr);
+            if (errcnt == preverrcnt) {
+                ++remaining_;
+                ++nsubmitted;
+            }
+        }
+        int evterrcnt = 0;
+        std::string evterrstr;
+        bool cancelled = false;
+        while (remaining_ > 0 && device_.isOpen()) {  // Every callback is awaited, so that no transfer is reused or freed while in flight
+            device_.handleEvents(CP2130::EVENT_INTERVAL, &completed_, evterrcnt, evterrstr);
+            if (evterrcnt != 0 && !cancelled) {  // If events could not be handled, the failure is reported once, and the requests still in flight are cancelled
+                ++errcnt;
+                errstr += evterrstr;
+                for (size_t i = 0; i < nsubmitted; ++i) {
+                    device_.cancelTransfer(transfers_[i]);
+                }
+                cancelled = true;
+            }
+        }
+        device_.unlockEvents();
+        for (size_t i = 0; i < nsubmitted && remaining_ == 0; ++i) {
+            device_.checkTransfer(transfers_[i], errcnt, errstr);
+        }
+        if (errcnt == preverrcnt) {
+            state.usbConfig = CP2130::decodeUSBConfig(response(RQ_USB_CONFIG));
+            state.pinConfig = CP2130::decodePinConfig(response(RQ_PIN_CONFIG));
+            for (size_t i = 0; i < CP2130::PROM_BLOCKS; ++i) {
+                std::memcpy(state.promConfig.blocks[i], response(RQ_PROM_CONFIG + i), CP2130::PROM_BLOCK_SIZE);
+            }
+            state.manufacturer = CP2130::decodeDesc(response(RQ_MANUFACTURER), response(RQ_MANUFACTURER + 1));
+            state.product = CP2130::decodeDesc(response(RQ_PRODUCT), response(RQ_PRODUCT + 1));
+            state.serial = CP2130::decodeDesc(response(RQ_SERIAL), nullptr);
+            state.lockWord = static_cast<uint16_t>(response(RQ_LOCK_BYTE)[1] << 8 | response(RQ_LOCK_BYTE)[0]);  // Both lock bytes as a word (little-endian conversion)
+            for (size_t i = 0; i < 11; ++i) {
+                state.spiModes[i] = CP2130::decodeSPIMode(response(RQ_SPI_WORD)[i]);
+                state.spiDelays[i] = CP2130::decodeSPIDelays(response(RQ_SPI_DELAY + i) + 1);  // Byte 0 is the channel
+            }
+            state.cs = static_cast<uint16_t>(0x07ff & (response(RQ_CHIP_SELECT)[0] << 8 | response(RQ_CHIP_SELECT)[1]));  // Chip select enable bitmap corresponds to bytes 0 and 1 (big-endian conversion)
+            state.clockDivider = response(RQ_CLOCK_DIVIDER)[0];
+            state.fifoThreshold = response(RQ_FULL_THRESHOLD)[0];
+            state.eventCounter = CP2130::decodeEventCounter(response(RQ_EVENT_COUNTER));
+        }
+    }
+    return state;
+}
+
+// Reconstructs a device state from data returned by serialize()
+// If the data is not a valid serialized device state, an error is reported and a zeroed state is returned
+CP2130Snapshot::DeviceState CP2130Snapshot::deserialize(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr)
+{
+    DeviceState state = DeviceState();
+    size_t end = DESC_OFFSET;
+    size_t ndescs = 0;
+    while (ndescs < 3 && end < data.size()) {  // Each descriptor is preceded by its length in characters
+        end += 1 + 2 * data[end];
+        ++ndescs;
+    }
+    if (ndescs != 3 || data.size() != end + TAIL_SIZE || std::memcmp(data.data(), FORMAT_MAGIC, sizeof(FORMAT_MAGIC)) != 0 || data[sizeof(FORMAT_MAGIC)] != FORMAT_VERSION) {
+        ++errcnt;
+        errstr += "In deserialize(): data is not a valid device state.\n";
+    } else {
+        const unsigned char *field = data.data() + HEADER_SIZE;
+        state.usbConfig = CP2130::decodeUSBConfig(field);
+        field += CP2130::GET_USB_CONFIG_WLEN;
+        state.pinConfig = CP2130::decodePinConfig(field);
+        field += CP2130::GET_PIN_CONFIG_WLEN;
+        for (size_t i = 0; i < CP2130::PROM_BLOCKS; ++i) {
+            std::memcpy(state.promConfig.blocks[i], field, CP2130::PROM_BLOCK_SIZE);
+            field += CP2130::PROM_BLOCK_SIZE;
+        }
+        std::u16string *descriptors[3] = {&state.manufacturer, &state.product, &state.serial};
+        for (size_t i = 0; i < 3; ++i) {
+            size_t length = *field++;
+            for (size_t j = 0; j < length; ++j) {
+                *descriptors[i] += static_cast<char16_t>(field[1] << 8 | field[0]);  // UTF-16LE conversion, as in the descriptor tables
+                field += 2;
+            }
+        }
+        state.lockWord = static_cast<uint16_t>(field[1] << 8 | field[0]);  // Little-endian conversion, as returned by Get_Lock_Byte
+        field += CP2130::GET_LOCK_BYTE_WLEN;
+        for (size_t i = 0; i < 11; ++i) {
+            state.spiModes[i] = CP2130::decodeSPIMode(field[i]);
+        }
+        field += CP2130::GET_SPI_WORD_WLEN;
+        for (size_t i = 0; i < 11; ++i) {
+            state.spiDelays[i] = CP2130::decodeSPIDelays(field);
+            field += CP2130::GET_SPI_DELAY_WLEN - 1;
+        }
+        state.cs = static_cast<uint16_t>(0x07ff & (field[0] << 8 | field[1]));  // Big-endian conversion, as returned by Get_GPIO_Chip_Select
+        field += 2;
+        state.clockDivider = *field++;
+        state.fifoThreshold = *field++;
+        state.eventCounter = CP2130::decodeEventCounter(field);
+    }
+    return state;
+}
+
+// Compares the given device states, and returns which of their fields differ
+CP2130Snapshot::Diff CP2130Snapshot::diff(const DeviceState &state1, const DeviceState &state2)
+{
+    Diff changes = {0x0000, 0x0000, 0x0000};
+    for (size_t i = 0; i < 11; ++i) {
+        if (state1.spiModes[i] != state2.spiModes[i]) {
+            changes.spiModes = static_cast<uint16_t>(changes.spiModes | 0x0001 << i);
+        }
+        if (state1.spiDelays[i] != state2.spiDelays[i]) {
+            changes.spiDelays = static_cast<uint16_t>(changes.spiDelays | 0x0001 << i);
+        }
+    }
+    const bool differs[] = {
+        state1.usbConfig != state2.usbConfig,                 // DFUSBCONFIG
+        state1.pinConfig != state2.pinConfig,                 // DFPINCONFIG
+        state1.promConfig != state2.promConfig,               // DFPROMCONFIG
+        state1.manufacturer != state2.manufacturer,           // DFMANUFACTURER
+        state1.product != state2.product,                     // DFPRODUCT
+        state1.serial != state2.serial,                       // DFSERIAL
+        state1.lockWord != state2.lockWord,                   // DFLOCKWORD
+        changes.spiModes != 0x0000,                           // DFSPIMODES
+        changes.spiDelays != 0x0000,                          // DFSPIDELAYS
+        state1.cs != state2.cs,                               // DFCS
+        state1.clockDivider != state2.clockDivider,           // DFCLOCKDIVIDER
+        state1.fifoThreshold != state2.fifoThreshold,         // DFFIFOTHRESHOLD
+        state1.eventCounter.mode != state2.eventCounter.mode  // DFEVENTCOUNTER
+    };
+    for (size_t i = 0; i < sizeof(differs) / sizeof(differs[0]); ++i) {
+        if (differs[i]) {
+            changes.fields = static_cast<uint16_t>(changes.fields | 0x0001 << i);
+        }
+    }
+    return changes;
+}
+
+// Captures the current state of the device, and applies the volatile settings of the given state that differ from it
+void CP2130Snapshot::restore(const DeviceState &state, int &errcnt, std::string &errstr)
+{
+    int preverrcnt = errcnt;
+    DeviceState current = capture(errcnt, errstr);
+    if (errcnt == preverrcnt) {
+        restore(state, current, errcnt, errstr);
+    }
+}
+
+// Applies the volatile settings of the given state that differ from the current state of the device, as captured beforehand
+// The settings kept in the OTP ROM are never written, even if they differ, and the count of the event counter is kept, so that only its mode is restored
+void CP2130Snapshot::restore(const DeviceState &state, const DeviceState &current, int &errcnt, std::string &errstr)
+{
+    Diff changes = diff(current, state);
+    for (uint8_t i = 0; i < 11; ++i) {
+        if ((0x0001 << i & changes.spiModes) != 0x0000) {
+            device_.configureSPIMode(i, state.spiModes[i], errcnt, errstr);
+        }
+        if ((0x0001 << i & changes.spiDelays) != 0x0000) {
+            device_.configureSPIDelays(i, state.spiDelays[i], errcnt, errstr);
+        }
+    }
+    if ((DFCLOCKDIVIDER & changes.fields) != 0x0000) {
+        device_.setClockDivider(state.clockDivider, errcnt, errstr);
+    }
+    if ((DFFIFOTHRESHOLD & changes.fields) != 0x0000) {
+        device_.setFIFOThreshold(state.fifoThreshold, errcnt, errstr);
+    }
+    if ((DFEVENTCOUNTER & changes.fields) != 0x0000) {
+        CP2130::EventCounter evtcntr = {false, state.eventCounter.mode, current.eventCounter.value};
+        device_.setEventCounter(evtcntr, errcnt, errstr);
+    }
+    for (uint8_t i = 0; i < 11; ++i) {  // Chip selects are restored last, so that each channel is already configured when enabled
+        uint16_t mask = static_cast<uint16_t>(0x0001 << i);
+        if (((state.cs ^ current.cs) & mask) != 0x0000) {
+            if ((state.cs & mask) != 0x0000) {
+                device_.enableCS(i, errcnt, errstr);
+            } else {
+                device_.disableCS(i, errcnt, errstr);
+            }
+        }
+    }
+}
+
+// Converts the given device state to a portable sequence of bytes, which can be stored and later passed to deserialize()
+// After a six-byte magic and a version byte, each field follows in the same layout returned by its request, except for the descriptors, which are preceded by their length in characters
+std::vector<uint8_t> CP2130Snapshot::serialize(const DeviceState &state)
+{
+    std::vector<uint8_t> data(FORMAT_MAGIC, FORMAT_MAGIC + sizeof(FORMAT_MAGIC));
+    data.push_back(FORMAT_VERSION);
+    const uint8_t usbConfig[CP2130::GET_USB_CONFIG_WLEN] = {
+        static_cast<uint8_t>(state.usbConfig.vid), static_cast<uint8_t>(state.usbConfig.vid >> 8),  // Little-endian
+        static_cast<uint8_t>(state.usbConfig.pid), static_cast<uint8_t>(state.usbConfig.pid >> 8),  // Little-endian
+        state.usbConfig.maxpow,
+        state.usbConfig.powmode,
+        state.usbConfig.majrel,
+        state.usbConfig.minrel,
+        state.usbConfig.trfprio
+    };
+    data.insert(data.end(), usbConfig, usbConfig + CP2130::GET_USB_CONFIG_WLEN);
+    const CP2130::PinConfig &pins = state.pinConfig;
+    const uint8_t pinConfig[CP2130::GET_PIN_CONFIG_WLEN] = {
+        pins.gpio0, pins.gpio1, pins.gpio2, pins.gpio3, pins.gpio4, pins.gpio5, pins.gpio6, pins.gpio7, pins.gpio8, pins.gpio9, pins.gpio10,
+        static_cast<uint8_t>(pins.sspndlvl >> 8), static_cast<uint8_t>(pins.sspndlvl),    // Big-endian
+        static_cast<uint8_t>(pins.sspndmode >> 8), static_cast<uint8_t>(pins.sspndmode),  // Big-endian
+        static_cast<uint8_t>(pins.wkupmask >> 8), static_cast<uint8_t>(pins.wkupmask),    // Big-endian
+        static_cast<uint8_t>(pins.wkupmatch >> 8), static_cast<uint8_t>(pins.wkupmatch),  // Big-endian
+        pins.divider
+    };
+    data.insert(data.end(), pinConfig, pinConfig + CP2130::GET_PIN_CONFIG_WLEN);
+    for (size_t i = 0; i < CP2130::PROM_BLOCKS; ++i) {
+        data.insert(data.end(), state.promConfig.blocks[i], state.promConfig.blocks[i] + CP2130::PROM_BLOCK_SIZE);
+    }
+    const std::u16string *descriptors[3] = {&state.manufacturer, &state.product, &state.serial};
+    for (size_t i = 0; i < 3; ++i) {
+        size_t length = descriptors[i]->size() > 0xff ? 0xff : descriptors[i]->size();  // Descriptors are far shorter than this, unless set to invalid values
+        data.push_back(static_cast<uint8_t>(length));
+        for (size_t j = 0; j < length; ++j) {
+            data.push_back(static_cast<uint8_t>((*descriptors[i])[j]));       // UTF-16LE, as in the descriptor tables
+            data.push_back(static_cast<uint8_t>((*descriptors[i])[j] >> 8));
+        }
+    }
+    data.push_back(static_cast<uint8_t>(state.lockWord));  // Little-endian
+    data.push_back(static_cast<uint8_t>(state.lockWord >> 8));
+    for (size_t i = 0; i < 11; ++i) {
+        const CP2130::SPIMode &mode = state.spiModes[i];
+        data.push_back(static_cast<uint8_t>(mode.cpha << 5 | mode.cpol << 4 | mode.csmode << 3 | (0x07 & mode.cfrq)));  // Control word
+    }
+    for (size_t i = 0; i < 11; ++i) {
+        const CP2130::SPIDelays &delays = state.spiDelays[i];
+        const uint8_t spiDelay[CP2130::GET_SPI_DELAY_WLEN - 1] = {
+            static_cast<uint8_t>(delays.cstglen << 3 | delays.prdasten << 2 | delays.pstasten << 1 | (delays.itbyten)),  // Enable mask
+            static_cast<uint8_t>(delays.itbytdly >> 8), static_cast<uint8_t>(delays.itbytdly),                           // Inter-byte delay (big-endian)
+            static_cast<uint8_t>(delays.pstastdly >> 8), static_cast<uint8_t>(delays.pstastdly),                         // Post-assert delay (big-endian)
+            static_cast<uint8_t>(delays.prdastdly >> 8), static_cast<uint8_t>(delays.prdastdly)                          // Pre-deassert delay (big-endian)
+        };
+        data.insert(data.end(), spiDelay, spiDelay + CP2130::GET_SPI_DELAY_WLEN - 1);
+    }
+    data.push_back(static_cast<uint8_t>(state.cs >> 8));  // Big-endian
+    data.push_back(static_cast<uint8_t>(state.cs));
+    data.push_back(state.clockDivider);
+    data.push_back(state.fifoThreshold);
+    data.push_back(static_cast<uint8_t>((state.eventCounter.overflow ? 0x80 : 0x00) | (0x07 & state.eventCounter.mode)));
+    data.push_back(static_cast<uint8_t>(state.eventCounter.value >> 8));  // Big-endian
+    data.push_back(static_cast<uint8_t>(state.eventCounter.value));
+    return data;
+}
@@ -0,0 +1,110 @@
+/* CP2130Snapshot class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130SNAPSHOT_H
+#define CP2130SNAPSHOT_H
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Captures the whole state of a CP2130 at once, so that it can be stored, compared with another state, or partially restored
+// Every request of a capture is submitted before any response is awaited, so that the device answers them back to back, instead of taking one round trip per request
+// Only the volatile settings (SPI modes and delays, chip selects, clock divider, FIFO threshold and event counter mode) are restored, since the remaining ones are kept in the OTP ROM
+// GPIO modes are not captured, because the CP2130 has no request that returns them (see CP2130::configureGPIO())
+class CP2130Snapshot
+{
+public:
+    struct DeviceState {
+        CP2130::USBConfig usbConfig;
+        CP2130::PinConfig pinConfig;
+        CP2130::PROMConfig promConfig;
+        std::u16string manufacturer;
+        std::u16string product;
+        std::u16string serial;
+        uint16_t lockWord;
+        CP2130::SPIMode spiModes[11];
+        CP2130::SPIDelays spiDelays[11];
+        uint16_t cs;  // Chip select enable bitmap (bit N corresponds to channel N)
+        uint8_t clockDivider;
+        uint8_t fifoThreshold;
+        CP2130::EventCounter eventCounter;
+
+        bool operator ==(const DeviceState &other) const;
+        bool operator !=(const DeviceState &other) const;
+    };
+
+    struct Diff {
+        uint16_t fields;     // Bitmap of the fields that differ (see the DF* values)
+        uint16_t spiModes;   // Bitmap of the channels whose SPI modes differ (bit N corresponds to channel N)
+        uint16_t spiDelays;  // Bitmap of the channels whose SPI delays differ (bit N corresponds to channel N)
+    };
+
+    // Bitmaps applicable to Diff/diff()
+    static const uint16_t DFUSBCONFIG = 0x0001;      // Mask for the USB configuration
+    static const uint16_t DFPINCONFIG = 0x0002;      // Mask for the pin configuration
+    static const uint16_t DFPROMCONFIG = 0x0004;     // Mask for the OTP ROM content
+    static const uint16_t DFMANUFACTURER = 0x0008;   // Mask for the manufacturer descriptor
+    static const uint16_t DFPRODUCT = 0x0010;        // Mask for the product descriptor
+    static const uint16_t DFSERIAL = 0x0020;         // Mask for the serial descriptor
+    static const uint16_t DFLOCKWORD = 0x0040;       // Mask for the lock word
+    static const uint16_t DFSPIMODES = 0x0080;       // Mask for the SPI modes of any channel
+    static const uint16_t DFSPIDELAYS = 0x0100;      // Mask for the SPI delays of any channel
+    static const uint16_t DFCS = 0x0200;             // Mask for the chip select enable bitmap
+    static const uint16_t DFCLOCKDIVIDER = 0x0400;   // Mask for the clock divider
+    static const uint16_t DFFIFOTHRESHOLD = 0x0800;  // Mask for the full FIFO threshold
+    static const uint16_t DFEVENTCOUNTER = 0x1000;   // Mask for the event counter mode (the count and the overflow flag are not compared)
+    static const uint16_t DFOTP = 0x007f;            // Mask for all the fields kept in the OTP ROM
+    static const uint16_t DFVOLATILE = 0x1f80;       // Mask for all the fields that restore() can apply
+
+private:
+    static const size_t NREQUESTS = 32;
+
+    CP2130 &device_;
+    std::vector<libusb_transfer *> transfers_;
+    std::vector<unsigned char> buffer_;  // Setup packet and data stage of each request, in slots of fixed size
+    int remaining_;
+    int completed_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+    void fillRequest(size_t index, uint8_t bRequest, uint16_t wIndex, uint16_t wLength);
+    const unsigned char *response(size_t index) const;
+
+public:
+    explicit CP2130Snapshot(CP2130 &device);
+    ~CP2130Snapshot();
+
+    CP2130Snapshot(const CP2130Snapshot &) = delete;
+    CP2130Snapshot &operator =(const CP2130Snapshot &) = delete;
+
+    DeviceState capture(int &errcnt, std::string &errstr);
+    void restore(const DeviceState &state, int &errcnt, std::string &errstr);
+    void restore(const DeviceState &state, const DeviceState &current, int &errcnt, std::string &errstr);
+
+    static DeviceState deserialize(const std::vector<uint8_t> &data, int &errcnt, std::string &errstr);
+    static Diff diff(const DeviceState &state1, const DeviceState &state2);
+    static std::vector<uint8_t> serialize(const DeviceState &state);
+};
+
+#endif  // CP2130SNAPSHOT_H
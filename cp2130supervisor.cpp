@@ -0,0 +1,155 @@
+/* CP2130Supervisor class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include "cp2130.h"
+#include "cp2130supervisor.h"
+
+// Definitions
+const unsigned int POLL_INTERVAL = 250;  // Interval in milliseconds between walks of the bus, when hotplug is not supported
+
+// Private callback function that is called by libusb, from the event thread, whenever a device having the given VID and PID arrives
+// Serial numbers cannot be read here, so waitForDevice() is merely woken up, in order to look for the device
+int LIBUSB_CALL CP2130Supervisor::hotplugCallback(libusb_context *, libusb_device *, libusb_hotplug_event, void *userData)
+{
+    CP2130Supervisor *supervisor = static_cast<CP2130Supervisor *>(userData);
+    std::lock_guard<std::mutex> lock(supervisor->mutex_);
+    ++supervisor->arrivals_;
+    supervisor->arrival_.notify_all();
+    return 0;  // Keep the callback registered
+}
+
+// Private procedure that handles the events of the hotplug context, and runs in its own thread if hotplug is supported
+// No device is ever opened on that context, so only hotplug callbacks are called here
+void CP2130Supervisor::eventLoop()
+{
+    while (running_) {
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = static_cast<suseconds_t>(CP2130::EVENT_INTERVAL * 1000);
+        libusb_handle_events_timeout_completed(hotplugContext_, &tv, nullptr);
+    }
+}
+
+CP2130Supervisor::CP2130Supervisor(uint16_t vid, uint16_t pid, const std::string &serial) :
+    context_(nullptr),
+    hotplugContext_(nullptr),
+    initialized_(false),
+    hotplug_(false),
+    serial_(serial),
+    callbackHandle_(),
+    running_(false),
+    arrivals_(0),
+    timeout_(TIMEOUT_DEFAULT)
+{
+    initialized_ = libusb_init(&context_) == 0;
+    if (initialized_) {
+        index_.reset(new CP2130DeviceIndex(context_, vid, pid));
+        if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG) != 0 && libusb_init(&hotplugContext_) == 0) {
+            hotplug_ = libusb_hotplug_register_callback(hotplugContext_, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED, LIBUSB_HOTPLUG_NO_FLAGS, vid, pid, LIBUSB_HOTPLUG_MATCH_ANY, hotplugCallback, this, &callbackHandle_) == LIBUSB_SUCCESS;
+            if (hotplug_) {
+                running_ = true;
+                eventThread_ = std::thread(&CP2130Supervisor::eventLoop, this);
+            } else {
+                libusb_exit(hotplugContext_);
+                hotplugContext_ = nullptr;
+            }
+        }
+    }
+}
+
+CP2130Supervisor::~CP2130Supervisor()
+{
+    if (hotplug_) {
+        running_ = false;
+        eventThread_.join();
+        libusb_hotplug_deregister_callback(hotplugContext_, callbackHandle_);
+        libusb_exit(hotplugContext_);
+    }
+    if (initialized_) {
+        index_.reset();  // The index must release its devices before the context is deinitialized
+        libusb_exit(context_);  // Deinitialize libusb
+    }
+}
+
+// Returns true if arrivals are detected via hotplug events, or false if the bus is polled instead
+bool CP2130Supervisor::hasHotplug() const
+{
+    return hotplug_;
+}
+
+// Returns true if the supervisor was successfully initialized, or false otherwise (i.e., if libusb could not be initialized)
+bool CP2130Supervisor::isValid() const
+{
+    return initialized_;
+}
+
+// Returns the serial number of the supervised device
+const std::string &CP2130Supervisor::serial() const
+{
+    return serial_;
+}
+
+// Returns the time in milliseconds that a paused transfer waits for the device to come back
+unsigned int CP2130Supervisor::timeout() const
+{
+    return timeout_;
+}
+
+// Returns the index used to find the supervised device, which uses the context of the supervisor
+// The device can also be opened initially using CP2130::open(supervisor.index(), supervisor.serial())
+CP2130DeviceIndex &CP2130Supervisor::index()
+{
+    return *index_;
+}
+
+// Sets the time in milliseconds that a paused transfer waits for the device to come back
+void CP2130Supervisor::setTimeout(unsigned int timeout)
+{
+    timeout_ = timeout;
+}
+
+// Waits until the supervised device is present, or until the given deadline, returning true if the device is present, or false otherwise
+// The index is refreshed on every arrival, so that devices that are gone are dropped and only new devices are opened
+bool CP2130Supervisor::waitForDevice(std::chrono::steady_clock::time_point deadline)
+{
+    bool found = false;
+    if (initialized_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            uint64_t arrivals = arrivals_;
+            lock.unlock();  // The index is refreshed without holding the lock, since that may take a while
+            int errcnt = 0;
+            std::string errstr;
+            index_->refresh(errcnt, errstr);
+            found = !index_->path(serial_).empty();
+            lock.lock();
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (found || now >= deadline) {
+                break;
+            }
+            std::chrono::steady_clock::time_point poll = now + std::chrono::milliseconds(POLL_INTERVAL);
+            std::chrono::steady_clock::time_point wakeup = hotplug_ ? deadline : std::min(deadline, poll);
+            arrival_.wait_until(lock, wakeup, [&] { return arrivals_ != arrivals; });
+        }
+    }
+    return found;
+}
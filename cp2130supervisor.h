@@ -0,0 +1,74 @@
+/* CP2130Supervisor class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130SUPERVISOR_H
+#define CP2130SUPERVISOR_H
+
+// Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <libusb-1.0/libusb.h>
+#include "cp2130deviceindex.h"
+
+// Watches for the device having a given VID, PID and serial number, so that a CP2130 object can reconnect to it automatically (see CP2130::setSupervisor())
+// Arrivals are detected via libusb hotplug events, or by polling the bus on platforms where hotplug is not supported
+// The supervisor has its own libusb context, which is used by the devices it reopens, and therefore it must outlive them
+// Hotplug events are handled on a second context, so that the event thread never completes the transfers of those devices
+class CP2130Supervisor
+{
+private:
+    libusb_context *context_, *hotplugContext_;
+    bool initialized_, hotplug_;
+    std::string serial_;
+    std::unique_ptr<CP2130DeviceIndex> index_;
+    libusb_hotplug_callback_handle callbackHandle_;
+    std::thread eventThread_;
+    std::atomic<bool> running_;
+    std::mutex mutex_;
+    std::condition_variable arrival_;
+    uint64_t arrivals_;
+    unsigned int timeout_;
+
+    static int LIBUSB_CALL hotplugCallback(libusb_context *context, libusb_device *device, libusb_hotplug_event event, void *userData);
+    void eventLoop();
+
+public:
+    static const unsigned int TIMEOUT_DEFAULT = 10000;  // Default time in milliseconds that a paused transfer waits for the device to come back
+
+    CP2130Supervisor(uint16_t vid, uint16_t pid, const std::string &serial);
+    ~CP2130Supervisor();
+
+    bool hasHotplug() const;
+    bool isValid() const;
+    const std::string &serial() const;
+    unsigned int timeout() const;
+
+    CP2130DeviceIndex &index();
+    void setTimeout(unsigned int timeout);
+    bool waitForDevice(std::chrono::steady_clock::time_point deadline);
+};
+
+#endif  // CP2130SUPERVISOR_H
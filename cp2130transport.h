@@ -0,0 +1,43 @@
+/* CP2130Transport class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130TRANSPORT_H
+#define CP2130TRANSPORT_H
+
+// Includes
+#include <cstdint>
+#include <sys/time.h>
+#include <libusb-1.0/libusb.h>
+
+// Interface that CP2130 uses in place of libusb, after being opened with CP2130::open(CP2130Transport &)
+// Every function has the same semantics and return values as its libusb counterpart, so that a transport can be swapped for a real device transparently
+class CP2130Transport
+{
+public:
+    virtual ~CP2130Transport() {}
+
+    virtual int bulkTransfer(uint8_t endpointAddr, unsigned char *data, int length, int *transferred, unsigned int timeout) = 0;                                              // Equivalent to libusb_bulk_transfer()
+    virtual int cancelTransfer(libusb_transfer *transfer) = 0;                                                                                                                // Equivalent to libusb_cancel_transfer()
+    virtual int controlTransfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data, uint16_t wLength, unsigned int timeout) = 0;  // Equivalent to libusb_control_transfer()
+    virtual int handleEvents(timeval *tv, int *completed) = 0;                                                                                                                // Equivalent to libusb_handle_events_timeout_completed()
+    virtual int submitTransfer(libusb_transfer *transfer) = 0;                                                                                                                // Equivalent to libusb_submit_transfer()
+};
+
+#endif  // CP2130TRANSPORT_H
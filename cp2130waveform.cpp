@@ -0,0 +1,181 @@
+/* CP2130Waveform class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+// Includes
+#include <algorithm>
+#include <thread>
+#include "cp2130waveform.h"
+
+// Private callback function for the requests issued by the waveform, which is called from within run()
+void LIBUSB_CALL CP2130Waveform::callback(libusb_transfer *transfer)
+{
+    Slot *slot = static_cast<Slot *>(transfer->user_data);
+    CP2130Waveform *waveform = slot->waveform;
+    if (transfer->status == LIBUSB_TRANSFER_COMPLETED && transfer->actual_length == CP2130::SET_GPIO_VALUES_WLEN) {
+        waveform->acked_[slot->step] = std::chrono::steady_clock::now();
+    } else if (transfer->status != LIBUSB_TRANSFER_CANCELLED && waveform->failedTransfer_ == nullptr) {  // Only the first failure is reported, and transfers are only cancelled after a failure
+        waveform->failedTransfer_ = transfer;
+    }
+    slot->inflight = false;
+    waveform->freeSlots_.push_back(static_cast<size_t>(slot - waveform->slots_.data()));
+    --waveform->inflight_;
+    waveform->completed_ = 1;
+}
+
+// Creates a waveform engine for the given device, which must be open while run() is called
+CP2130Waveform::CP2130Waveform(CP2130 &device) :
+    device_(device),
+    depth_(DEPTH_DEFAULT),
+    failedTransfer_(nullptr),
+    inflight_(0),
+    completed_(0)
+{
+}
+
+CP2130Waveform::~CP2130Waveform()
+{
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        libusb_free_transfer(slots_[i].transfer);
+    }
+}
+
+// Returns the number of requests kept in flight
+size_t CP2130Waveform::depth() const
+{
+    return depth_;
+}
+
+// Applies the given steps in sequence, returning a report of the timing achieved
+// Each step is submitted once its scheduled time is reached, as long as fewer than depth() requests are in flight, and steps that fall behind are submitted as soon as possible
+// Since the levels are set without the device knowing, its shadow is invalidated
+CP2130Waveform::Report CP2130Waveform::run(const std::vector<Step> &steps, int &errcnt, std::string &errstr)
+{
+    Report report = {0, 0, 0, std::vector<Timing>()};
+    if (!device_.isOpen()) {
+        ++errcnt;
+        errstr += "In run(): device is not open.\n";  // Program logic error
+    } else if (!steps.empty()) {
+        device_.invalidateShadow();
+        while (slots_.size() < depth_) {  // Transfers are allocated once and reused by subsequent calls
+            libusb_transfer *transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr) {  // If allocation fails, fewer requests are kept in flight
+                break;
+            }
+            Slot slot = {this, 0, transfer, {}, false};
+            slots_.push_back(slot);
+        }
+        size_t depth = std::min(depth_, slots_.size());
+        if (depth == 0) {
+            ++errcnt;
+            errstr += "In run(): could not allocate transfers.\n";
+        } else {
+            std::vector<uint64_t> requested(steps.size());
+            for (size_t i = 1; i < steps.size(); ++i) {
+                requested[i] = requested[i - 1] + steps[i - 1].delay;
+            }
+            device_.lockEvents();  // The callbacks change the state read below, so they must not be called by a background thread meanwhile
+            freeSlots_.clear();
+            for (size_t i = depth; i > 0; --i) {
+                freeSlots_.push_back(i - 1);
+            }
+            acked_.assign(steps.size(), std::chrono::steady_clock::time_point());
+            failedTransfer_ = nullptr;
+            inflight_ = 0;
+            size_t next = 0;
+            bool failed = false, cancelled = false;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            while (inflight_ > 0 || (next < steps.size() && !failed)) {
+                if (failedTransfer_ != nullptr && !cancelled) {  // On failure, every request still in flight is cancelled, since the steps that follow would be applied out of sequence (this is done first, so that the failed transfer is not reused)
+                    failed = true;
+                    for (size_t i = 0; i < depth; ++i) {
+                        if (slots_[i].inflight) {
+                            device_.cancelTransfer(slots_[i].transfer);
+                        }
+                    }
+                    cancelled = true;
+                }
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                while (!failed && next < steps.size() && !freeSlots_.empty() && now >= start + std::chrono::microseconds(requested[next])) {
+                    size_t index = freeSlots_.back();
+                    freeSlots_.pop_back();
+                    Slot &slot = slots_[index];
+                    uint16_t bmValues = CP2130::BMGPIOS & steps[next].bmValues;
+                    uint16_t bmMask = CP2130::BMGPIOS & steps[next].bmMask;
+                    libusb_fill_control_setup(slot.buffer, CP2130::SET, CP2130::SET_GPIO_VALUES, 0x0000, 0x0000, CP2130::SET_GPIO_VALUES_WLEN);
+                    unsigned char *controlBufferOut = slot.buffer + LIBUSB_CONTROL_SETUP_SIZE;
+                    controlBufferOut[0] = static_cast<uint8_t>(bmValues >> 8);  // GPIO values bitmap
+                    controlBufferOut[1] = static_cast<uint8_t>(bmValues);
+                    controlBufferOut[2] = static_cast<uint8_t>(bmMask >> 8);    // Mask bitmap
+                    controlBufferOut[3] = static_cast<uint8_t>(bmMask);
+                    libusb_fill_control_transfer(slot.transfer, nullptr, slot.buffer, callback, &slot, CP2130::TR_TIMEOUT);  // The device handle is set by CP2130::submitTransfer()
+                    slot.step = next;
+                    int preverrcnt = errcnt;
+                    device_.submitTransfer(slot.transfer, errcnt, errstr);
+                    if (errcnt != preverrcnt) {  // The failure is already reported by submitTransfer()
+                        freeSlots_.push_back(index);
+                        failed = true;
+                    } else {
+                        slot.inflight = true;
+                        ++inflight_;
+                        ++next;
+                    }
+                }
+                if (inflight_ == 0) {
+                    if (failed || next == steps.size()) {
+                        break;
+                    }
+                    std::this_thread::sleep_until(start + std::chrono::microseconds(requested[next]));  // Nothing to wait for but the next step
+                } else {
+                    unsigned int timeout = CP2130::EVENT_INTERVAL;
+                    if (!failed && next < steps.size() && !freeSlots_.empty()) {  // Events are handled until the next step is due, or polled if it is due in less than a millisecond
+                        std::chrono::milliseconds wait = std::chrono::duration_cast<std::chrono::milliseconds>(start + std::chrono::microseconds(requested[next]) - now);
+                        timeout = static_cast<unsigned int>(std::max<long long>(0, std::min<long long>(CP2130::EVENT_INTERVAL, wait.count())));
+                    }
+                    completed_ = 0;
+                    device_.handleEvents(timeout, &completed_, errcnt, errstr);
+                }
+            }
+            device_.unlockEvents();
+            if (failedTransfer_ != nullptr) {
+                device_.checkTransfer(failedTransfer_, errcnt, errstr);
+            }
+            while (report.steps < steps.size() && acked_[report.steps] != std::chrono::steady_clock::time_point()) {
+                ++report.steps;
+            }
+            uint64_t totalError = 0;
+            for (size_t i = 0; i < report.steps; ++i) {
+                Timing timing = {requested[i], static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(acked_[i] - acked_[0]).count())};
+                uint64_t error = timing.achieved > timing.requested ? timing.achieved - timing.requested : timing.requested - timing.achieved;
+                report.maxError = std::max(report.maxError, error);
+                totalError += error;
+                report.timings.push_back(timing);
+            }
+            report.meanError = report.steps == 0 ? 0 : totalError / report.steps;
+        }
+    }
+    return report;
+}
+
+// Sets the number of requests kept in flight (values are clamped between 1 and "DEPTH_MAX")
+// Deeper queues tolerate more host latency, but steps that are due at once are then applied as fast as the device takes them
+void CP2130Waveform::setDepth(size_t depth)
+{
+    depth_ = depth < 1 ? 1 : (depth > DEPTH_MAX ? DEPTH_MAX : depth);
+}
@@ -0,0 +1,93 @@
+/* CP2130Waveform class - Version 1.0.0
+   Copyright (c) 2026 Samuel Lourenço
+
+   This library is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+   License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this library.  If not, see <https://www.gnu.org/licenses/>.
+
+
+   Please feel free to contact me via e-mail: samuel.fmlourenco@gmail.com */
+
+
+#ifndef CP2130WAVEFORM_H
+#define CP2130WAVEFORM_H
+
+// Includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libusb-1.0/libusb.h>
+#include "cp2130.h"
+
+// Waveform engine that drives GPIO pins of a CP2130 through a sequence of steps, for resets, enables and simple bit-banged protocols
+// Steps are issued as Set_GPIO_Values requests that are submitted asynchronously at their scheduled times, keeping several requests in flight, so that steps are not spaced by a full round trip each
+// Note that the timing is only as good as USB allows, which is why the achieved timing of every step is reported
+class CP2130Waveform
+{
+public:
+    struct Step {
+        uint16_t bmMask;    // Mask bitmap of the pins to set
+        uint16_t bmValues;  // GPIO values bitmap
+        uint32_t delay;     // Time in microseconds from this step to the next one
+    };
+
+    struct Timing {
+        uint64_t requested;  // Requested time of the step, in microseconds since the first step
+        uint64_t achieved;   // Time at which the device acknowledged the step, in microseconds since the first step was acknowledged
+    };
+
+    struct Report {
+        size_t steps;                 // Number of steps applied successfully, which are those before the first failure
+        uint64_t maxError;            // Largest difference between achieved and requested times, in microseconds
+        uint64_t meanError;           // Mean difference between achieved and requested times, in microseconds
+        std::vector<Timing> timings;  // Timing of every step applied
+    };
+
+private:
+    struct Slot {
+        CP2130Waveform *waveform;   // Waveform to which the transfer belongs
+        size_t step;                // Index of the step being applied
+        libusb_transfer *transfer;  // Transfer, reused between steps
+        unsigned char buffer[LIBUSB_CONTROL_SETUP_SIZE + CP2130::SET_GPIO_VALUES_WLEN];
+        bool inflight;              // True while the transfer is in flight
+    };
+
+    CP2130 &device_;
+    size_t depth_;
+    std::vector<Slot> slots_;
+    std::vector<size_t> freeSlots_;                              // Indexes of the slots that are not in flight
+    std::vector<std::chrono::steady_clock::time_point> acked_;  // Time at which each step was acknowledged
+    libusb_transfer *failedTransfer_;                            // First transfer that failed, if any
+    size_t inflight_;
+    int completed_;
+
+    static void LIBUSB_CALL callback(libusb_transfer *transfer);
+
+public:
+    static const size_t DEPTH_DEFAULT = 16;  // Default number of requests kept in flight
+    static const size_t DEPTH_MAX = 64;      // Maximum number of requests kept in flight
+
+    explicit CP2130Waveform(CP2130 &device);
+    ~CP2130Waveform();
+
+    CP2130Waveform(const CP2130Waveform &) = delete;
+    CP2130Waveform &operator =(const CP2130Waveform &) = delete;
+
+    size_t depth() const;
+
+    Report run(const std::vector<Step> &steps, int &errcnt, std::string &errstr);
+    void setDepth(size_t depth);
+};
+
+#endif  // CP2130WAVEFORM_H